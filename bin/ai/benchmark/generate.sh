@@ -0,0 +1,68 @@
+#!/bin/sh
+
+# $Id$
+
+# (Re)generates the reference savegames for ai/benchmark/run.sh. Each
+# savegame is a flat map on which one or more companies running the
+# Benchmark AI built their rail loops and started their trains; what is
+# kept is the last autosave.
+
+if ! [ -f ai/benchmark/generate.sh ]; then
+	echo "Make sure you are in the root of OpenTTD before starting this script."
+	exit 1
+fi
+
+if [ -f scripts/game_start.scr ]; then
+	mv scripts/game_start.scr scripts/game_start.scr.benchmark
+fi
+
+# Usage: generate <name> <map size, log2> <companies> <loops per company> <trains per loop>
+generate() {
+	echo "Generating ai/benchmark/$1.sav..."
+
+	cat > ai/benchmark/generate.cfg <<END
+[misc]
+language = english.lng
+
+[gui]
+autosave = monthly
+show_date_in_logs = false
+
+[difficulty]
+max_loan = 500000
+construction_cost = 0
+vehicle_costs = 0
+number_towns = 4
+industry_density = 0
+terrain_type = 0
+quantity_sea_lakes = 0
+
+[game_creation]
+map_x = $2
+map_y = $2
+custom_town_number = 1
+tree_placer = 0
+amount_of_rivers = 0
+variety = 0
+END
+
+	: > scripts/game_start.scr
+	i=0
+	while [ $i -lt $3 ]; do
+		echo "start_ai benchmark loops=$4,trains=$5" >> scripts/game_start.scr
+		i=`expr $i + 1`
+	done
+
+	./openttd -x -c ai/benchmark/generate.cfg -snull -mnull -vnull:ticks=25000 -d script=3 -G 1 -g
+	cp `ls -t save/autosave/*.sav | head -n 1` ai/benchmark/$1.sav
+}
+
+generate small 8 1 4 4
+generate medium 8 3 6 5
+generate large 9 8 6 6
+
+rm -f ai/benchmark/generate.cfg scripts/game_start.scr
+
+if [ -f scripts/game_start.scr.benchmark ]; then
+	mv scripts/game_start.scr.benchmark scripts/game_start.scr
+fi
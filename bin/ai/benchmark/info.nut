@@ -0,0 +1,18 @@
+/* $Id$ */
+
+class Benchmark extends AIInfo {
+	function GetAuthor()      { return "OpenTTD NoAI Developers Team"; }
+	function GetName()        { return "Benchmark"; }
+	function GetShortName()   { return "BNCH"; }
+	function GetDescription() { return "Builds signalled rail loops with trains on them, to create the reference savegames for benchmarking."; }
+	function GetVersion()     { return 1; }
+	function GetAPIVersion()  { return "1.7"; }
+	function GetDate()        { return "2017-01-01"; }
+	function CreateInstance() { return "Benchmark"; }
+	function GetSettings() {
+		AddSetting({name = "loops", description = "Number of rail loops to build", min_value = 1, max_value = 64, easy_value = 4, medium_value = 4, hard_value = 4, custom_value = 4, flags = 0});
+		AddSetting({name = "trains", description = "Number of trains per loop", min_value = 1, max_value = 16, easy_value = 4, medium_value = 4, hard_value = 4, custom_value = 4, flags = 0});
+	}
+}
+
+RegisterAI(Benchmark());
@@ -0,0 +1,176 @@
+/* $Id$ */
+
+/* Every loop is a rectangle of track that trains run around clockwise,
+ * with one-way signals and a station with two platforms on the far side.
+ * Even loops use block signals, odd loops path signals. Each company
+ * builds its loops in its own band of the map. */
+const LOOP_WIDTH     = 40;
+const LOOP_HEIGHT    = 16;
+const LOOP_MARGIN    = 4;
+const SIGNAL_SPACING = 4;
+const PLATFORM_LENGTH = 4;
+
+class Benchmark extends AIController {
+	built = false;
+
+	function Start();
+	function Save() { return { built = this.built }; }
+	function Load(version, data) { if ("built" in data) this.built = data.built; }
+};
+
+function Benchmark::Tile(x, y)
+{
+	return AIMap.GetTileIndex(x, y);
+}
+
+function Benchmark::Track(x, y, track)
+{
+	if (!AIRail.BuildRailTrack(Tile(x, y), track)) AILog.Error("Building track at " + x + "," + y + " failed: " + AIError.GetLastErrorString());
+}
+
+function Benchmark::Signal(x, y, dx, dy, type)
+{
+	if (!AIRail.BuildSignal(Tile(x, y), Tile(x + dx, y + dy), type)) AILog.Error("Building signal at " + x + "," + y + " failed: " + AIError.GetLastErrorString());
+}
+
+/* Whether a tile can be built on without changing the land. */
+function Benchmark::IsFlat(x, y)
+{
+	local tile = Tile(x, y);
+	return AITile.IsBuildable(tile) && !AITile.IsCoastTile(tile) && AITile.GetSlope(tile) == AITile.SLOPE_FLAT;
+}
+
+/* Whether the track of a loop and the area for its depot and station are
+ * free; the latter are levelled when building. */
+function Benchmark::IsFree(x0, y0)
+{
+	local x1 = x0 + LOOP_WIDTH - 1;
+	local y1 = y0 + LOOP_HEIGHT - 1;
+	for (local x = x0; x <= x1; x++) {
+		if (!IsFlat(x, y0) || !IsFlat(x, y1)) return false;
+		if (!AITile.IsBuildable(Tile(x, y0 - 1)) || !AITile.IsBuildable(Tile(x, y1 + 1))) return false;
+	}
+	for (local y = y0; y <= y1; y++) {
+		if (!IsFlat(x0, y) || !IsFlat(x1, y)) return false;
+	}
+	return true;
+}
+
+function Benchmark::BuildLoop(n, x0, y0)
+{
+	local x1 = x0 + LOOP_WIDTH - 1;
+	local y1 = y0 + LOOP_HEIGHT - 1;
+	local type = (n % 2) == 1 ? AIRail.SIGNALTYPE_PBS_ONEWAY : AIRail.SIGNALTYPE_NORMAL;
+	local sx = x0 + LOOP_WIDTH / 2;
+
+	/* The station and depot need flat land. */
+	AITile.LevelTiles(Tile(sx - 2, y1 - 1), Tile(sx + PLATFORM_LENGTH + 2, y1 + 2));
+	AITile.LevelTiles(Tile(x0 + 1, y0 - 2), Tile(x0 + 4, y0 + 1));
+
+	if (!AIRail.BuildRailStation(Tile(sx, y1), AIRail.RAILTRACK_NE_SW, 2, PLATFORM_LENGTH, AIStation.STATION_NEW)) {
+		AILog.Error("Building station at " + sx + "," + y1 + " failed: " + AIError.GetLastErrorString());
+	}
+	local depot = Tile(x0 + 2, y0 - 1);
+	if (!AIRail.BuildRailDepot(depot, Tile(x0 + 2, y0))) {
+		AILog.Error("Building depot at " + (x0 + 2) + "," + (y0 - 1) + " failed: " + AIError.GetLastErrorString());
+	}
+
+	/* Straight parts and corners. */
+	for (local x = x0 + 1; x < x1; x++) {
+		this.Track(x, y0, AIRail.RAILTRACK_NE_SW);
+		if (x < sx || x >= sx + PLATFORM_LENGTH) this.Track(x, y1, AIRail.RAILTRACK_NE_SW);
+	}
+	for (local y = y0 + 1; y < y1; y++) {
+		this.Track(x0, y, AIRail.RAILTRACK_NW_SE);
+		this.Track(x1, y, AIRail.RAILTRACK_NW_SE);
+	}
+	this.Track(x0, y0, AIRail.RAILTRACK_SW_SE);
+	this.Track(x1, y0, AIRail.RAILTRACK_NE_SE);
+	this.Track(x1, y1, AIRail.RAILTRACK_NW_NE);
+	this.Track(x0, y1, AIRail.RAILTRACK_NW_SW);
+
+	/* Switches to and from the second platform, and the depot exit. */
+	this.Track(sx + PLATFORM_LENGTH, y1, AIRail.RAILTRACK_SW_SE);
+	this.Track(sx + PLATFORM_LENGTH, y1 + 1, AIRail.RAILTRACK_NW_NE);
+	this.Track(sx - 1, y1 + 1, AIRail.RAILTRACK_NW_SW);
+	this.Track(sx - 1, y1, AIRail.RAILTRACK_NE_SE);
+	this.Track(x0 + 2, y0, AIRail.RAILTRACK_NW_SW);
+
+	/* One-way signals in the direction of travel; trains go towards +x on
+	 * the near side, -x on the far side, +y on the right and -y on the left. */
+	for (local x = x0 + 4; x < x1 - 1; x += SIGNAL_SPACING) {
+		this.Signal(x, y0, 1, 0, type);
+		if (x < sx - 2 || x > sx + PLATFORM_LENGTH + 1) this.Signal(x, y1, -1, 0, type);
+	}
+	for (local y = y0 + 2; y < y1 - 1; y += SIGNAL_SPACING) {
+		this.Signal(x1, y, 0, 1, type);
+		this.Signal(x0, y, 0, -1, type);
+	}
+	this.Signal(sx + PLATFORM_LENGTH + 1, y1, -1, 0, type);
+	this.Signal(sx - 2, y1, -1, 0, type);
+
+	return { depot = depot, station = Tile(sx, y1) };
+}
+
+function Benchmark::FindEngine()
+{
+	local list = AIEngineList(AIVehicle.VT_RAIL);
+	list.Valuate(AIEngine.IsWagon);
+	list.KeepValue(0);
+	list.Valuate(AIEngine.CanRunOnRail, AIRail.GetCurrentRailType());
+	list.KeepValue(1);
+	list.Valuate(AIEngine.GetPrice);
+	list.Sort(AIList.SORT_BY_VALUE, true);
+	return list.Begin();
+}
+
+function Benchmark::Build()
+{
+	AICompany.SetLoanAmount(AICompany.GetMaxLoanAmount());
+	AIRail.SetCurrentRailType(AIRailTypeList().Begin());
+
+	local loops = GetSetting("loops");
+	local trains = GetSetting("trains");
+	local engine = this.FindEngine();
+
+	/* Place the loops in a grid within the band of this company, with
+	 * spare rows for places that are not clear. */
+	local per_row = (AIMap.GetMapSizeX() - LOOP_MARGIN) / (LOOP_WIDTH + LOOP_MARGIN);
+	local rows = (loops + per_row - 1) / per_row + 2;
+	local band = AICompany.ResolveCompanyID(AICompany.COMPANY_SELF) * rows;
+
+	local built = [];
+	for (local row = band; row < band + rows && built.len() < loops; row++) {
+		local y = LOOP_MARGIN + row * (LOOP_HEIGHT + LOOP_MARGIN);
+		if (y + LOOP_HEIGHT + LOOP_MARGIN >= AIMap.GetMapSizeY()) break;
+
+		for (local x = LOOP_MARGIN; x + LOOP_WIDTH + LOOP_MARGIN < AIMap.GetMapSizeX() && built.len() < loops; x += LOOP_WIDTH + LOOP_MARGIN) {
+			if (this.IsFree(x, y)) built.append(this.BuildLoop(built.len(), x, y));
+		}
+	}
+
+	/* Release the trains one by one on every loop, so they spread out. */
+	for (local t = 0; t < trains; t++) {
+		foreach (loop in built) {
+			local v = AIVehicle.BuildVehicle(loop.depot, engine);
+			if (!AIVehicle.IsValidVehicle(v)) {
+				AILog.Error("Building train failed: " + AIError.GetLastErrorString());
+				continue;
+			}
+			AIOrder.AppendOrder(v, loop.station, AIOrder.OF_NON_STOP_INTERMEDIATE);
+			AIVehicle.StartStopVehicle(v);
+		}
+		this.Sleep(150);
+	}
+
+	AILog.Warning("Built " + built.len() + " loops with " + trains + " trains each");
+	this.built = true;
+}
+
+function Benchmark::Start()
+{
+	if (!this.built) this.Build();
+
+	/* Leave the network alone; this is also what happens when a benchmark loads the savegame. */
+	while (true) this.Sleep(1000);
+}
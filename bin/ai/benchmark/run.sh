@@ -0,0 +1,54 @@
+#!/bin/sh
+
+# $Id$
+
+# Runs the reference savegames with the null drivers and prints how much
+# time the train controller, signal updates, YAPF and path reservations
+# took, as comma separated values with the savegame as first column.
+#
+# Usage: sh ai/benchmark/run.sh [ticks] [savegame...]
+
+if ! [ -f ai/benchmark/run.sh ]; then
+	echo "Make sure you are in the root of OpenTTD before starting this script."
+	exit 1
+fi
+
+ticks=3000
+if [ -n "$1" ]; then
+	ticks=$1
+	shift
+fi
+
+saves="$*"
+if [ -z "$saves" ]; then
+	saves=`ls ai/benchmark/*.sav`
+fi
+
+if [ -f scripts/game_start.scr ]; then
+	mv scripts/game_start.scr scripts/game_start.scr.benchmark
+fi
+
+ret=0
+header=1
+for sav in $saves; do
+	name=`basename $sav .sav`
+	./openttd -x -c ai/benchmark/benchmark.cfg -snull -mnull -vnull:ticks=$ticks,benchmark -g $sav 2>/dev/null > tmp.benchmark
+	if [ $? -ne 0 ] || [ ! -s tmp.benchmark ]; then
+		echo "Running $sav failed." >&2
+		ret=1
+		continue
+	fi
+
+	if [ $header -eq 1 ]; then
+		echo "savegame,`head -n 1 tmp.benchmark`"
+		header=0
+	fi
+	tail -n +2 tmp.benchmark | sed "s/^/$name,/"
+done
+rm -f tmp.benchmark
+
+if [ -f scripts/game_start.scr.benchmark ]; then
+	mv scripts/game_start.scr.benchmark scripts/game_start.scr
+fi
+
+exit $ret
@@ -0,0 +1,260 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file benchmark.cpp Measuring the time spent in parts of the game, for benchmarking. */
+
+#include "stdafx.h"
+#include "benchmark.h"
+#include "blitter/factory.hpp"
+#include "console_func.h"
+#include "settings_type.h"
+#include "core/alloc_func.hpp"
+#include "core/random_func.hpp"
+
+#include "safeguards.h"
+
+bool _benchmark_enabled = false;                         ///< Whether the benchmark timers are measuring.
+BenchmarkMeasurement _benchmark_measurements[BE_END];    ///< The measurements of the running or last benchmark.
+
+/** Names of the measured parts of the game, as used in the output. */
+static const char * const _benchmark_element_names[] = {
+	"gameloop",
+	"train_controller",
+	"signals",
+	"yapf",
+	"pbs",
+	"genworld",
+	"genworld_terrain",
+	"genworld_tropic_zone",
+	"genworld_rivers",
+	"genworld_towns",
+	"genworld_industries",
+	"genworld_trees",
+	"genworld_tileloop",
+};
+assert_compile(lengthof(_benchmark_element_names) == BE_END);
+
+/** Reset all measurements and start measuring. */
+void StartBenchmark()
+{
+	memset(_benchmark_measurements, 0, sizeof(_benchmark_measurements));
+	_benchmark_enabled = true;
+}
+
+/** Stop measuring; the measurements are kept. */
+void StopBenchmark()
+{
+	_benchmark_enabled = false;
+}
+
+/**
+ * Write the measurements to the standard output as comma separated values,
+ * one line per part of the game after a header line. Times of nested parts
+ * are included in the time of the part they are called from, e.g. path
+ * finding is part of the train controller as well.
+ * @param ticks The number of ticks the benchmark ran.
+ */
+void PrintBenchmark(uint ticks)
+{
+	printf("element,calls,cycles,cycles_per_tick\n");
+	for (uint i = 0; i < BE_END; i++) {
+		const BenchmarkMeasurement &m = _benchmark_measurements[i];
+		uint64 per_tick = ticks == 0 ? 0 : m.cycles / ticks;
+		printf("%s," OTTD_PRINTF64 "," OTTD_PRINTF64 "," OTTD_PRINTF64 "\n", _benchmark_element_names[i], (int64)m.calls, (int64)m.cycles, (int64)per_tick);
+	}
+	fflush(stdout);
+}
+
+/** The blitters that are measured when none are given explicitly. */
+static const char * const _benchmark_default_blitters[] = {
+	"8bpp-optimized",
+	"32bpp-optimized",
+	"32bpp-sse2",
+	"32bpp-ssse3",
+	"32bpp-sse4",
+	"32bpp-avx2",
+};
+
+/** A way of drawing a sprite that is measured for every blitter. */
+struct BlitterBenchmarkCase {
+	const char *name;  ///< Name in the output.
+	BlitterMode mode;  ///< The mode to draw with.
+	bool translucent;  ///< Whether to draw the sprite with semi-transparent pixels.
+};
+
+/** All the ways of drawing that are measured for every blitter. */
+static const BlitterBenchmarkCase _blitter_benchmark_cases[] = {
+	{ "normal",      BM_NORMAL,       false },
+	{ "translucent", BM_NORMAL,       true  },
+	{ "remap",       BM_COLOUR_REMAP, true  },
+	{ "transparent", BM_TRANSPARENT,  true  },
+	{ "crash",       BM_CRASH_REMAP,  true  },
+	{ "black",       BM_BLACK_REMAP,  true  },
+};
+
+static const uint BLITTER_BENCHMARK_SPRITE_WIDTH  = 61;  ///< Width of the benchmark sprite at normal zoom; odd, to have lines that are not a multiple of the vector width.
+static const uint BLITTER_BENCHMARK_SPRITE_HEIGHT = 31;  ///< Height of the benchmark sprite at normal zoom.
+static const uint BLITTER_BENCHMARK_BUFFER_WIDTH  = 128; ///< Width of the buffer drawn to.
+static const uint BLITTER_BENCHMARK_OFFSETS       = 16;  ///< Number of different horizontal positions the sprite is drawn at.
+
+/**
+ * Allocate memory for an encoded benchmark sprite.
+ * @param size The number of bytes to allocate.
+ * @return The allocated memory.
+ */
+static void *BlitterBenchmarkAllocate(size_t size)
+{
+	return MallocT<byte>(size);
+}
+
+/**
+ * Make a sprite resembling the sprites of the game, at all zoom levels: an
+ * ellipse with some holes, partly with remappable pixels.
+ * @param[out] sprite The sprite to fill; free its data with FreeBlitterBenchmarkSprite().
+ * @param translucent Whether to make some pixels semi-transparent.
+ */
+static void MakeBlitterBenchmarkSprite(SpriteLoader::Sprite *sprite, bool translucent)
+{
+	/* Always the same sprite, so the results of different runs are comparable. */
+	Randomizer r;
+	r.SetSeed(translucent ? 2 : 1);
+
+	for (ZoomLevel z = ZOOM_LVL_NORMAL; z < ZOOM_LVL_END; z++) {
+		SpriteLoader::Sprite &s = sprite[z];
+		s.width = max(1U, BLITTER_BENCHMARK_SPRITE_WIDTH >> z);
+		s.height = max(1U, BLITTER_BENCHMARK_SPRITE_HEIGHT >> z);
+		s.x_offs = 0;
+		s.y_offs = 0;
+		s.type = ST_NORMAL;
+		s.data = CallocT<SpriteLoader::CommonPixel>(s.width * s.height);
+
+		SpriteLoader::CommonPixel *p = s.data;
+		for (int y = 0; y < s.height; y++) {
+			for (int x = 0; x < s.width; x++, p++) {
+				int dx = 2 * x - s.width + 1;
+				int dy = 2 * y - s.height + 1;
+				if (dx * dx * s.height * s.height + dy * dy * s.width * s.width > s.width * s.width * s.height * s.height) continue;
+				if (r.Next(8) == 0) continue;
+
+				p->r = r.Next(256);
+				p->g = r.Next(256);
+				p->b = r.Next(256);
+				p->a = (translucent && r.Next(4) == 0) ? 1 + r.Next(254) : 255;
+				if (r.Next(3) == 0) p->m = 0xC6 + r.Next(8);
+			}
+		}
+	}
+}
+
+/**
+ * Free the data of a sprite made by MakeBlitterBenchmarkSprite().
+ * @param sprite The sprite.
+ */
+static void FreeBlitterBenchmarkSprite(SpriteLoader::Sprite *sprite)
+{
+	for (ZoomLevel z = ZOOM_LVL_NORMAL; z < ZOOM_LVL_END; z++) free(sprite[z].data);
+}
+
+/**
+ * Measure how fast blitters draw sprites in all blitter modes and print the
+ * results to the console. The blitters are not activated; they only draw to
+ * a buffer of their own. Next to the time, a checksum of the drawn pixels is
+ * printed so blitters with the same sprite format can be checked to draw the same.
+ * @param names The names of the blitters, or \c NULL for all vectorised blitters and their plain counterparts.
+ * @param count The number of names.
+ * @param iterations How often every sprite is drawn at each of the positions.
+ */
+void BenchmarkBlitters(const char * const *names, uint count, uint iterations)
+{
+	if (names == NULL) {
+		names = _benchmark_default_blitters;
+		count = lengthof(_benchmark_default_blitters);
+	}
+
+	SpriteLoader::Sprite sprites[2][ZOOM_LVL_COUNT];
+	MakeBlitterBenchmarkSprite(sprites[0], false);
+	MakeBlitterBenchmarkSprite(sprites[1], true);
+
+	ZoomLevel zoom = (ZoomLevel)Clamp(ZOOM_LVL_NORMAL, _settings_client.gui.zoom_min, _settings_client.gui.zoom_max);
+	const uint height = sprites[0][zoom].height;
+
+	/* Remap everything to other colours; the remap of the last colours is 0, i.e. they are not drawn. */
+	byte remap[256];
+	for (uint i = 0; i < lengthof(remap); i++) remap[i] = (i + 8) & 0xFF;
+
+	uint32 *buffer = MallocT<uint32>(BLITTER_BENCHMARK_BUFFER_WIDTH * height);
+
+	IConsolePrintF(CC_DEFAULT, "Drawing %ux%u sprites %u times at %u positions:", sprites[0][zoom].width, height, iterations, BLITTER_BENCHMARK_OFFSETS);
+	for (uint i = 0; i < count; i++) {
+		BlitterFactory *factory = BlitterFactory::GetBlitterFactory(names[i]);
+		if (factory == NULL) {
+			IConsolePrintF(CC_WARNING, "%s: not available", names[i]);
+			continue;
+		}
+
+		Blitter *blitter = factory->CreateInstance();
+		if (blitter->UsePaletteAnimation() == Blitter::PALETTE_ANIMATION_BLITTER) {
+			/* These draw to the animation buffer of the screen as well. */
+			IConsolePrintF(CC_WARNING, "%s: cannot be measured as it animates the palette itself", names[i]);
+			delete blitter;
+			continue;
+		}
+
+		Sprite *encoded[2];
+		for (uint s = 0; s < lengthof(encoded); s++) encoded[s] = blitter->Encode(sprites[s], &BlitterBenchmarkAllocate);
+
+		for (uint c = 0; c < lengthof(_blitter_benchmark_cases); c++) {
+			const BlitterBenchmarkCase &bc = _blitter_benchmark_cases[c];
+			const SpriteLoader::Sprite &src = sprites[bc.translucent ? 1 : 0][zoom];
+
+			Blitter::BlitterParams bp;
+			bp.sprite = encoded[bc.translucent ? 1 : 0]->data;
+			bp.remap = remap;
+			bp.skip_left = 0;
+			bp.skip_top = 0;
+			bp.width = src.width;
+			bp.height = src.height;
+			bp.sprite_width = src.width;
+			bp.sprite_height = src.height;
+			bp.top = 0;
+			bp.dst = buffer;
+			bp.pitch = BLITTER_BENCHMARK_BUFFER_WIDTH;
+
+			/* Draw once at every position on the same background, so the checksum only depends on the drawing itself.
+			 * The alpha channel of the screen is not used, and the blitters do not agree on what they leave in it. */
+			const uint32 checksum_mask = blitter->GetScreenDepth() == 32 ? 0x00FFFFFF : 0xFFFFFFFF;
+			uint32 checksum = 0;
+			for (uint offset = 0; offset < BLITTER_BENCHMARK_OFFSETS; offset++) {
+				for (uint p = 0; p < BLITTER_BENCHMARK_BUFFER_WIDTH * height; p++) buffer[p] = 0xFF000000 | (p * 0x9E3779B1);
+				bp.left = offset;
+				blitter->Draw(&bp, bc.mode, zoom);
+				for (uint p = 0; p < BLITTER_BENCHMARK_BUFFER_WIDTH * height; p++) checksum = (checksum << 5 | checksum >> 27) ^ (buffer[p] & checksum_mask);
+			}
+
+			uint64 start = ottd_rdtsc();
+			for (uint n = 0; n < iterations; n++) {
+				for (uint offset = 0; offset < BLITTER_BENCHMARK_OFFSETS; offset++) {
+					bp.left = offset;
+					blitter->Draw(&bp, bc.mode, zoom);
+				}
+			}
+			uint64 cycles = ottd_rdtsc() - start;
+
+			IConsolePrintF(CC_DEFAULT, "%-16s %-12s %10u cycles per sprite, checksum %08X", blitter->GetName(), bc.name,
+					(uint)(cycles / max(1U, iterations * BLITTER_BENCHMARK_OFFSETS)), checksum);
+		}
+
+		for (uint s = 0; s < lengthof(encoded); s++) free(encoded[s]);
+		delete blitter;
+	}
+
+	free(buffer);
+	FreeBlitterBenchmarkSprite(sprites[0]);
+	FreeBlitterBenchmarkSprite(sprites[1]);
+}
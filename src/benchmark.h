@@ -0,0 +1,85 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file benchmark.h Measuring the time spent in parts of the game, for benchmarking. */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "cpu.h"
+
+/** The parts of the game whose time is measured. */
+enum BenchmarkElement {
+	BE_GAMELOOP,         ///< The whole game loop, for reference.
+	BE_TRAIN_CONTROLLER, ///< Moving trains over their tracks.
+	BE_SIGNALS,          ///< Updating the signals of changed signal blocks.
+	BE_YAPF,             ///< Path finding for trains with YAPF.
+	BE_PBS,              ///< Reserving, following and freeing train paths.
+	BE_GENWORLD,             ///< Generating the whole world.
+	BE_GENWORLD_TERRAIN,     ///< Generating the terrain, including the sea.
+	BE_GENWORLD_TROPIC_ZONE, ///< Dividing the map in desert and rainforest.
+	BE_GENWORLD_RIVERS,      ///< Generating rivers and lakes.
+	BE_GENWORLD_TOWNS,       ///< Generating towns.
+	BE_GENWORLD_INDUSTRIES,  ///< Generating industries.
+	BE_GENWORLD_TREES,       ///< Planting trees.
+	BE_GENWORLD_TILELOOP,    ///< Running the tile loop after generating the world.
+	BE_END,              ///< End marker.
+};
+
+/** Time spent in a single part of the game. */
+struct BenchmarkMeasurement {
+	uint64 cycles; ///< CPU cycles spent, including the time of nested parts.
+	uint64 calls;  ///< Number of times the part was entered from outside itself.
+	uint depth;    ///< How deep we are currently nested in this part.
+};
+
+extern bool _benchmark_enabled;
+extern BenchmarkMeasurement _benchmark_measurements[BE_END];
+
+/**
+ * Measure the time until the end of the scope in which the timer lives.
+ * Only the outermost timer of an element counts, so recursion and
+ * multiple entry points calling each other are not counted twice.
+ */
+class BenchmarkTimer {
+	BenchmarkElement element; ///< The measured part of the game.
+	bool active;              ///< Whether benchmarking was enabled when entering.
+	uint64 start;             ///< Cycle count at the start of the outermost timer.
+
+public:
+	/**
+	 * Start measuring.
+	 * @param element The part of the game that is entered.
+	 */
+	inline BenchmarkTimer(BenchmarkElement element) : element(element), active(_benchmark_enabled), start(0)
+	{
+		if (!this->active) return;
+		if (_benchmark_measurements[element].depth++ == 0) this->start = ottd_rdtsc();
+	}
+
+	/** Stop measuring and account the time. */
+	inline ~BenchmarkTimer()
+	{
+		if (!this->active) return;
+
+		BenchmarkMeasurement &m = _benchmark_measurements[this->element];
+		if (--m.depth == 0) {
+			m.cycles += ottd_rdtsc() - this->start;
+			m.calls++;
+		}
+	}
+};
+
+void StartBenchmark();
+void StopBenchmark();
+void PrintBenchmark(uint ticks);
+
+void BenchmarkBlitters(const char * const *names, uint count, uint iterations);
+
+#endif /* BENCHMARK_H */
@@ -11,6 +11,7 @@
 
 #include "../stdafx.h"
 #include "../video/video_driver.hpp"
+#include "../core/mem_func.hpp"
 #include "32bpp_anim.hpp"
 
 #include "../table/sprites.h"
@@ -23,6 +24,7 @@ static FBlitter_32bppAnim iFBlitter_32bppAnim;
 Blitter_32bppAnim::~Blitter_32bppAnim()
 {
 	free(this->anim_buf);
+	free(this->anim_blocks);
 }
 
 template <BlitterMode mode>
@@ -260,6 +262,11 @@ void Blitter_32bppAnim::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomL
 		return;
 	}
 
+	/* Only these modes can draw pixels with animated colours. */
+	if (mode == BM_NORMAL || mode == BM_COLOUR_REMAP || mode == BM_CRASH_REMAP) {
+		this->MarkAnimationBlocks((uint32 *)bp->dst + bp->top * bp->pitch + bp->left, bp->width, bp->height);
+	}
+
 	switch (mode) {
 		default: NOT_REACHED();
 		case BM_NORMAL:       Draw<BM_NORMAL>      (bp, zoom); return;
@@ -320,6 +327,7 @@ void Blitter_32bppAnim::SetPixel(void *video, int x, int y, uint8 colour)
 	/* Set the colour in the anim-buffer too, if we are rendering to the screen */
 	if (_screen_disable_anim) return;
 	this->anim_buf[((uint32 *)video - (uint32 *)_screen.dst_ptr) + x + y * this->anim_buf_width] = colour | (DEFAULT_BRIGHTNESS << 8);
+	if (colour >= PALETTE_ANIM_START) this->MarkAnimationBlocks((uint32 *)video + x + y * _screen.pitch, 1, 1);
 }
 
 void Blitter_32bppAnim::DrawRect(void *video, int width, int height, uint8 colour)
@@ -333,6 +341,7 @@ void Blitter_32bppAnim::DrawRect(void *video, int width, int height, uint8 colou
 	Colour colour32 = LookupColourInPalette(colour);
 	uint16 *anim_line;
 
+	if (colour >= PALETTE_ANIM_START) this->MarkAnimationBlocks(video, width, height);
 	anim_line = ((uint32 *)video - (uint32 *)_screen.dst_ptr) + this->anim_buf;
 
 	do {
@@ -359,6 +368,7 @@ void Blitter_32bppAnim::CopyFromBuffer(void *video, const void *src, int width,
 	const uint32 *usrc = (const uint32 *)src;
 	uint16 *anim_line = ((uint32 *)video - (uint32 *)_screen.dst_ptr) + this->anim_buf;
 
+	this->MarkAnimationBlocks(video, width, height);
 	for (; height > 0; height--) {
 		/* We need to keep those for palette animation. */
 		Colour *dst_pal = dst;
@@ -420,6 +430,9 @@ void Blitter_32bppAnim::ScrollBuffer(void *video, int &left, int &top, int &widt
 	assert(video >= _screen.dst_ptr && video <= (uint32 *)_screen.dst_ptr + _screen.width + _screen.height * _screen.pitch);
 	uint16 *dst, *src;
 
+	/* Pixels with animated colours can end up anywhere in the scrolled area. */
+	this->MarkAnimationBlocks((uint32 *)video + left + top * _screen.pitch, width, height);
+
 	/* We need to scroll the anim-buffer too */
 	if (scroll_y > 0) {
 		dst = this->anim_buf + left + (top + height - 1) * this->anim_buf_width;
@@ -470,6 +483,77 @@ int Blitter_32bppAnim::BufferSize(int width, int height)
 	return width * height * (sizeof(uint32) + sizeof(uint16));
 }
 
+/**
+ * Remember that an area of the screen might contain pixels with animated
+ * colours, so palette animation looks at the blocks of that area again.
+ * @param video  The top left pixel of the area on the screen.
+ * @param width  The width of the area.
+ * @param height The height of the area.
+ */
+void Blitter_32bppAnim::MarkAnimationBlocks(const void *video, int width, int height)
+{
+	if (_screen_disable_anim || this->anim_blocks == NULL) return;
+
+	ptrdiff_t offset = (const uint32 *)video - (const uint32 *)_screen.dst_ptr;
+	if (offset < 0) return;
+
+	int left = offset % _screen.pitch;
+	int top = offset / _screen.pitch;
+	int right = min(left + width, this->anim_buf_width);
+	int bottom = min(top + height, this->anim_buf_height);
+	if (left >= right || top >= bottom) return;
+
+	int first = left / ANIM_BLOCK_WIDTH;
+	int last = (right - 1) / ANIM_BLOCK_WIDTH;
+	for (int y = top / ANIM_BLOCK_HEIGHT; y <= (bottom - 1) / ANIM_BLOCK_HEIGHT; y++) {
+		MemSetT(this->anim_blocks + y * this->anim_blocks_width + first, true, last - first + 1);
+	}
+}
+
+/**
+ * Update the pixels with animated colours in a block of the screen to the current palette.
+ * @param left   The left of the block.
+ * @param top    The top of the block.
+ * @param width  The width of the block.
+ * @param height The height of the block.
+ * @return Whether the block contains any pixels with animated colours.
+ */
+bool Blitter_32bppAnim::PaletteAnimateBlock(int left, int top, int width, int height)
+{
+	/* Look at four pixels at once. Adding this to the colour of every pixel
+	 * carries into the lowest bit of its brightness only for the animated
+	 * colours; the brightness itself is masked away first. */
+	static const uint64 COLOUR_MASK = 0x00FF00FF00FF00FFULL;
+	static const uint64 ANIM_CARRY  = (256 - PALETTE_ANIM_START) * 0x0001000100010001ULL;
+	static const uint64 CARRY_BITS  = 0x0100010001000100ULL;
+
+	bool animated = false;
+	for (int y = top; y < top + height; y++) {
+		const uint16 *anim = this->anim_buf + y * this->anim_buf_width + left;
+		Colour *dst = (Colour *)_screen.dst_ptr + y * _screen.pitch + left;
+
+		for (int x = 0; x < width; x += 4) {
+			int n = min(4, width - x);
+			if (n == 4) {
+				uint64 pixels;
+				memcpy(&pixels, anim + x, sizeof(pixels));
+				if ((((pixels & COLOUR_MASK) + ANIM_CARRY) & CARRY_BITS) == 0) continue;
+			}
+
+			for (int i = x; i < x + n; i++) {
+				uint colour = GB(anim[i], 0, 8);
+				if (colour >= PALETTE_ANIM_START) {
+					/* Update this pixel */
+					dst[i] = this->AdjustBrightness(LookupColourInPalette(colour), GB(anim[i], 8, 8));
+					animated = true;
+				}
+			}
+		}
+	}
+
+	return animated;
+}
+
 void Blitter_32bppAnim::PaletteAnimate(const Palette &palette)
 {
 	assert(!_screen_disable_anim);
@@ -480,25 +564,30 @@ void Blitter_32bppAnim::PaletteAnimate(const Palette &palette)
 	 *  Especially when going between toyland and non-toyland. */
 	assert(this->palette.first_dirty == PALETTE_ANIM_START || this->palette.first_dirty == 0);
 
-	const uint16 *anim = this->anim_buf;
-	Colour *dst = (Colour *)_screen.dst_ptr;
+	/* Only walk the blocks that might contain animated pixels, and let the
+	 * backend redraw the runs of blocks in a row that really do. */
+	for (int by = 0; by < this->anim_blocks_height; by++) {
+		bool *blocks = this->anim_blocks + by * this->anim_blocks_width;
+		int top = by * ANIM_BLOCK_HEIGHT;
+		int height = min(ANIM_BLOCK_HEIGHT, this->anim_buf_height - top);
+		int dirty_left = -1;
+
+		for (int bx = 0; bx <= this->anim_blocks_width; bx++) {
+			int left = bx * ANIM_BLOCK_WIDTH;
+			if (bx < this->anim_blocks_width && blocks[bx]) {
+				blocks[bx] = this->PaletteAnimateBlock(left, top, min(ANIM_BLOCK_WIDTH, this->anim_buf_width - left), height);
+				if (blocks[bx]) {
+					if (dirty_left < 0) dirty_left = left;
+					continue;
+				}
+			}
 
-	/* Let's walk the anim buffer and try to find the pixels */
-	for (int y = this->anim_buf_height; y != 0 ; y--) {
-		for (int x = this->anim_buf_width; x != 0 ; x--) {
-			uint colour = GB(*anim, 0, 8);
-			if (colour >= PALETTE_ANIM_START) {
-				/* Update this pixel */
-				*dst = this->AdjustBrightness(LookupColourInPalette(colour), GB(*anim, 8, 8));
+			if (dirty_left >= 0) {
+				VideoDriver::GetInstance()->MakeDirty(dirty_left, top, min(left, this->anim_buf_width) - dirty_left, height);
+				dirty_left = -1;
 			}
-			dst++;
-			anim++;
 		}
-		dst += _screen.pitch - this->anim_buf_width;
 	}
-
-	/* Make sure the backend redraws the whole screen */
-	VideoDriver::GetInstance()->MakeDirty(0, 0, _screen.width, _screen.height);
 }
 
 Blitter::PaletteAnimation Blitter_32bppAnim::UsePaletteAnimation()
@@ -514,5 +603,10 @@ void Blitter_32bppAnim::PostResize()
 		this->anim_buf = CallocT<uint16>(_screen.width * _screen.height);
 		this->anim_buf_width = _screen.width;
 		this->anim_buf_height = _screen.height;
+
+		free(this->anim_blocks);
+		this->anim_blocks_width = CeilDiv(_screen.width, ANIM_BLOCK_WIDTH);
+		this->anim_blocks_height = CeilDiv(_screen.height, ANIM_BLOCK_HEIGHT);
+		this->anim_blocks = CallocT<bool>(this->anim_blocks_width * this->anim_blocks_height);
 	}
 }
@@ -22,11 +22,24 @@ protected:
 	int anim_buf_height; ///< The height of the animation buffer.
 	Palette palette;     ///< The current palette.
 
+	static const int ANIM_BLOCK_WIDTH = 64; ///< Width of the blocks the screen is divided in for palette animation; the same as the dirty blocks.
+	static const int ANIM_BLOCK_HEIGHT = 8; ///< Height of the blocks the screen is divided in for palette animation; the same as the dirty blocks.
+
+	bool *anim_blocks;      ///< For every block of the screen, whether it might contain pixels with animated colours.
+	int anim_blocks_width;  ///< The number of blocks in a row of #anim_blocks.
+	int anim_blocks_height; ///< The number of rows of #anim_blocks.
+
+	void MarkAnimationBlocks(const void *video, int width, int height);
+	bool PaletteAnimateBlock(int left, int top, int width, int height);
+
 public:
 	Blitter_32bppAnim() :
 		anim_buf(NULL),
 		anim_buf_width(0),
-		anim_buf_height(0)
+		anim_buf_height(0),
+		anim_blocks(NULL),
+		anim_blocks_width(0),
+		anim_blocks_height(0)
 	{}
 
 	~Blitter_32bppAnim();
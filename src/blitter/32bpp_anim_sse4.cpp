@@ -368,6 +368,12 @@ IGNORE_UNINITIALIZED_WARNING_STOP
 void Blitter_32bppSSE4_Anim::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
 {
 	const Blitter_32bppSSE_Base::SpriteFlags sprite_flags = ((const Blitter_32bppSSE_Base::SpriteData *) bp->sprite)->flags;
+
+	/* Only these modes can draw pixels with animated colours; without remapping only sprites that have them. */
+	if (mode == BM_COLOUR_REMAP || mode == BM_CRASH_REMAP || (mode == BM_NORMAL && !(sprite_flags & SF_NO_ANIM))) {
+		this->MarkAnimationBlocks((uint32 *)bp->dst + bp->top * bp->pitch + bp->left, bp->width, bp->height);
+	}
+
 	switch (mode) {
 		default: {
 bm_normal:
@@ -0,0 +1,386 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_avx2.cpp Implementation of the AVX2 32 bpp blitter. */
+
+#ifdef WITH_AVX2
+
+#include "../stdafx.h"
+#include "../zoom_func.h"
+#include "../settings_type.h"
+#include "32bpp_avx2.hpp"
+/* Only take the helpers for the last pixels of a line; the Draw of the SSE4 blitter lives in its own file. */
+#define SSE_FUNC_NO_DRAW
+#include "32bpp_sse_func.hpp"
+#include <immintrin.h>
+
+#include "../safeguards.h"
+
+/** Instantiation of the AVX2 32bpp blitter factory. */
+static FBlitter_32bppAVX2 iFBlitter_32bppAVX2;
+
+/**
+ * Pack the colours of four pixels, each lane holding two pixels with uint16 per channel, into four uint32.
+ * @param from The four pixels.
+ * @param pack_mask Mask to take the low byte of each channel, per lane.
+ * @return The packed pixels.
+ */
+static inline __m128i PackFourPixels(__m256i from, const __m256i &pack_mask)
+{
+	from = _mm256_shuffle_epi8(from, pack_mask);                    // VPSHUFB, pack two colours per lane
+	return _mm256_castsi256_si128(_mm256_permute4x64_epi64(from, 0x08)); // VPERMQ, put the low halves of both lanes together
+}
+
+/**
+ * Alpha blend four pixels; the same calculation as AlphaBlendTwoPixels(), but in both lanes of a 256 bit register.
+ * @param src The source pixels.
+ * @param dst The destination pixels.
+ * @param distribution_mask ALPHA_CONTROL_MASK in both lanes.
+ * @param pack_mask PACK_LOW_CONTROL_MASK in both lanes.
+ * @return The blended pixels.
+ */
+static inline __m128i AlphaBlendFourPixels(__m128i src, __m128i dst, const __m256i &distribution_mask, const __m256i &pack_mask)
+{
+	__m256i srcABCD = _mm256_cvtepu8_epi16(src);                           // VPMOVZXBW, expand each uint8 into uint16
+	__m256i dstABCD = _mm256_cvtepu8_epi16(dst);
+
+	__m256i alphaABCD = _mm256_cmpgt_epi16(srcABCD, _mm256_setzero_si256()); // VPCMPGTW, if (alpha > 0) a++;
+	alphaABCD = _mm256_srli_epi16(alphaABCD, 15);
+	alphaABCD = _mm256_add_epi16(alphaABCD, srcABCD);
+	alphaABCD = _mm256_shuffle_epi8(alphaABCD, distribution_mask);
+
+	srcABCD = _mm256_sub_epi16(srcABCD, dstABCD);       // VPSUBW,    (r - Cr)
+	srcABCD = _mm256_mullo_epi16(srcABCD, alphaABCD);   // VPMULLW, a*(r - Cr)
+	srcABCD = _mm256_srli_epi16(srcABCD, 8);            // VPSRLW,  a*(r - Cr)/256
+	srcABCD = _mm256_add_epi16(srcABCD, dstABCD);       // VPADDW,  a*(r - Cr)/256 + Cr
+	return PackFourPixels(srcABCD, pack_mask);
+}
+
+/**
+ * Darken four pixels; the same calculation as DarkenTwoPixels().
+ * @param src The source pixels, of which only the alpha is used.
+ * @param dst The destination pixels.
+ * @param distribution_mask ALPHA_CONTROL_MASK in both lanes.
+ * @param tr_nom_base TRANSPARENT_NOM_BASE in both lanes.
+ * @return The darkened pixels.
+ */
+static inline __m128i DarkenFourPixels(__m128i src, __m128i dst, const __m256i &distribution_mask, const __m256i &tr_nom_base)
+{
+	__m256i srcABCD = _mm256_cvtepu8_epi16(src);
+	__m256i dstABCD = _mm256_cvtepu8_epi16(dst);
+	__m256i alphaABCD = _mm256_shuffle_epi8(srcABCD, distribution_mask);
+	alphaABCD = _mm256_srli_epi16(alphaABCD, 2); // Reduce to 64 levels of shades so the max value fits in 16 bits.
+	__m256i nom = _mm256_sub_epi16(tr_nom_base, alphaABCD);
+	dstABCD = _mm256_mullo_epi16(dstABCD, nom);
+	dstABCD = _mm256_srli_epi16(dstABCD, 8);
+	dstABCD = _mm256_packus_epi16(dstABCD, dstABCD);
+	return _mm256_castsi256_si128(_mm256_permute4x64_epi64(dstABCD, 0x08));
+}
+
+/**
+ * Adjust the brightness of four pixels; the same calculation as AdjustBrightnessOfTwoPixels().
+ * @param from The pixels.
+ * @param brightness The four map values of the pixels.
+ * @return The pixels with adjusted brightness.
+ */
+static inline __m128i AdjustBrightnessOfFourPixels(__m128i from, uint64 brightness)
+{
+	/* Keep alpha by using DEFAULT_BRIGHTNESS for it, see AdjustBrightnessOfTwoPixels(). */
+	brightness &= 0xFF00FF00FF00FF00ULL;
+	brightness += (uint64)Blitter_32bppBase::DEFAULT_BRIGHTNESS << 32 | Blitter_32bppBase::DEFAULT_BRIGHTNESS;
+
+	__m256i colABCD = _mm256_cvtepu8_epi16(from);
+	__m256i briABCD = _mm256_set_epi64x(0, brightness >> 32, 0, brightness & 0xFFFFFFFF);
+	briABCD = _mm256_shuffle_epi8(briABCD, _mm256_broadcastsi128_si256(BRIGHTNESS_LOW_CONTROL_MASK));
+	colABCD = _mm256_mullo_epi16(colABCD, briABCD);
+	__m256i colABCD_ob = _mm256_srli_epi16(colABCD, 8 + 7);
+	colABCD = _mm256_srli_epi16(colABCD, 7);
+
+	/* Sum overbright. */
+	const __m256i ob_value = _mm256_broadcastsi128_si256(OVERBRIGHT_VALUE_MASK);
+	colABCD = _mm256_and_si256(colABCD, _mm256_broadcastsi128_si256(BRIGHTNESS_DIV_CLEANER));
+	colABCD_ob = _mm256_and_si256(colABCD_ob, _mm256_broadcastsi128_si256(OVERBRIGHT_PRESENCE_MASK));
+	colABCD_ob = _mm256_mullo_epi16(colABCD_ob, ob_value);
+	colABCD_ob = _mm256_and_si256(colABCD_ob, colABCD);
+	__m256i obABCD = _mm256_hadd_epi16(_mm256_hadd_epi16(colABCD_ob, _mm256_setzero_si256()), _mm256_setzero_si256());
+
+	obABCD = _mm256_srli_epi16(obABCD, 1);          // Reduce overbright strength.
+	obABCD = _mm256_shuffle_epi8(obABCD, _mm256_broadcastsi128_si256(OVERBRIGHT_CONTROL_MASK));
+	__m256i retABCD = _mm256_subs_epu16(ob_value, colABCD); //    (255 - rgb)
+	retABCD = _mm256_mullo_epi16(retABCD, obABCD);  // ob*(255 - rgb)
+	retABCD = _mm256_srli_epi16(retABCD, 8);        // ob*(255 - rgb)/256
+	retABCD = _mm256_add_epi16(retABCD, colABCD);   // ob*(255 - rgb)/256 + rgb
+
+	retABCD = _mm256_packus_epi16(retABCD, retABCD);
+	return _mm256_castsi256_si128(_mm256_permute4x64_epi64(retABCD, 0x08));
+}
+
+/**
+ * Remap the colour of a single pixel, keeping its alpha; the same as CMOV_REMAP of the SSE blitters.
+ * @param src The pixel.
+ * @param mv The map value of the pixel.
+ * @param remap The remap table.
+ * @return The remapped pixel, or a fully transparent pixel when it should not be drawn.
+ */
+static inline uint32 RemapPixel(uint32 src, Blitter_32bppSSE_Base::MapValue mv, const byte *remap)
+{
+	/* Written so the compiler uses CMOV. */
+	const uint r = remap[mv.m];
+	const uint32 cmap = (Blitter_32bppBase::LookupColourInPalette(r).data & 0x00FFFFFF) | (src & 0xFF000000);
+	const uint32 remapped = r == 0 ? 0 : cmap;
+	return mv.m != 0 ? remapped : src;
+}
+
+/**
+ * Draws a sprite to a (screen) buffer. It is templated to allow faster operation.
+ * The pixels that do not fill a group of four at the end of a line are drawn one by one
+ * with the same calculations, so the colours are the same as those of the SSE4 blitter.
+ *
+ * @tparam mode blitter mode
+ * @param bp further blitting parameters
+ * @param zoom zoom level at which we are drawing
+ */
+IGNORE_UNINITIALIZED_WARNING_START
+template <BlitterMode mode, Blitter_32bppSSE_Base::ReadMode read_mode, bool translucent>
+inline void Blitter_32bppAVX2::Draw(const Blitter::BlitterParams *bp, ZoomLevel zoom)
+{
+	const byte * const remap = bp->remap;
+	Colour *dst_line = (Colour *) bp->dst + bp->top * bp->pitch + bp->left;
+	int effective_width = bp->width;
+
+	/* Find where to start reading in the source sprite. */
+	const SpriteData * const sd = (const SpriteData *) bp->sprite;
+	const SpriteInfo * const si = &sd->infos[zoom];
+	const MapValue *src_mv_line = (const MapValue *) &sd->data[si->mv_offset] + bp->skip_top * si->sprite_width;
+	const Colour *src_rgba_line = (const Colour *) ((const byte *) &sd->data[si->sprite_offset] + bp->skip_top * si->sprite_line_size);
+
+	if (read_mode != RM_WITH_MARGIN) {
+		src_rgba_line += bp->skip_left;
+		src_mv_line += bp->skip_left;
+	}
+	const MapValue *src_mv = src_mv_line;
+
+	/* Load these variables into register before loop. */
+	const __m128i a_cm         = ALPHA_CONTROL_MASK;
+	const __m128i pack_low_cm  = PACK_LOW_CONTROL_MASK;
+	const __m128i tr_nom_base  = TRANSPARENT_NOM_BASE;
+	const __m256i a_cm_x2      = _mm256_broadcastsi128_si256(a_cm);
+	const __m256i pack_cm_x2   = _mm256_broadcastsi128_si256(pack_low_cm);
+	const __m256i tr_nom_x2    = _mm256_broadcastsi128_si256(tr_nom_base);
+	const __m256i black_x8     = _mm256_set1_epi32(Colour(0, 0, 0).data);
+
+	for (int y = bp->height; y != 0; y--) {
+		Colour *dst = dst_line;
+		const Colour *src = src_rgba_line + META_LENGTH;
+		if (mode == BM_COLOUR_REMAP || mode == BM_CRASH_REMAP) src_mv = src_mv_line;
+
+		if (read_mode == RM_WITH_MARGIN) {
+			src += src_rgba_line[0].data;
+			dst += src_rgba_line[0].data;
+			if (mode == BM_COLOUR_REMAP || mode == BM_CRASH_REMAP) src_mv += src_rgba_line[0].data;
+			const int width_diff = si->sprite_width - bp->width;
+			effective_width = bp->width - (int) src_rgba_line[0].data;
+			const int delta_diff = (int) src_rgba_line[1].data - width_diff;
+			const int new_width = effective_width - delta_diff;
+			effective_width = delta_diff > 0 ? new_width : effective_width;
+			if (effective_width <= 0) goto next_line;
+		}
+
+		switch (mode) {
+			default: {
+				uint x = (uint) effective_width;
+				if (!translucent) {
+					/* Only fully transparent and opaque pixels; keep the destination where the source is transparent. */
+					for (; x >= 8; x -= 8) {
+						__m256i srcX8 = _mm256_loadu_si256((const __m256i *) src);
+						__m256i dstX8 = _mm256_loadu_si256((const __m256i *) dst);
+						__m256i transparent = _mm256_cmpeq_epi32(_mm256_srli_epi32(srcX8, 24), _mm256_setzero_si256());
+						_mm256_storeu_si256((__m256i *) dst, _mm256_blendv_epi8(srcX8, dstX8, transparent));
+						src += 8;
+						dst += 8;
+					}
+					for (; x > 0; x--) {
+						if (src->a) *dst = *src;
+						src++;
+						dst++;
+					}
+					break;
+				}
+
+				for (; x >= 4; x -= 4) {
+					__m128i srcABCD = _mm_loadu_si128((const __m128i *) src);
+					__m128i dstABCD = _mm_loadu_si128((const __m128i *) dst);
+					_mm_storeu_si128((__m128i *) dst, AlphaBlendFourPixels(srcABCD, dstABCD, a_cm_x2, pack_cm_x2));
+					src += 4;
+					dst += 4;
+				}
+				for (; x > 0; x--) {
+					__m128i srcABCD = _mm_cvtsi32_si128(src->data);
+					__m128i dstABCD = _mm_cvtsi32_si128(dst->data);
+					dst->data = _mm_cvtsi128_si32(AlphaBlendTwoPixels(srcABCD, dstABCD, a_cm, pack_low_cm));
+					src++;
+					dst++;
+				}
+				break;
+			}
+
+			case BM_COLOUR_REMAP: {
+				uint x = (uint) effective_width;
+				for (; x >= 4; x -= 4) {
+					__m128i srcABCD = _mm_loadu_si128((const __m128i *) src);
+					__m128i dstABCD = _mm_loadu_si128((const __m128i *) dst);
+					uint64 mvX4 = *((uint64 *) const_cast<MapValue *>(src_mv));
+
+					/* Remap colours. */
+					if (mvX4 & 0x00FF00FF00FF00FFULL) {
+						srcABCD = _mm_setr_epi32(RemapPixel(src[0].data, src_mv[0], remap), RemapPixel(src[1].data, src_mv[1], remap),
+								RemapPixel(src[2].data, src_mv[2], remap), RemapPixel(src[3].data, src_mv[3], remap));
+
+						/* The brightness of pixels without remap is the default, so those do not change. */
+						if ((mvX4 & 0xFF00FF00FF00FF00ULL) != 0x8000800080008000ULL) srcABCD = AdjustBrightnessOfFourPixels(srcABCD, mvX4);
+					}
+
+					/* Blend colours. */
+					_mm_storeu_si128((__m128i *) dst, AlphaBlendFourPixels(srcABCD, dstABCD, a_cm_x2, pack_cm_x2));
+					dst += 4;
+					src += 4;
+					src_mv += 4;
+				}
+
+				for (; x > 0; x--) {
+					/* In case the m-channel is zero, do not remap this pixel in any way. */
+					__m128i srcABCD;
+					if (src_mv->m) {
+						const uint r = remap[src_mv->m];
+						if (r != 0) {
+							Colour remapped_colour = AdjustBrightneSSE(this->LookupColourInPalette(r), src_mv->v);
+							if (src->a == 255) {
+								*dst = remapped_colour;
+							} else {
+								remapped_colour.a = src->a;
+								srcABCD = _mm_cvtsi32_si128(remapped_colour.data);
+								goto bmcr_alpha_blend_single;
+							}
+						}
+					} else {
+						srcABCD = _mm_cvtsi32_si128(src->data);
+						if (src->a < 255) {
+bmcr_alpha_blend_single:
+							__m128i dstABCD = _mm_cvtsi32_si128(dst->data);
+							srcABCD = AlphaBlendTwoPixels(srcABCD, dstABCD, a_cm, pack_low_cm);
+						}
+						dst->data = _mm_cvtsi128_si32(srcABCD);
+					}
+					src_mv++;
+					dst++;
+					src++;
+				}
+				break;
+			}
+
+			case BM_TRANSPARENT: {
+				/* Make the current colour a bit more black, so it looks like this image is transparent. */
+				uint x = (uint) bp->width;
+				for (; x >= 4; x -= 4) {
+					__m128i srcABCD = _mm_loadu_si128((const __m128i *) src);
+					__m128i dstABCD = _mm_loadu_si128((const __m128i *) dst);
+					_mm_storeu_si128((__m128i *) dst, DarkenFourPixels(srcABCD, dstABCD, a_cm_x2, tr_nom_x2));
+					src += 4;
+					dst += 4;
+				}
+				for (; x > 0; x--) {
+					__m128i srcABCD = _mm_cvtsi32_si128(src->data);
+					__m128i dstABCD = _mm_cvtsi32_si128(dst->data);
+					dst->data = _mm_cvtsi128_si32(DarkenTwoPixels(srcABCD, dstABCD, a_cm, tr_nom_base));
+					src++;
+					dst++;
+				}
+				break;
+			}
+
+			case BM_CRASH_REMAP:
+				/* Rarely drawn, and every pixel needs its own palette lookup; no use in vectorising. */
+				for (uint x = (uint) bp->width; x > 0; x--) {
+					if (src_mv->m == 0) {
+						if (src->a != 0) {
+							uint8 g = MakeDark(src->r, src->g, src->b);
+							*dst = ComposeColourRGBA(g, g, g, src->a, *dst);
+						}
+					} else {
+						uint r = remap[src_mv->m];
+						if (r != 0) *dst = ComposeColourPANoCheck(this->AdjustBrightness(this->LookupColourInPalette(r), src_mv->v), src->a, *dst);
+					}
+					src_mv++;
+					dst++;
+					src++;
+				}
+				break;
+
+			case BM_BLACK_REMAP: {
+				uint x = (uint) bp->width;
+				for (; x >= 8; x -= 8) {
+					__m256i srcX8 = _mm256_loadu_si256((const __m256i *) src);
+					__m256i dstX8 = _mm256_loadu_si256((const __m256i *) dst);
+					__m256i transparent = _mm256_cmpeq_epi32(_mm256_srli_epi32(srcX8, 24), _mm256_setzero_si256());
+					_mm256_storeu_si256((__m256i *) dst, _mm256_blendv_epi8(black_x8, dstX8, transparent));
+					src += 8;
+					dst += 8;
+				}
+				for (; x > 0; x--) {
+					if (src->a != 0) *dst = Colour(0, 0, 0);
+					dst++;
+					src++;
+				}
+				break;
+			}
+		}
+
+next_line:
+		if (mode == BM_COLOUR_REMAP || mode == BM_CRASH_REMAP) src_mv_line += si->sprite_width;
+		src_rgba_line = (const Colour*) ((const byte*) src_rgba_line + si->sprite_line_size);
+		dst_line += bp->pitch;
+	}
+}
+IGNORE_UNINITIALIZED_WARNING_STOP
+
+/**
+ * Draws a sprite to a (screen) buffer. Calls adequate templated function.
+ *
+ * @param bp further blitting parameters
+ * @param mode blitter mode
+ * @param zoom zoom level at which we are drawing
+ */
+void Blitter_32bppAVX2::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
+{
+	switch (mode) {
+		default: {
+			if (bp->skip_left != 0 || bp->width <= MARGIN_NORMAL_THRESHOLD) {
+bm_normal:
+				Draw<BM_NORMAL, RM_WITH_SKIP, true>(bp, zoom);
+			} else if (((const Blitter_32bppSSE_Base::SpriteData *) bp->sprite)->flags & SF_TRANSLUCENT) {
+				Draw<BM_NORMAL, RM_WITH_MARGIN, true>(bp, zoom);
+			} else {
+				Draw<BM_NORMAL, RM_WITH_MARGIN, false>(bp, zoom);
+			}
+			return;
+		}
+		case BM_COLOUR_REMAP:
+			if (((const Blitter_32bppSSE_Base::SpriteData *) bp->sprite)->flags & SF_NO_REMAP) goto bm_normal;
+			if (bp->skip_left != 0 || bp->width <= MARGIN_REMAP_THRESHOLD) {
+				Draw<BM_COLOUR_REMAP, RM_WITH_SKIP, true>(bp, zoom); return;
+			} else {
+				Draw<BM_COLOUR_REMAP, RM_WITH_MARGIN, true>(bp, zoom); return;
+			}
+		case BM_TRANSPARENT:  Draw<BM_TRANSPARENT, RM_NONE, true>(bp, zoom); return;
+		case BM_CRASH_REMAP:  Draw<BM_CRASH_REMAP, RM_NONE, true>(bp, zoom); return;
+		case BM_BLACK_REMAP:  Draw<BM_BLACK_REMAP, RM_NONE, true>(bp, zoom); return;
+	}
+}
+
+#endif /* WITH_AVX2 */
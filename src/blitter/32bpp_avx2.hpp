@@ -0,0 +1,47 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_avx2.hpp AVX2 32 bpp blitter. */
+
+#ifndef BLITTER_32BPP_AVX2_HPP
+#define BLITTER_32BPP_AVX2_HPP
+
+#ifdef WITH_AVX2
+
+#ifndef SSE_VERSION
+#define SSE_VERSION 4
+#endif
+
+#ifndef FULL_ANIMATION
+#define FULL_ANIMATION 0
+#endif
+
+#include "32bpp_sse4.hpp"
+
+/**
+ * The AVX2 32 bpp blitter (without palette animation).
+ * It uses the sprite format of the SSE blitters, but draws four pixels at a time.
+ */
+class Blitter_32bppAVX2 : public Blitter_32bppSSE4 {
+public:
+	/* virtual */ void Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom);
+	template <BlitterMode mode, Blitter_32bppSSE_Base::ReadMode read_mode, bool translucent>
+	void Draw(const Blitter::BlitterParams *bp, ZoomLevel zoom);
+	/* virtual */ const char *GetName() { return "32bpp-avx2"; }
+};
+
+/** Factory for the AVX2 32 bpp blitter (without palette animation). */
+class FBlitter_32bppAVX2: public BlitterFactory {
+public:
+	FBlitter_32bppAVX2() : BlitterFactory("32bpp-avx2", "32bpp AVX2 Blitter (no palette animation)", HasAVX2Support()) {}
+	/* virtual */ Blitter *CreateInstance() { return new Blitter_32bppAVX2(); }
+};
+
+#endif /* WITH_AVX2 */
+#endif /* BLITTER_32BPP_AVX2_HPP */
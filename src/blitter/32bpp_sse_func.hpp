@@ -184,7 +184,7 @@ static inline __m128i AdjustBrightnessOfTwoPixels(__m128i from, uint32 brightnes
 #endif
 }
 
-#if FULL_ANIMATION == 0
+#if FULL_ANIMATION == 0 && !defined(SSE_FUNC_NO_DRAW)
 /**
  * Draws a sprite to a (screen) buffer. It is templated to allow faster operation.
  *
@@ -14,6 +14,7 @@
 #include "../settings_type.h"
 #include "../core/math_func.hpp"
 #include "../core/mem_func.hpp"
+#include "../thread/thread.h"
 #include "8bpp_optimized.hpp"
 
 #include "../safeguards.h"
@@ -21,6 +22,18 @@
 /** Instantiation of the 8bpp optimised blitter factory. */
 static FBlitter_8bppOptimized iFBlitter_8bppOptimized;
 
+Blitter_8bppOptimized::Blitter_8bppOptimized() : encode_buffers_mutex(ThreadMutex::New())
+{
+}
+
+Blitter_8bppOptimized::~Blitter_8bppOptimized()
+{
+	for (ReusableBuffer<byte> **buffer = this->encode_buffers.Begin(); buffer != this->encode_buffers.End(); buffer++) {
+		delete *buffer;
+	}
+	delete this->encode_buffers_mutex;
+}
+
 void Blitter_8bppOptimized::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
 {
 	/* Find the offset of this zoom-level */
@@ -145,11 +158,19 @@ Sprite *Blitter_8bppOptimized::Encode(const SpriteLoader::Sprite *sprite, Alloca
 	/* We have no idea how much memory we really need, so just guess something */
 	memory *= 5;
 
-	/* Don't allocate memory each time, but just keep some
-	 * memory around as this function is called quite often
-	 * and the memory usage is quite low. */
-	static ReusableBuffer<byte> temp_buffer;
-	SpriteData *temp_dst = (SpriteData *)temp_buffer.Allocate(memory);
+	/* Sprites may be encoded by multiple threads at once,
+	 * so every call borrows a buffer of its own. */
+	ReusableBuffer<byte> *temp_buffer;
+	{
+		ThreadMutexLocker lock(this->encode_buffers_mutex);
+		if (this->encode_buffers.Length() == 0) {
+			temp_buffer = new ReusableBuffer<byte>();
+		} else {
+			temp_buffer = this->encode_buffers[this->encode_buffers.Length() - 1];
+			this->encode_buffers.Resize(this->encode_buffers.Length() - 1);
+		}
+	}
+	SpriteData *temp_dst = (SpriteData *)temp_buffer->Allocate(memory);
 	memset(temp_dst, 0, sizeof(*temp_dst));
 	byte *dst = temp_dst->data;
 
@@ -228,5 +249,8 @@ Sprite *Blitter_8bppOptimized::Encode(const SpriteLoader::Sprite *sprite, Alloca
 	dest_sprite->y_offs = sprite->y_offs;
 	memcpy(dest_sprite->data, temp_dst, size);
 
+	ThreadMutexLocker lock(this->encode_buffers_mutex);
+	*this->encode_buffers.Append() = temp_buffer;
+
 	return dest_sprite;
 }
@@ -14,9 +14,17 @@
 
 #include "8bpp_base.hpp"
 #include "factory.hpp"
+#include "../core/alloc_type.hpp"
+#include "../core/smallvec_type.hpp"
+
+class ThreadMutex;
 
 /** 8bpp blitter optimised for speed. */
 class Blitter_8bppOptimized FINAL : public Blitter_8bppBase {
+private:
+	SmallVector<ReusableBuffer<byte> *, 4> encode_buffers; ///< Encoding buffers not in use by an Encode call; one for each thread that encoded at the same time.
+	ThreadMutex *encode_buffers_mutex;                    ///< Mutex for #encode_buffers, as sprites may be encoded by multiple threads at once.
+
 public:
 	/** Data stored about a (single) sprite. */
 	struct SpriteData {
@@ -24,6 +32,9 @@ public:
 		byte data[];                   ///< Data, all zoomlevels.
 	};
 
+	Blitter_8bppOptimized();
+	~Blitter_8bppOptimized();
+
 	/* virtual */ void Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom);
 	/* virtual */ Sprite *Encode(const SpriteLoader::Sprite *sprite, AllocatorProc *allocator);
 
@@ -266,7 +266,16 @@ static void TileLoop_Clear(TileIndex tile)
 
 	switch (GetClearGround(tile)) {
 		case CLEAR_GRASS:
-			if (GetClearDensity(tile) == 3) return;
+			if (GetClearDensity(tile) == 3) {
+				/* Fully grown grass stays that way, unless the climate changes the ground.
+				 * Tiles next to the map edge may be flooded once freeform edges get
+				 * enabled, so they are never idle whatever the current setting is. */
+				if (_settings_game.game_creation.landscape != LT_TROPIC && _settings_game.game_creation.landscape != LT_ARCTIC &&
+						DistanceFromEdge(tile) != 1) {
+					SetTileLoopIdle(tile);
+				}
+				return;
+			}
 
 			if (_game_mode != GM_EDITOR) {
 				if (GetClearCounter(tile) < 7) {
@@ -425,6 +425,16 @@ bool IsCommandAllowedWhilePaused(uint32 cmd)
 
 static int _docommand_recursive = 0;
 
+/**
+ * Check whether a command is being tested or executed at the moment.
+ * Commands may temporarily change the game state, e.g. while testing a refit.
+ * @return True when called from within a command.
+ */
+bool IsCommandRunning()
+{
+	return _docommand_recursive != 0;
+}
+
 /**
  * Shorthand for calling the long DoCommand with a container.
  *
@@ -38,6 +38,7 @@
 #include "console_func.h"
 #include "engine_base.h"
 #include "game/game.hpp"
+#include "benchmark.h"
 #include "table/strings.h"
 
 #include "safeguards.h"
@@ -1342,6 +1343,29 @@ DEF_CONSOLE_CMD(ConAlias)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConBenchmarkBlitters)
+{
+	if (argc == 0) {
+		IConsoleHelp("Measure how fast blitters draw sprites. Usage: 'benchmark_blitters [<iterations>] [<blitter>...]'");
+		IConsoleHelp("Without blitters, all vectorised blitters that are available and their plain counterparts are measured.");
+		return true;
+	}
+
+	uint iterations = 1000;
+	int first = 1;
+	if (argc > 1) {
+		char *end;
+		uint value = strtoul(argv[1], &end, 0);
+		if (end != argv[1] && *end == '\0') {
+			iterations = value;
+			first = 2;
+		}
+	}
+
+	BenchmarkBlitters(argc > first ? argv + first : NULL, argc - first, iterations);
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConScreenShot)
 {
 	if (argc == 0) {
@@ -1913,6 +1937,7 @@ void IConsoleStdLibRegister()
 	IConsoleCmdRegister("reset_enginepool", ConResetEnginePool, ConHookNoNetwork);
 	IConsoleCmdRegister("return",       ConReturn);
 	IConsoleCmdRegister("screenshot",   ConScreenShot);
+	IConsoleCmdRegister("benchmark_blitters", ConBenchmarkBlitters);
 	IConsoleCmdRegister("script",       ConScript);
 	IConsoleCmdRegister("scrollto",     ConScrollToTile);
 	IConsoleCmdRegister("alias",        ConAlias);
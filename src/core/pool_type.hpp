@@ -319,4 +319,9 @@ private:
 
 #define FOR_ALL_ITEMS(type, iter, var) FOR_ALL_ITEMS_FROM(type, iter, var, 0)
 
+/* Iterate over every step-th item, starting at the item with index start. */
+#define FOR_ALL_ITEMS_FROM_STEP(type, iter, var, start, step) \
+	for (size_t iter = start; var = NULL, iter < type::GetPoolSize(); iter += step) \
+		if ((var = type::Get(iter)) != NULL)
+
 #endif /* POOL_TYPE_HPP */
@@ -34,4 +34,11 @@ void ottd_cpuid(int info[4], int type);
  */
 bool HasCPUIDFlag(uint type, uint index, uint bit);
 
+/**
+ * Check whether AVX2 instructions can be used, i.e. whether the CPU has them
+ * and the operating system saves the 256 bit registers.
+ * @return True when AVX2 is supported by both the CPU and the operating system.
+ */
+bool HasAVX2Support();
+
 #endif /* CPU_H */
@@ -24,6 +24,19 @@ void SetDate(Date date, DateFract fract);
 void ConvertDateToYMD(Date date, YearMonthDay *ymd);
 Date ConvertYMDToDate(Year year, Month month, Day day);
 
+/**
+ * Get the index of the first item that is due in the current tick, when
+ * every item is handled once per \a interval ticks, in the tick where
+ * (_tick_counter + index) % interval == 0. The other due items follow
+ * every \a interval indices, so only those have to be visited.
+ * @param interval The number of ticks between handling the same item.
+ * @return The index of the first due item.
+ */
+static inline uint GetTickPhaseIndex(uint interval)
+{
+	return (interval - _tick_counter % interval) % interval;
+}
+
 /**
  * Checks whether the given year is a leap year or not.
  * @param yr The year to check.
@@ -492,6 +492,9 @@ void ChangeOwnershipOfCompanyItems(Owner old_owner, Owner new_owner)
 			ChangeTileOwner(tile, old_owner, new_owner);
 		} while (++tile != MapSize());
 
+		/* Signal blocks end where the owner of the track changes. */
+		InvalidateSignalBlocks(INVALID_TILE);
+
 		if (new_owner != INVALID_OWNER) {
 			/* Update all signals because there can be new segment that was owned by two companies
 			 * and signals were not propagated
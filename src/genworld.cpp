@@ -34,6 +34,9 @@
 #include "game/game.hpp"
 #include "game/game_instance.hpp"
 #include "string_func.h"
+#include "benchmark.h"
+#include "settings_type.h"
+#include "thread/worker_pool.h"
 
 #include "safeguards.h"
 
@@ -60,6 +63,56 @@ GenWorldInfo _gw;
 /** Whether we are generating the map or not. */
 bool _generating_world;
 
+/** Number of rows of the map in a region handled by #GenerateWorldRegions. */
+static const uint GENWORLD_REGION_ROWS = 16;
+
+WorkerPool _genworld_workers("ottd:genregion"); ///< Threads helping with the stages of the world generation that are split up in regions.
+
+/** A batch of regions for #GenerateWorldRegions. */
+struct GenWorldRegions {
+	GWRegionProc *proc; ///< Procedure handling a region.
+	void *param;        ///< Parameter of the procedure.
+	uint y_begin;       ///< First row of the first region.
+	uint y_end;         ///< Row after the last row of the last region.
+};
+
+/**
+ * Handle a region of a batch.
+ * @param param The #GenWorldRegions.
+ * @param job   The number of the region.
+ */
+static void GenerateWorldRegionJob(void *param, uint job)
+{
+	const GenWorldRegions *regions = (const GenWorldRegions *)param;
+	uint y_begin = regions->y_begin + job * GENWORLD_REGION_ROWS;
+	regions->proc(regions->param, y_begin, min(y_begin + GENWORLD_REGION_ROWS, regions->y_end));
+}
+
+/**
+ * Split some rows of the map in regions, and handle the regions with multiple
+ * threads. The regions are handled in any order, so a region may only change
+ * its own tiles, and only read the parts of other tiles that no region changes.
+ * @param proc    The procedure handling a region.
+ * @param param   The parameter for the procedure.
+ * @param y_begin The first row to handle.
+ * @param y_end   The row after the last row to handle.
+ */
+void GenerateWorldRegions(GWRegionProc *proc, void *param, uint y_begin, uint y_end)
+{
+	if (y_end <= y_begin) return;
+
+	GenWorldRegions regions = { proc, param, y_begin, y_end };
+	_tile_loop_idle_deferred = true;
+	_genworld_workers.Run(&GenerateWorldRegionJob, &regions, CeilDiv(y_end - y_begin, GENWORLD_REGION_ROWS));
+	_tile_loop_idle_deferred = false;
+
+	/* The regions may have changed any of their tiles, which activates the tile
+	 * loop of those tiles and their neighbours; do that now for all of them at once. */
+	TileIndex first = TileXY(0, y_begin == 0 ? 0 : y_begin - 1);
+	TileIndex last = y_end >= MapSizeY() ? MapSize() : TileXY(0, y_end + 1);
+	for (TileIndex t = first; t < last; t++) ClrBit(_tile_loop_idle[t / 8], t % 8);
+}
+
 /**
  * Tells if the world generation is done in a thread or not.
  * @return the 'threaded' status
@@ -85,6 +138,8 @@ static void CleanupGeneration()
 	_gw.abortp   = NULL;
 	_gw.threaded = false;
 
+	_genworld_workers.SetThreads(0);
+
 	DeleteWindowByClass(WC_MODAL_PROGRESS);
 	ShowFirstError();
 	MarkWholeScreenDirty();
@@ -99,12 +154,15 @@ static void _GenerateWorld(void *)
 	Backup<CompanyByte> _cur_company(_current_company, OWNER_NONE, FILE_LINE);
 
 	try {
+		BenchmarkTimer timer(BE_GENWORLD);
+
 		_generating_world = true;
 		_modal_progress_work_mutex->BeginCritical();
 		if (_network_dedicated) DEBUG(net, 1, "Generating map, please wait...");
 		/* Set the Random() seed to generation_seed so we produce the same map with the same seed */
 		if (_settings_game.game_creation.generation_seed == GENERATE_NEW_SEED) _settings_game.game_creation.generation_seed = _settings_newgame.game_creation.generation_seed = InteractiveRandom();
 		_random.SetSeed(_settings_game.game_creation.generation_seed);
+		_genworld_workers.SetThreads((_settings_client.gui.genworld_threads != 0 ? _settings_client.gui.genworld_threads : GetCPUCoreCount()) - 1);
 		SetGeneratingWorldProgress(GWP_MAP_INIT, 2);
 		SetObjectToPlace(SPR_CURSOR_ZZZ, PAL_NONE, HT_NONE, WC_MAIN_WINDOW, 0);
 
@@ -160,10 +218,13 @@ static void _GenerateWorld(void *)
 			uint i;
 
 			SetGeneratingWorldProgress(GWP_RUNTILELOOP, 0x500);
-			for (i = 0; i < 0x500; i++) {
-				RunTileLoop();
-				_tick_counter++;
-				IncreaseGeneratingWorldProgress(GWP_RUNTILELOOP);
+			{
+				BenchmarkTimer timer(BE_GENWORLD_TILELOOP);
+				for (i = 0; i < 0x500; i++) {
+					RunTileLoop();
+					_tick_counter++;
+					IncreaseGeneratingWorldProgress(GWP_RUNTILELOOP);
+				}
 			}
 
 			if (_game_mode != GM_EDITOR) {
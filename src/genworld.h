@@ -50,6 +50,14 @@ static const uint CUSTOM_SEA_LEVEL_MAX_PERCENTAGE = 90;   ///< Maximum percentag
 typedef void GWDoneProc();  ///< Procedure called when the genworld process finishes
 typedef void GWAbortProc(); ///< Called when genworld is aborted
 
+/**
+ * Procedure handling a region of the map; regions are handled by multiple threads at once.
+ * @param param   The parameter given for all regions.
+ * @param y_begin The first row of the region.
+ * @param y_end   The row after the last row of the region.
+ */
+typedef void GWRegionProc(void *param, uint y_begin, uint y_end);
+
 /** Properties of current genworld process */
 struct GenWorldInfo {
 	bool abort;            ///< Whether to abort the thread ASAP
@@ -90,6 +98,9 @@ void GenerateWorld(GenWorldMode mode, uint size_x, uint size_y, bool reset_setti
 void AbortGeneratingWorld();
 bool IsGeneratingWorldAborted();
 void HandleGeneratingWorldAbortion();
+void GenerateWorldRegions(GWRegionProc *proc, void *param, uint y_begin, uint y_end);
+
+extern class WorkerPool _genworld_workers;
 
 /* genworld_gui.cpp */
 void SetNewLandscapeType(byte landscape);
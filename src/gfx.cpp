@@ -21,6 +21,7 @@
 #include "network/network_func.h"
 #include "window_func.h"
 #include "newgrf_debug.h"
+#include "newgrf_spritegroup.h"
 
 #include "table/palettes.h"
 #include "table/string_colours.h"
@@ -856,13 +857,14 @@ void DrawSprite(SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub,
  * @param mode   The settings for the blitter to pass.
  * @param sub    Whether to only draw a sub set of the sprite.
  * @param zoom   The zoom level at which to draw the sprites.
+ * @param dpi    Where to draw the sprite.
+ * @param remap  The recolour table for the blitter modes that need one.
  * @tparam ZOOM_BASE The factor required to get the sub sprite information into the right size.
  * @tparam SCALED_XY Whether the X and Y are scaled or unscaled.
  */
 template <int ZOOM_BASE, bool SCALED_XY>
-static void GfxBlitter(const Sprite * const sprite, int x, int y, BlitterMode mode, const SubSprite * const sub, SpriteID sprite_id, ZoomLevel zoom)
+static void GfxBlitter(const Sprite * const sprite, int x, int y, BlitterMode mode, const SubSprite * const sub, SpriteID sprite_id, ZoomLevel zoom, const DrawPixelInfo *dpi, const byte *remap)
 {
-	const DrawPixelInfo *dpi = _cur_dpi;
 	Blitter::BlitterParams bp;
 
 	if (SCALED_XY) {
@@ -909,7 +911,7 @@ static void GfxBlitter(const Sprite * const sprite, int x, int y, BlitterMode mo
 
 	bp.dst = dpi->dst_ptr;
 	bp.pitch = dpi->pitch;
-	bp.remap = _colour_remap_ptr;
+	bp.remap = remap;
 
 	assert(sprite->width > 0);
 	assert(sprite->height > 0);
@@ -979,12 +981,64 @@ static void GfxBlitter(const Sprite * const sprite, int x, int y, BlitterMode mo
 
 static void GfxMainBlitterViewport(const Sprite *sprite, int x, int y, BlitterMode mode, const SubSprite *sub, SpriteID sprite_id)
 {
-	GfxBlitter<ZOOM_LVL_BASE, false>(sprite, x, y, mode, sub, sprite_id, _cur_dpi->zoom);
+	GfxBlitter<ZOOM_LVL_BASE, false>(sprite, x, y, mode, sub, sprite_id, _cur_dpi->zoom, _cur_dpi, _colour_remap_ptr);
 }
 
 static void GfxMainBlitter(const Sprite *sprite, int x, int y, BlitterMode mode, const SubSprite *sub, SpriteID sprite_id, ZoomLevel zoom)
 {
-	GfxBlitter<1, true>(sprite, x, y, mode, sub, sprite_id, zoom);
+	GfxBlitter<1, true>(sprite, x, y, mode, sub, sprite_id, zoom, _cur_dpi, _colour_remap_ptr);
+}
+
+/**
+ * Look up everything needed to draw a sprite in a viewport, so it can be
+ * drawn later without touching the sprite cache, e.g. by another thread.
+ * The result stays valid as long as the sprite cache does not move or
+ * remove sprites, see #GetSpriteCacheGeneration.
+ * @param img Image number to draw
+ * @param pal Palette to use.
+ * @param rs  Place to store the looked up sprite.
+ */
+void ResolveSpriteViewport(SpriteID img, PaletteID pal, ResolvedSprite *rs)
+{
+	SpriteID real_sprite = GB(img, 0, SPRITE_WIDTH);
+	if (HasBit(img, PALETTE_MODIFIER_TRANSPARENT)) {
+		_colour_remap_ptr = GetNonSprite(GB(pal, 0, PALETTE_WIDTH), ST_RECOLOUR) + 1;
+		rs->mode = BM_TRANSPARENT;
+	} else if (pal != PAL_NONE) {
+		if (HasBit(pal, PALETTE_TEXT_RECOLOUR)) {
+			SetColourRemap((TextColour)GB(pal, 0, PALETTE_WIDTH));
+		} else {
+			_colour_remap_ptr = GetNonSprite(GB(pal, 0, PALETTE_WIDTH), ST_RECOLOUR) + 1;
+		}
+		rs->mode = GetBlitterMode(pal);
+	} else {
+		rs->mode = BM_NORMAL;
+	}
+
+	/* The text colour remap is overwritten by the next text colour, so keep a copy. */
+	if (_colour_remap_ptr == _string_colourremap) {
+		MemCpyT(rs->text_remap, _string_colourremap, lengthof(rs->text_remap));
+		rs->remap = NULL;
+	} else {
+		rs->remap = _colour_remap_ptr;
+	}
+	rs->sprite = GetSprite(real_sprite, ST_NORMAL);
+	rs->sprite_id = real_sprite;
+}
+
+/**
+ * Draw a sprite in a viewport that was looked up before. This does not use
+ * any global drawing state, so it can be done by other threads, as long as
+ * they do not draw on the same pixels.
+ * @param dpi Where to draw the sprite.
+ * @param rs  The sprite, see #ResolveSpriteViewport.
+ * @param x   Left coordinate of image in viewport, scaled by zoom
+ * @param y   Top coordinate of image in viewport, scaled by zoom
+ * @param sub If available, draw only specified part of the sprite
+ */
+void DrawResolvedSpriteViewport(const DrawPixelInfo *dpi, const ResolvedSprite *rs, int x, int y, const SubSprite *sub)
+{
+	GfxBlitter<ZOOM_LVL_BASE, false>(rs->sprite, x, y, (BlitterMode)rs->mode, sub, rs->sprite_id, dpi->zoom, dpi, rs->remap != NULL ? rs->remap : rs->text_remap);
 }
 
 void DoPaletteAnimations();
@@ -1331,6 +1385,9 @@ void DrawDirtyBlocks()
 		if (_switch_mode != SM_NONE && !HasModalProgress()) return;
 	}
 
+	/* Nothing changes the game state while drawing, so callback results can be memoised. */
+	StartNewGRFCallbackCache();
+
 	y = 0;
 	do {
 		x = 0;
@@ -1393,6 +1450,8 @@ void DrawDirtyBlocks()
 		} while (b++, (x += DIRTY_BLOCK_WIDTH) != w);
 	} while (b += -(int)(w / DIRTY_BLOCK_WIDTH) + _dirty_bytes_per_line, (y += DIRTY_BLOCK_HEIGHT) != h);
 
+	StopNewGRFCallbackCache();
+
 	++_dirty_block_colour;
 	_invalid_rect.left = w;
 	_invalid_rect.top = h;
@@ -160,6 +160,17 @@ struct DrawPixelInfo {
 	ZoomLevel zoom;
 };
 
+struct Sprite;
+
+/** A sprite that is looked up in the sprite cache, with everything needed to draw it without the cache. */
+struct ResolvedSprite {
+	const Sprite *sprite; ///< The sprite data.
+	const byte *remap;    ///< Recolour table to draw with, or NULL to use #text_remap.
+	byte mode;            ///< The #BlitterMode to draw with.
+	byte text_remap[3];   ///< Recolour table for sprites recoloured with a text colour.
+	SpriteID sprite_id;   ///< The sprite, for the sprite picker.
+};
+
 /** Structure to access the alpha, red, green, and blue channels from a 32 bit number. */
 union Colour {
 	uint32 data; ///< Conversion of the channel information to a 32 bit number.
@@ -29,10 +29,12 @@ void GroundVehicle<T, Type>::PowerChanged()
 	uint32 max_te = 0;
 	uint32 number_of_parts = 0;
 	uint16 max_track_speed = v->GetDisplayMaxSpeed();
+	bool fixed_properties = true;
 
-	for (const T *u = v; u != NULL; u = u->Next()) {
+	for (T *u = T::From(this); u != NULL; u = u->Next()) {
 		uint32 current_power = u->GetPower() + u->GetPoweredPartPower(u);
 		total_power += current_power;
+		u->gcache.cached_part_power = current_power;
 
 		/* Only powered parts add tractive effort. */
 		if (current_power > 0) max_te += u->GetWeight() * u->GetTractiveEffort();
@@ -41,6 +43,10 @@ void GroundVehicle<T, Type>::PowerChanged()
 		/* Get minimum max speed for this track. */
 		uint16 track_speed = u->GetMaxTrackSpeed();
 		if (track_speed > 0) max_track_speed = min(max_track_speed, track_speed);
+		u->gcache.cached_part_track_speed = track_speed;
+
+		/* Properties of NewGRF vehicles may change through callbacks at any time. */
+		if (u->GetGRF() != NULL) fixed_properties = false;
 	}
 
 	byte air_drag;
@@ -71,6 +77,51 @@ void GroundVehicle<T, Type>::PowerChanged()
 	}
 
 	this->gcache.cached_max_track_speed = max_track_speed;
+	this->gcache.cached_fixed_properties = fixed_properties;
+}
+
+/**
+ * Recalculates the cached power of a vehicle after a single part of it moved onto track
+ * with a different rail type, reusing the cached values of all other parts.
+ * May only be called when the parts have fixed properties.
+ * @param u The part that moved.
+ */
+template <class T, VehicleType Type>
+void GroundVehicle<T, Type>::PartPowerChanged(T *u)
+{
+	assert(this->First() == this && this->gcache.cached_fixed_properties);
+	const T *v = T::From(this);
+
+	uint32 current_power = u->GetPower() + u->GetPoweredPartPower(u);
+	if ((current_power > 0) != (u->gcache.cached_part_power > 0)) {
+		/* The part starts or stops adding tractive effort, so recalculate everything. */
+		this->PowerChanged();
+		return;
+	}
+
+	uint32 total_power = this->gcache.cached_power - u->gcache.cached_part_power + current_power;
+	u->gcache.cached_part_power = current_power;
+
+	uint16 old_track_speed = u->gcache.cached_part_track_speed;
+	uint16 track_speed = u->GetMaxTrackSpeed();
+	u->gcache.cached_part_track_speed = track_speed;
+
+	if (track_speed > 0 && track_speed <= this->gcache.cached_max_track_speed) {
+		this->gcache.cached_max_track_speed = track_speed;
+	} else if (old_track_speed > 0 && old_track_speed == this->gcache.cached_max_track_speed && track_speed != old_track_speed) {
+		/* This part may have been the one limiting the speed; look for the new limit. */
+		uint16 max_track_speed = v->GetDisplayMaxSpeed();
+		for (const T *w = v; w != NULL; w = w->Next()) {
+			if (w->gcache.cached_part_track_speed > 0) max_track_speed = min(max_track_speed, w->gcache.cached_part_track_speed);
+		}
+		this->gcache.cached_max_track_speed = max_track_speed;
+	}
+
+	if (this->gcache.cached_power != total_power) {
+		this->gcache.cached_power = total_power;
+		SetWindowDirty(WC_VEHICLE_DETAILS, this->index);
+		SetWindowWidgetDirty(WC_VEHICLE_VIEW, this->index, WID_VV_START_STOP);
+	}
 }
 
 /**
@@ -82,12 +133,17 @@ void GroundVehicle<T, Type>::CargoChanged()
 {
 	assert(this->First() == this);
 	uint32 weight = 0;
+	uint32 max_te = 0;
+	bool fixed_properties = this->gcache.cached_fixed_properties;
 
 	for (T *u = T::From(this); u != NULL; u = u->Next()) {
 		uint32 current_weight = u->GetWeight();
 		weight += current_weight;
 		/* Slope steepness is in percent, result in N. */
 		u->gcache.cached_slope_resistance = current_weight * u->GetSlopeSteepness() * 100;
+
+		/* Only powered parts add tractive effort. */
+		if (fixed_properties && u->gcache.cached_part_power > 0) max_te += current_weight * u->GetTractiveEffort();
 	}
 
 	/* Store consist weight in cache. */
@@ -95,8 +151,20 @@ void GroundVehicle<T, Type>::CargoChanged()
 	/* Friction in bearings and other mechanical parts is 0.1% of the weight (result in N). */
 	this->gcache.cached_axle_resistance = 10 * weight;
 
-	/* Now update vehicle power (tractive effort is dependent on weight). */
-	this->PowerChanged();
+	if (!fixed_properties) {
+		/* Now update vehicle power (tractive effort is dependent on weight). */
+		this->PowerChanged();
+		return;
+	}
+
+	/* Power and track speed do not depend on the cargo, so only the tractive effort can have changed. */
+	max_te *= 10000; // Tractive effort in (tonnes * 1000 * 10 =) N.
+	max_te /= 256;   // Tractive effort is a [0-255] coefficient.
+	if (this->gcache.cached_max_te != max_te) {
+		this->gcache.cached_max_te = max_te;
+		SetWindowDirty(WC_VEHICLE_DETAILS, this->index);
+		SetWindowWidgetDirty(WC_VEHICLE_VIEW, this->index, WID_VV_START_STOP);
+	}
 }
 
 /**
@@ -39,6 +39,9 @@ struct GroundVehicleCache {
 	uint16 cached_max_track_speed;  ///< Maximum consist speed limited by track type (valid only for the first engine).
 	uint32 cached_power;            ///< Total power of the consist (valid only for the first engine).
 	uint32 cached_air_drag;         ///< Air drag coefficient of the vehicle (valid only for the first engine).
+	uint32 cached_part_power;       ///< Power this vehicle part adds to the consist.
+	uint16 cached_part_track_speed; ///< Maximum speed allowed by the track under this vehicle part.
+	bool cached_fixed_properties;   ///< None of the parts can change its properties through NewGRF callbacks, so the cached part values may be updated one at a time (valid only for the first engine).
 
 	/* Cached NewGRF values, recalculated on load and each time a vehicle is added to/removed from the consist. */
 	uint16 cached_total_length;     ///< Length of the whole vehicle (valid only for the first engine).
@@ -90,6 +93,7 @@ struct GroundVehicle : public SpecializedVehicle<T, Type> {
 	GroundVehicle() : SpecializedVehicle<T, Type>() {}
 
 	void PowerChanged();
+	void PartPowerChanged(T *u);
 	void CargoChanged();
 	int GetAcceleration() const;
 	bool IsChainInDepot() const;
@@ -16,6 +16,7 @@
 #include "subsidy_type.h"
 #include "industry_map.h"
 #include "tilearea_type.h"
+#include "station_type.h"
 
 
 typedef Pool<Industry, IndustryID, 64, 64000> IndustryPool;
@@ -71,10 +72,14 @@ struct Industry : IndustryPool::PoolItem<&_industry_pool> {
 
 	PersistentStorage *psa;             ///< Persistent storage for NewGRF industries.
 
-	Industry(TileIndex tile = INVALID_TILE) : location(tile, 0, 0) {}
+	StationList stations_near;          ///< NOSAVE: Stations around the industry, see #GetStationsNear.
+	uint stations_near_version;         ///< NOSAVE: Station catchment version #stations_near was found for.
+
+	Industry(TileIndex tile = INVALID_TILE) : location(tile, 0, 0), stations_near_version(0) {}
 	~Industry();
 
 	void RecomputeProductionMultipliers();
+	const StationList *GetStationsNear();
 
 	/**
 	 * Check if a given tile belongs to this industry.
@@ -41,6 +41,8 @@
 #include "object_base.h"
 #include "game/game.hpp"
 #include "error.h"
+#include "spatial_index.h"
+#include "benchmark.h"
 
 #include "table/strings.h"
 #include "table/industry_land.h"
@@ -142,6 +144,8 @@ Industry::~Industry()
 	 * Also we must not decrement industry counts in that case. */
 	if (this->location.w == 0) return;
 
+	_industry_spatial_index.Remove(this->index, this->location);
+
 	TILE_AREA_LOOP(tile_cur, this->location) {
 		if (IsTileType(tile_cur, MP_INDUSTRY)) {
 			if (GetIndustryIndex(tile_cur) == this->index) {
@@ -497,8 +501,6 @@ static void TransportIndustryGoods(TileIndex tile)
 	const IndustrySpec *indspec = GetIndustrySpec(i->type);
 	bool moved_cargo = false;
 
-	StationFinder stations(i->location);
-
 	for (uint j = 0; j < lengthof(i->produced_cargo_waiting); j++) {
 		uint cw = min(i->produced_cargo_waiting[j], 255);
 		if (cw > indspec->minimal_cargo && i->produced_cargo[j] != CT_INVALID) {
@@ -509,7 +511,7 @@ static void TransportIndustryGoods(TileIndex tile)
 
 			i->this_month_production[j] += cw;
 
-			uint am = MoveGoodsToStation(i->produced_cargo[j], cw, ST_INDUSTRY, i->index, stations.GetStations());
+			uint am = MoveGoodsToStation(i->produced_cargo[j], cw, ST_INDUSTRY, i->index, i->GetStationsNear());
 			i->this_month_transported[j] += am;
 
 			moved_cargo |= (am != 0);
@@ -1566,33 +1568,19 @@ static bool CheckIfCanLevelIndustryPlatform(TileIndex tile, DoCommandFlag flags,
 static CommandCost CheckIfFarEnoughFromConflictingIndustry(TileIndex tile, int type)
 {
 	const IndustrySpec *indspec = GetIndustrySpec(type);
-	const Industry *i = NULL;
 
-	/* On a large map with many industries, it may be faster to check an area. */
+	/* Within 14 tiles from another industry is considered close */
 	static const int dmax = 14;
-	if (Industry::GetNumItems() > (size_t) (dmax * dmax * 2)) {
-		const int tx = TileX(tile);
-		const int ty = TileY(tile);
-		TileArea tile_area = TileArea(TileXY(max(0, tx - dmax), max(0, ty - dmax)), TileXY(min(MapMaxX(), tx + dmax), min(MapMaxY(), ty + dmax)));
-		TILE_AREA_LOOP(atile, tile_area) {
-			if (GetTileType(atile) == MP_INDUSTRY) {
-				const Industry *i2 = Industry::GetByTile(atile);
-				if (i == i2) continue;
-				i = i2;
-				if (DistanceMax(tile, i->location.tile) > (uint)dmax) continue;
-				if (i->type == indspec->conflicting[0] ||
-						i->type == indspec->conflicting[1] ||
-						i->type == indspec->conflicting[2]) {
-					return_cmd_error(STR_ERROR_INDUSTRY_TOO_CLOSE);
-				}
-			}
-		}
-		return CommandCost();
-	}
+	const int tx = TileX(tile);
+	const int ty = TileY(tile);
+	TileArea tile_area = TileArea(TileXY(max(0, tx - dmax), max(0, ty - dmax)), TileXY(min(MapMaxX(), tx + dmax), min(MapMaxY(), ty + dmax)));
 
-	FOR_ALL_INDUSTRIES(i) {
-		/* Within 14 tiles from another industry is considered close */
-		if (DistanceMax(tile, i->location.tile) > 14) continue;
+	SpatialIndexItemList industries;
+	_industry_spatial_index.FindInArea(tile_area, &industries);
+
+	for (const uint16 *id = industries.Begin(); id != industries.End(); id++) {
+		const Industry *i = Industry::Get(*id);
+		if (DistanceMax(tile, i->location.tile) > (uint)dmax) continue;
 
 		/* check if there are any conflicting industry types around */
 		if (i->type == indspec->conflicting[0] ||
@@ -1772,6 +1760,8 @@ static void DoCreateNewIndustry(Industry *i, TileIndex tile, IndustryType type,
 		}
 	} while ((++it)->ti.x != -0x80);
 
+	_industry_spatial_index.Add(i->index, i->location);
+
 	if (GetIndustrySpec(i->type)->behaviour & INDUSTRYBEH_PLANT_ON_BUILT) {
 		for (uint j = 0; j != 50; j++) PlantRandomFarmField(i);
 	}
@@ -2109,6 +2099,8 @@ void IndustryBuildData::MonthlyLoop()
  */
 void GenerateIndustries()
 {
+	BenchmarkTimer timer(BE_GENWORLD_INDUSTRIES);
+
 	if (_game_mode != GM_EDITOR && _settings_game.difficulty.industry_density == ID_FUND_ONLY) return; // No industries in the game.
 
 	uint32 industry_probs[NUM_INDUSTRYTYPES];
@@ -2192,6 +2184,22 @@ void Industry::RecomputeProductionMultipliers()
 	this->production_rate[1] = min(CeilDiv(indspec->production_rate[1] * this->prod_level, PRODLEVEL_DEFAULT), 0xFF);
 }
 
+/**
+ * Get the stations around the industry that can receive its cargo.
+ * The list is kept until a station or its catchment changes, so the
+ * industry tiles don't search for the stations each tile loop.
+ * @return The stations around the industry, in the order #FindStationsAroundTiles finds them.
+ */
+const StationList *Industry::GetStationsNear()
+{
+	if (this->stations_near_version != _station_catchment_version) {
+		this->stations_near.Clear();
+		FindStationsAroundTiles(this->location, &this->stations_near);
+		this->stations_near_version = _station_catchment_version;
+	}
+	return &this->stations_near;
+}
+
 
 /**
  * Set the #probability and #min_number fields for the industry type \a it for a running game.
@@ -2382,10 +2390,9 @@ static void CanCargoServiceIndustry(CargoID cargo, Industry *ind, bool *c_accept
 static int WhoCanServiceIndustry(Industry *ind)
 {
 	/* Find all stations within reach of the industry */
-	StationList stations;
-	FindStationsAroundTiles(ind->location, &stations);
+	const StationList *stations = ind->GetStationsNear();
 
-	if (stations.Length() == 0) return 0; // No stations found at all => nobody services
+	if (stations->Length() == 0) return 0; // No stations found at all => nobody services
 
 	const Vehicle *v;
 	int result = 0;
@@ -2421,7 +2428,7 @@ static int WhoCanServiceIndustry(Industry *ind)
 				/* Same cargo produced by industry is dropped here => not serviced by vehicle v */
 				if ((o->GetUnloadType() & OUFB_UNLOAD) && !c_accepts) break;
 
-				if (stations.Contains(st)) {
+				if (stations->Contains(st)) {
 					if (v->owner == _local_company) return 2; // Company services industry
 					result = 1; // Competitor services industry
 				}
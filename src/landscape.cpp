@@ -30,9 +30,10 @@
 #include "core/random_func.hpp"
 #include "object_base.h"
 #include "company_func.h"
-#include "pathfinder/npf/aystar.h"
+#include "newgrf.h"
 #include "saveload/saveload.h"
-#include <list>
+#include "core/smallvec_type.hpp"
+#include "benchmark.h"
 #include <set>
 
 #include "table/strings.h"
@@ -739,14 +740,17 @@ void RunTileLoop()
 	/* The LFSR cannot have a zeroed state. */
 	assert(tile != 0);
 
+	/* Idle tiles do nothing, unless the ambient sound callback draws random numbers for them. */
+	bool skip_idle = !HasGrfMiscBit(GMB_AMBIENT_SOUND_CALLBACK);
+
 	/* Manually update tile 0 every 256 ticks - the LFSR never iterates over it itself.  */
 	if (_tick_counter % 256 == 0) {
-		_tile_type_procs[GetTileType(0)]->tile_loop_proc(0);
+		if (!skip_idle || !IsTileLoopIdle(0)) _tile_type_procs[GetTileType(0)]->tile_loop_proc(0);
 		count--;
 	}
 
 	while (count--) {
-		_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
+		if (!skip_idle || !IsTileLoopIdle(tile)) _tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
 
 		/* Get the next tile in sequence using a Galois LFSR. */
 		tile = (tile >> 1) ^ (-(int32)(tile & 1) & feedback);
@@ -889,36 +893,49 @@ static void GenerateTerrain(int type, uint flag)
 
 #include "table/genland.h"
 
-static void CreateDesertOrRainForest()
+/** Classification of the tiles of the map in tropic zones. */
+struct TropicZoneClassification {
+	bool *in_zone;          ///< For every tile whether it belongs in the zone.
+	uint max_desert_height; ///< Height from which tiles stop being desert.
+};
+
+/**
+ * Find the tiles of a region that are far enough away from water and high land for being desert.
+ * @param param   The #TropicZoneClassification.
+ * @param y_begin The first row of the region.
+ * @param y_end   The row after the last row of the region.
+ */
+static void ClassifyDesertRegion(void *param, uint y_begin, uint y_end)
 {
-	TileIndex update_freq = MapSize() / 4;
+	TropicZoneClassification *tzc = (TropicZoneClassification *)param;
 	const TileIndexDiffC *data;
-	uint max_desert_height = CeilDiv(_settings_game.construction.max_heightlevel, 4);
-
-	for (TileIndex tile = 0; tile != MapSize(); ++tile) {
-		if ((tile % update_freq) == 0) IncreaseGeneratingWorldProgress(GWP_LANDSCAPE);
 
+	for (TileIndex tile = TileXY(0, y_begin); tile != TileXY(0, y_end); ++tile) {
+		tzc->in_zone[tile] = false;
 		if (!IsValidTile(tile)) continue;
 
 		for (data = _make_desert_or_rainforest_data;
 				data != endof(_make_desert_or_rainforest_data); ++data) {
 			TileIndex t = AddTileIndexDiffCWrap(tile, *data);
-			if (t != INVALID_TILE && (TileHeight(t) >= max_desert_height || IsTileType(t, MP_WATER))) break;
+			if (t != INVALID_TILE && (TileHeight(t) >= tzc->max_desert_height || IsTileType(t, MP_WATER))) break;
 		}
-		if (data == endof(_make_desert_or_rainforest_data)) {
-			SetTropicZone(tile, TROPICZONE_DESERT);
-		}
-	}
-
-	for (uint i = 0; i != 256; i++) {
-		if ((i % 64) == 0) IncreaseGeneratingWorldProgress(GWP_LANDSCAPE);
-
-		RunTileLoop();
+		tzc->in_zone[tile] = (data == endof(_make_desert_or_rainforest_data));
 	}
+}
 
-	for (TileIndex tile = 0; tile != MapSize(); ++tile) {
-		if ((tile % update_freq) == 0) IncreaseGeneratingWorldProgress(GWP_LANDSCAPE);
+/**
+ * Find the tiles of a region that are far enough away from desert ground for being rainforest.
+ * @param param   The #TropicZoneClassification.
+ * @param y_begin The first row of the region.
+ * @param y_end   The row after the last row of the region.
+ */
+static void ClassifyRainForestRegion(void *param, uint y_begin, uint y_end)
+{
+	TropicZoneClassification *tzc = (TropicZoneClassification *)param;
+	const TileIndexDiffC *data;
 
+	for (TileIndex tile = TileXY(0, y_begin); tile != TileXY(0, y_end); ++tile) {
+		tzc->in_zone[tile] = false;
 		if (!IsValidTile(tile)) continue;
 
 		for (data = _make_desert_or_rainforest_data;
@@ -926,10 +943,49 @@ static void CreateDesertOrRainForest()
 			TileIndex t = AddTileIndexDiffCWrap(tile, *data);
 			if (t != INVALID_TILE && IsTileType(t, MP_CLEAR) && IsClearGround(t, CLEAR_DESERT)) break;
 		}
-		if (data == endof(_make_desert_or_rainforest_data)) {
-			SetTropicZone(tile, TROPICZONE_RAINFOREST);
-		}
+		tzc->in_zone[tile] = (data == endof(_make_desert_or_rainforest_data));
+	}
+}
+
+/**
+ * Classify the map in parts, with multiple threads, and put the classified tiles in a tropic zone.
+ * Classifying only reads the tiles, so the zones are only changed once all tiles are classified.
+ * @param proc The procedure classifying a region.
+ * @param tzc  The classification.
+ * @param zone The zone to put the classified tiles in.
+ */
+static void SetClassifiedTropicZone(GWRegionProc *proc, TropicZoneClassification *tzc, TropicZone zone)
+{
+	/* Report the progress per quarter of the map. */
+	for (uint i = 0; i < 4; i++) {
+		IncreaseGeneratingWorldProgress(GWP_LANDSCAPE);
+		GenerateWorldRegions(proc, tzc, MapSizeY() * i / 4, MapSizeY() * (i + 1) / 4);
+	}
+
+	for (TileIndex tile = 0; tile != MapSize(); ++tile) {
+		if (tzc->in_zone[tile]) SetTropicZone(tile, zone);
+	}
+}
+
+static void CreateDesertOrRainForest()
+{
+	BenchmarkTimer timer(BE_GENWORLD_TROPIC_ZONE);
+
+	TropicZoneClassification tzc;
+	tzc.in_zone = MallocT<bool>(MapSize());
+	tzc.max_desert_height = CeilDiv(_settings_game.construction.max_heightlevel, 4);
+
+	SetClassifiedTropicZone(&ClassifyDesertRegion, &tzc, TROPICZONE_DESERT);
+
+	for (uint i = 0; i != 256; i++) {
+		if ((i % 64) == 0) IncreaseGeneratingWorldProgress(GWP_LANDSCAPE);
+
+		RunTileLoop();
 	}
+
+	SetClassifiedTropicZone(&ClassifyRainForestRegion, &tzc, TROPICZONE_RAINFOREST);
+
+	free(tzc.in_zone);
 }
 
 /**
@@ -1013,172 +1069,259 @@ static bool FlowsDown(TileIndex begin, TileIndex end)
 			((slopeEnd == slopeBegin && heightEnd < heightBegin) || slopeEnd == SLOPE_FLAT || slopeBegin == SLOPE_FLAT);
 }
 
-/* AyStar callback for checking whether we reached our destination. */
-static int32 River_EndNodeCheck(AyStar *aystar, OpenListNode *current)
-{
-	return current->path.node.tile == *(TileIndex*)aystar->user_target ? AYSTAR_FOUND_END_NODE : AYSTAR_DONE;
-}
+/** Number of distance buckets of the river flow map; more than the highest cost of entering a tile. */
+static const uint RIVER_FLOW_BUCKETS = 256;
+/** Minimum number of tiles draining into the floor of a basin for making a lake there. */
+static const uint RIVER_LAKE_MIN_BASIN = 32;
+
+/**
+ * Direction and amount of the flow of water over the whole map. Every land tile
+ * flows along the cheapest way down to water, where entering a tile costs a
+ * random amount to make the rivers meander. Tiles that cannot reach any water
+ * flow to the floor of their basin instead, where lakes can be made.
+ */
+struct RiverFlowMap {
+	byte *dir;     ///< Direction the water flows to from each tile, or #INVALID_DIAGDIR when it does not flow anywhere.
+	byte *cost;    ///< Cost of entering each tile; afterwards the number of tiles directly flowing into each tile.
+	uint32 *dist;  ///< Cost of the way from each tile to where its water ends; afterwards the number of tiles flowing through each tile.
+	uint queued;   ///< Number of tiles in #buckets.
+	SmallVector<TileIndex, 256> buckets[RIVER_FLOW_BUCKETS]; ///< Tiles to spread the flow from, by their distance.
+};
+
+/** Global river flow map instance */
+static RiverFlowMap _river_flow;
 
-/* AyStar callback for getting the cost of the current node. */
-static int32 River_CalculateG(AyStar *aystar, AyStarNode *current, OpenListNode *parent)
+/** Free the river flow map. */
+static void FreeRiverFlowMap()
 {
-	return 1 + RandomRange(_settings_game.game_creation.river_route_random);
+	free(_river_flow.dir);
+	free(_river_flow.cost);
+	free(_river_flow.dist);
+	_river_flow.dir = NULL;
+	_river_flow.cost = NULL;
+	_river_flow.dist = NULL;
+
+	for (uint i = 0; i < RIVER_FLOW_BUCKETS; i++) _river_flow.buckets[i].Reset();
+	_river_flow.queued = 0;
 }
 
-/* AyStar callback for getting the estimated cost to the destination. */
-static int32 River_CalculateH(AyStar *aystar, AyStarNode *current, OpenListNode *parent)
+/**
+ * Queue a tile to spread the flow from.
+ * @param tile The tile.
+ * @param dist The cost of the way from the tile to where its water ends.
+ */
+static inline void RiverFlowQueue(TileIndex tile, uint32 dist)
 {
-	return DistanceManhattan(*(TileIndex*)aystar->user_target, current->tile);
+	_river_flow.dist[tile] = dist;
+	*_river_flow.buckets[dist % RIVER_FLOW_BUCKETS].Append() = tile;
+	_river_flow.queued++;
 }
 
-/* AyStar callback for getting the neighbouring nodes of the given node. */
-static void River_GetNeighbours(AyStar *aystar, OpenListNode *current)
+/**
+ * Spread the flow upstream from the queued tiles, so every tile that can flow
+ * down to them gets the direction of its cheapest way there. Entering a tile
+ * costs less than #RIVER_FLOW_BUCKETS, so the buckets can be used round-robin
+ * instead of sorting the tiles by their distance.
+ * @param start The lowest distance of the queued tiles.
+ * @return A distance beyond the distance of all tiles the flow has been spread to.
+ */
+static uint32 RiverFlowSpread(uint32 start)
 {
-	TileIndex tile = current->path.node.tile;
+	uint32 d;
+	for (d = start; _river_flow.queued != 0; d++) {
+		SmallVector<TileIndex, 256> &bucket = _river_flow.buckets[d % RIVER_FLOW_BUCKETS];
 
-	aystar->num_neighbours = 0;
-	for (DiagDirection d = DIAGDIR_BEGIN; d < DIAGDIR_END; d++) {
-		TileIndex t2 = tile + TileOffsByDiagDir(d);
-		if (IsValidTile(t2) && FlowsDown(tile, t2)) {
-			aystar->neighbours[aystar->num_neighbours].tile = t2;
-			aystar->neighbours[aystar->num_neighbours].direction = INVALID_TRACKDIR;
-			aystar->num_neighbours++;
-		}
-	}
-}
+		for (uint i = 0; i < bucket.Length(); i++) {
+			TileIndex down = bucket[i];
 
-/* AyStar callback when an route has been found. */
-static void River_FoundEndNode(AyStar *aystar, OpenListNode *current)
-{
-	for (PathNode *path = &current->path; path != NULL; path = path->parent) {
-		TileIndex tile = path->node.tile;
-		if (!IsWaterTile(tile)) {
-			MakeRiver(tile, Random());
-			/* Remove desert directly around the river tile. */
-			CircularTileSearch(&tile, 5, RiverModifyDesertZone, NULL);
+			/* The tile has been queued again with a cheaper way. */
+			if (_river_flow.dist[down] != d) continue;
+
+			for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+				TileIndex up = down + TileOffsByDiagDir(dir);
+				if (!IsValidTile(up) || IsWaterTile(up) || !FlowsDown(up, down)) continue;
+
+				uint32 dist = d + _river_flow.cost[up];
+				if (dist >= _river_flow.dist[up]) continue;
+
+				_river_flow.dir[up] = ReverseDiagDir(dir);
+				RiverFlowQueue(up, dist);
+			}
 		}
+
+		_river_flow.queued -= bucket.Length();
+		bucket.Clear();
 	}
-}
 
-static const uint RIVER_HASH_SIZE = 8; ///< The number of bits the hash for river finding should have.
+	return d;
+}
 
 /**
- * Simple hash function for river tiles to be used by AyStar.
- * @param tile The tile to hash.
- * @param dir The unused direction.
- * @return The hash for the tile.
+ * Count the tiles flowing through each tile, by passing the counts down from
+ * the tiles no other tiles flow into.
  */
-static uint River_Hash(uint tile, uint dir)
+static void RiverFlowAccumulate()
 {
-	return GB(TileHash(TileX(tile), TileY(tile)), 0, RIVER_HASH_SIZE);
+	byte *inflow = _river_flow.cost;
+	uint32 *amount = _river_flow.dist;
+	SmallVector<TileIndex, 256> &queue = _river_flow.buckets[0];
+
+	MemSetT(inflow, 0, MapSize());
+	for (TileIndex tile = 0; tile < MapSize(); tile++) {
+		amount[tile] = 1;
+		if (_river_flow.dir[tile] != INVALID_DIAGDIR) inflow[tile + TileOffsByDiagDir((DiagDirection)_river_flow.dir[tile])]++;
+	}
+
+	for (TileIndex tile = 0; tile < MapSize(); tile++) {
+		if (inflow[tile] == 0 && _river_flow.dir[tile] != INVALID_DIAGDIR) *queue.Append() = tile;
+	}
+
+	while (queue.Length() != 0) {
+		TileIndex up = *(queue.End() - 1);
+		queue.Resize(queue.Length() - 1);
+
+		TileIndex down = up + TileOffsByDiagDir((DiagDirection)_river_flow.dir[up]);
+		amount[down] += amount[up];
+		if (--inflow[down] == 0 && _river_flow.dir[down] != INVALID_DIAGDIR) *queue.Append() = down;
+	}
 }
 
 /**
- * Actually build the river between the begin and end tiles using AyStar.
- * @param begin The begin of the river.
- * @param end The end of the river.
+ * Determine where the water of every tile flows to, and how much water flows
+ * through every tile.
  */
-static void BuildRiver(TileIndex begin, TileIndex end)
+static void BuildRiverFlowMap()
 {
-	AyStar finder;
-	MemSetT(&finder, 0);
-	finder.CalculateG = River_CalculateG;
-	finder.CalculateH = River_CalculateH;
-	finder.GetNeighbours = River_GetNeighbours;
-	finder.EndNodeCheck = River_EndNodeCheck;
-	finder.FoundEndNode = River_FoundEndNode;
-	finder.user_target = &end;
-
-	finder.Init(River_Hash, 1 << RIVER_HASH_SIZE);
-
-	AyStarNode start;
-	start.tile = begin;
-	start.direction = INVALID_TRACKDIR;
-	finder.AddStartNode(&start, 0);
-	finder.Main();
-	finder.Free();
+	_river_flow.dir = MallocT<byte>(MapSize());
+	_river_flow.cost = MallocT<byte>(MapSize());
+	_river_flow.dist = MallocT<uint32>(MapSize());
+	MemSetT(_river_flow.dir, INVALID_DIAGDIR, MapSize());
+	MemSetT(_river_flow.dist, 0xFF, MapSize());
+	_river_flow.queued = 0;
+
+	/* Water flows to the sea, lakes and existing rivers first. */
+	for (TileIndex tile = 0; tile < MapSize(); tile++) {
+		_river_flow.cost[tile] = 1 + RandomRange(_settings_game.game_creation.river_route_random);
+		if (IsWaterTile(tile)) RiverFlowQueue(tile, 0);
+	}
+	uint32 basin_dist = RiverFlowSpread(0);
+	IncreaseGeneratingWorldProgress(GWP_RIVER);
+
+	/* Water that cannot get there ends up in the lowest parts of its basin.
+	 * The floors are put beyond all tiles that reach water, so those keep
+	 * their way to water even when a basin would be cheaper to reach. */
+	for (TileIndex tile = 0; tile < MapSize(); tile++) {
+		if (_river_flow.dist[tile] != UINT32_MAX || !IsValidTile(tile)) continue;
+
+		uint height = TileHeight(tile);
+		bool lowest = true;
+		for (DiagDirection d = DIAGDIR_BEGIN; d < DIAGDIR_END; d++) {
+			TileIndex t2 = tile + TileOffsByDiagDir(d);
+			if (IsValidTile(t2) && TileHeight(t2) < height && FlowsDown(tile, t2)) {
+				lowest = false;
+				break;
+			}
+		}
+		if (lowest) RiverFlowQueue(tile, basin_dist);
+	}
+	RiverFlowSpread(basin_dist);
+	IncreaseGeneratingWorldProgress(GWP_RIVER);
+
+	RiverFlowAccumulate();
+	IncreaseGeneratingWorldProgress(GWP_RIVER);
 }
 
 /**
- * Try to flow the river down from a given begin.
+ * Try to make a lake in the basin a river ends in.
  * @param spring The springing point of the river.
- * @param begin  The begin point we are looking from; somewhere down hill from the spring.
- * @return True iff a river could/has been built, otherwise false.
+ * @param entry  The tile of the floor of the basin the river reaches.
+ * @param river  The tiles of the river; the way from the entry to the lake gets added.
+ * @return True iff a lake has been made, otherwise false.
  */
-static bool FlowRiver(TileIndex spring, TileIndex begin)
+static bool MakeRiverLake(TileIndex spring, TileIndex entry, SmallVector<TileIndex, 64> &river)
 {
-	#define SET_MARK(x) marks.insert(x)
-	#define IS_MARKED(x) (marks.find(x) != marks.end())
-
-	uint height = TileHeight(begin);
-	if (IsWaterTile(begin)) return DistanceManhattan(spring, begin) > _settings_game.game_creation.min_river_length;
+	/* A river, or lake, can only be built on flat slopes. */
+	if (!IsTileFlat(entry)) return false;
+	uint height = TileHeight(entry);
 
+	/* Find the flat floor of the basin, and count the tiles flowing into it. */
+	SmallVector<TileIndex, 64> floor;
+	SmallVector<uint, 64> parent;
 	std::set<TileIndex> marks;
-	SET_MARK(begin);
-
-	/* Breadth first search for the closest tile we can flow down to. */
-	std::list<TileIndex> queue;
-	queue.push_back(begin);
-
-	bool found = false;
-	uint count = 0; // Number of tiles considered; to be used for lake location guessing.
-	TileIndex end;
-	do {
-		end = queue.front();
-		queue.pop_front();
-
-		uint height2 = TileHeight(end);
-		if (IsTileFlat(end) && (height2 < height || (height2 == height && IsWaterTile(end)))) {
-			found = true;
-			break;
-		}
+	*floor.Append() = entry;
+	*parent.Append() = 0;
+	marks.insert(entry);
+
+	uint basin = 0;
+	for (uint i = 0; i < floor.Length(); i++) {
+		TileIndex tile = floor[i];
+		basin += _river_flow.dist[tile];
 
 		for (DiagDirection d = DIAGDIR_BEGIN; d < DIAGDIR_END; d++) {
-			TileIndex t2 = end + TileOffsByDiagDir(d);
-			if (IsValidTile(t2) && !IS_MARKED(t2) && FlowsDown(end, t2)) {
-				SET_MARK(t2);
-				count++;
-				queue.push_back(t2);
-			}
-		}
-	} while (!queue.empty());
-
-	if (found) {
-		/* Flow further down hill. */
-		found = FlowRiver(spring, end);
-	} else if (count > 32) {
-		/* Maybe we can make a lake. Find the Nth of the considered tiles. */
-		TileIndex lakeCenter = 0;
-		int i = RandomRange(count - 1) + 1;
-		std::set<TileIndex>::const_iterator cit = marks.begin();
-		while (--i) cit++;
-		lakeCenter = *cit;
-
-		if (IsValidTile(lakeCenter) &&
-				/* A river, or lake, can only be built on flat slopes. */
-				IsTileFlat(lakeCenter) &&
-				/* We want the lake to be built at the height of the river. */
-				TileHeight(begin) == TileHeight(lakeCenter) &&
-				/* We don't want the lake at the entry of the valley. */
-				lakeCenter != begin &&
-				/* We don't want lakes in the desert. */
-				(_settings_game.game_creation.landscape != LT_TROPIC || GetTropicZone(lakeCenter) != TROPICZONE_DESERT) &&
-				/* We only want a lake if the river is long enough. */
-				DistanceManhattan(spring, lakeCenter) > _settings_game.game_creation.min_river_length) {
-			end = lakeCenter;
-			MakeRiver(lakeCenter, Random());
-			uint range = RandomRange(8) + 3;
-			CircularTileSearch(&lakeCenter, range, MakeLake, &height);
-			/* Call the search a second time so artefacts from going circular in one direction get (mostly) hidden. */
-			lakeCenter = end;
-			CircularTileSearch(&lakeCenter, range, MakeLake, &height);
-			found = true;
+			TileIndex t2 = tile + TileOffsByDiagDir(d);
+			if (!IsValidTile(t2) || _river_flow.dir[t2] != INVALID_DIAGDIR || IsWaterTile(t2) ||
+					TileHeight(t2) != height || !IsTileFlat(t2) || marks.find(t2) != marks.end()) continue;
+
+			marks.insert(t2);
+			*floor.Append() = t2;
+			*parent.Append() = i;
 		}
 	}
 
-	marks.clear();
-	if (found) BuildRiver(begin, end);
-	return found;
+	if (basin <= RIVER_LAKE_MIN_BASIN) return false;
+
+	uint i = RandomRange(floor.Length());
+	TileIndex lakeCenter = floor[i];
+
+	/* We don't want lakes in the desert. */
+	if (_settings_game.game_creation.landscape == LT_TROPIC && GetTropicZone(lakeCenter) == TROPICZONE_DESERT) return false;
+	/* We only want a lake if the river is long enough. */
+	if (DistanceManhattan(spring, lakeCenter) <= _settings_game.game_creation.min_river_length) return false;
+
+	/* Let the river flow over the floor to the lake. */
+	for (; i != 0; i = parent[i]) *river.Append() = floor[i];
+
+	TileIndex tile = lakeCenter;
+	MakeRiver(tile, Random());
+	uint range = RandomRange(8) + 3;
+	CircularTileSearch(&tile, range, MakeLake, &height);
+	/* Call the search a second time so artefacts from going circular in one direction get (mostly) hidden. */
+	tile = lakeCenter;
+	CircularTileSearch(&tile, range, MakeLake, &height);
+	return true;
+}
+
+/**
+ * Try to flow a river down from a spring along the river flow map.
+ * @param spring The springing point of the river.
+ * @return True iff a river has been built, otherwise false.
+ */
+static bool FlowRiver(TileIndex spring)
+{
+	SmallVector<TileIndex, 64> river;
+
+	TileIndex end = spring;
+	while (!IsWaterTile(end)) {
+		*river.Append() = end;
+		if (_river_flow.dir[end] == INVALID_DIAGDIR) break;
+		end += TileOffsByDiagDir((DiagDirection)_river_flow.dir[end]);
+	}
+
+	if (IsWaterTile(end)) {
+		if (DistanceManhattan(spring, end) <= _settings_game.game_creation.min_river_length) return false;
+	} else if (!MakeRiverLake(spring, end, river)) {
+		return false;
+	}
+
+	for (uint i = 0; i < river.Length(); i++) {
+		TileIndex tile = river[i];
+		if (IsWaterTile(tile)) continue;
+
+		MakeRiver(tile, Random());
+		/* Remove desert directly around the river tile. */
+		CircularTileSearch(&tile, 5, RiverModifyDesertZone, NULL);
+	}
+	return true;
 }
 
 /**
@@ -1186,21 +1329,30 @@ static bool FlowRiver(TileIndex spring, TileIndex begin)
  */
 static void CreateRivers()
 {
+	BenchmarkTimer timer(BE_GENWORLD_RIVERS);
+
 	int amount = _settings_game.game_creation.amount_of_rivers;
 	if (amount == 0) return;
 
 	uint wells = ScaleByMapSize(4 << _settings_game.game_creation.amount_of_rivers);
-	SetGeneratingWorldProgress(GWP_RIVER, wells + 256 / 64); // Include the tile loop calls below.
+	SetGeneratingWorldProgress(GWP_RIVER, 3 + wells + 256 / 64); // Include the flow map and the tile loop calls below.
+
+	/* Building the flow map can already be aborted. */
+	GenerateWorldSetAbortCallback(FreeRiverFlowMap);
+	BuildRiverFlowMap();
 
 	for (; wells != 0; wells--) {
 		IncreaseGeneratingWorldProgress(GWP_RIVER);
 		for (int tries = 0; tries < 128; tries++) {
 			TileIndex t = RandomTile();
 			if (!CircularTileSearch(&t, 8, FindSpring, NULL)) continue;
-			if (FlowRiver(t, t)) break;
+			if (FlowRiver(t)) break;
 		}
 	}
 
+	FreeRiverFlowMap();
+	GenerateWorldSetAbortCallback(NULL);
+
 	/* Run tile loop to update the ground density. */
 	for (uint i = 0; i != 256; i++) {
 		if (i % 64 == 0) IncreaseGeneratingWorldProgress(GWP_RIVER);
@@ -1208,8 +1360,14 @@ static void CreateRivers()
 	}
 }
 
-void GenerateLandscape(byte mode)
+/**
+ * Generate the terrain of the landscape, and fill the sea.
+ * @param mode The mode of world generation.
+ */
+static void GenerateLandscapeTerrain(byte mode)
 {
+	BenchmarkTimer timer(BE_GENWORLD_TERRAIN);
+
 	/** Number of steps of landscape generation */
 	enum GenLandscapeSteps {
 		GLS_HEIGHTMAP    =  3, ///< Loading a heightmap
@@ -1288,6 +1446,11 @@ void GenerateLandscape(byte mode)
 	IncreaseGeneratingWorldProgress(GWP_LANDSCAPE);
 	ConvertGroundTilesIntoWaterTiles();
 	IncreaseGeneratingWorldProgress(GWP_LANDSCAPE);
+}
+
+void GenerateLandscape(byte mode)
+{
+	GenerateLandscapeTerrain(mode);
 
 	if (_settings_game.game_creation.landscape == LT_TROPIC) CreateDesertOrRainForest();
 
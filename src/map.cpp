@@ -31,6 +31,8 @@ uint _map_tile_mask; ///< _map_size - 1 (to mask the mapsize)
 
 Tile *_m = NULL;          ///< Tiles of the map
 TileExtended *_me = NULL; ///< Extended Tiles of the map
+byte *_tile_loop_idle = NULL; ///< Tiles of the map whose tile loop does nothing
+bool _tile_loop_idle_deferred = false; ///< Whether changes of tiles leave #_tile_loop_idle alone, as it is cleared afterwards for all changed tiles.
 
 
 /**
@@ -60,9 +62,11 @@ void AllocateMap(uint size_x, uint size_y)
 
 	free(_m);
 	free(_me);
+	free(_tile_loop_idle);
 
 	_m = CallocT<Tile>(_map_size);
 	_me = CallocT<TileExtended>(_map_size);
+	_tile_loop_idle = CallocT<byte>(CeilDiv(_map_size, 8));
 }
 
 
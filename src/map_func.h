@@ -43,6 +43,16 @@ extern Tile *_m;
  */
 extern TileExtended *_me;
 
+/**
+ * Bitmap of the tiles whose tile loop is known to do nothing.
+ *
+ * A tile loop proc may mark its tile idle when it will do nothing until the
+ * type of the tile or of one of its neighbours changes; changing the type of
+ * a tile marks it and its neighbours active again.
+ */
+extern byte *_tile_loop_idle;
+extern bool _tile_loop_idle_deferred;
+
 void AllocateMap(uint size_x, uint size_y);
 
 /**
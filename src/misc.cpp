@@ -45,6 +45,8 @@ void InitializeDockGui();
 void InitializeObjectGui();
 void InitializeIndustries();
 void InitializeObjects();
+void InitializeStationCatchmentIndex();
+void InitializeSpatialIndices();
 void InitializeTrees();
 void InitializeCompanies();
 void InitializeCheats();
@@ -92,6 +94,8 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	InitializeTrees();
 	InitializeIndustries();
 	InitializeObjects();
+	InitializeStationCatchmentIndex();
+	InitializeSpatialIndices();
 	InitializeBuildingCounts();
 
 	InitializeNPF();
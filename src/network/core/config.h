@@ -33,6 +33,7 @@ static const uint16 NETWORK_ADMIN_PORT            = 3977;         ///< The defau
 static const uint16 NETWORK_DEFAULT_DEBUGLOG_PORT = 3982;         ///< The default port debug-log is sent to (TCP)
 
 static const uint16 SEND_MTU                      = 1460;         ///< Number of bytes we can pack in a single packet
+static const uint16 BATCH_MAX_CONTENT_SIZE        = 4 * SEND_MTU; ///< Maximum size of the uncompressed content of a PACKET_SERVER_BATCH
 
 static const byte NETWORK_GAME_ADMIN_VERSION      =    1;         ///< What version of the admin network do we use?
 static const byte NETWORK_GAME_INFO_VERSION       =    4;         ///< What version of game-info do we use?
@@ -184,6 +184,18 @@ static inline void OTTDfreeaddrinfo(struct addrinfo *ai)
 #	include <errno.h>
 #	include <sys/time.h>
 #	include <netdb.h>
+
+/* Gather writes, to send many queued packets with one system call. */
+#	if !defined(__MORPHOS__) && !defined(__AMIGA__) && !defined(__BEOS__)
+#		include <sys/uio.h>
+#		define HAVE_SENDMSG
+#	endif
+
+/* Linux can poll many sockets efficiently with epoll. */
+#	if defined(__linux__)
+#		include <sys/epoll.h>
+#		define HAVE_EPOLL
+#	endif
 #endif /* UNIX */
 
 #ifdef __BEOS__
@@ -28,11 +28,12 @@ Packet::Packet(NetworkSocketHandler *cs)
 {
 	assert(cs != NULL);
 
-	this->cs     = cs;
-	this->next   = NULL;
-	this->pos    = 0; // We start reading from here
-	this->size   = 0;
-	this->buffer = MallocT<byte>(SEND_MTU);
+	this->cs         = cs;
+	this->next       = NULL;
+	this->pos        = 0; // We start reading from here
+	this->size       = 0;
+	this->buffer     = MallocT<byte>(SEND_MTU);
+	this->references = 1;
 }
 
 /**
@@ -43,6 +44,7 @@ Packet::Packet(PacketType type)
 {
 	this->cs                   = NULL;
 	this->next                 = NULL;
+	this->references           = 1;
 
 	/* Skip the size so we can write that in before sending the packet */
 	this->pos                  = 0;
@@ -60,7 +62,18 @@ Packet::~Packet()
 }
 
 /**
- * Writes the packet size from the raw packet from packet->size
+ * Remove an owner from this packet; the packet is freed when nobody owns it anymore.
+ */
+void Packet::Release()
+{
+	assert(this->references > 0);
+	if (--this->references == 0) delete this;
+}
+
+/**
+ * Writes the packet size from the raw packet from packet->size, and
+ * releases the unused part of the buffer. A packet that is shared
+ * between sockets must be prepared once, before it is shared.
  */
 void Packet::PrepareToSend()
 {
@@ -70,6 +83,11 @@ void Packet::PrepareToSend()
 	this->buffer[1] = GB(this->size, 8, 8);
 
 	this->pos  = 0; // We start reading from here
+
+	/* Reallocate the packet as in 99+% of the times we send at most 25 bytes and
+	 * keeping the other 1400+ bytes wastes memory, especially when someone tries
+	 * to do a denial of service attack! */
+	this->buffer = ReallocT(this->buffer, this->size);
 }
 
 /*
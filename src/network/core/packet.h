@@ -54,6 +54,12 @@ struct Packet {
 	PacketSize pos;
 	/** The buffer of this packet, of basically variable length up to SEND_MTU. */
 	byte *buffer;
+	/**
+	 * The number of owners of this packet; its creator and every send
+	 * queue it is in. Once queued it must not be changed anymore, as the
+	 * same packet may be queued for many sockets.
+	 */
+	uint references;
 
 private:
 	/** Socket we're associated with. */
@@ -67,6 +73,10 @@ public:
 	/* Sending/writing of packets */
 	void PrepareToSend();
 
+	/** Add an owner to this packet, e.g. when queueing it for another socket. */
+	inline void AddReference() { this->references++; }
+	void Release();
+
 	void Send_bool  (bool   data);
 	void Send_uint8 (uint8  data);
 	void Send_uint16(uint16 data);
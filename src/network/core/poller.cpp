@@ -0,0 +1,276 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file poller.cpp Implementations of waiting for readiness of many sockets at once.
+ */
+
+#ifdef ENABLE_NETWORK
+
+#include "../../stdafx.h"
+#include "../../debug.h"
+
+#include "poller.h"
+
+#include "../../safeguards.h"
+
+/**
+ * Invalidate the events of the last poll for the given socket, so the
+ * caller does not act upon a socket (or handler) that is gone.
+ * @param s The socket that is being removed.
+ */
+void SocketPoller::InvalidateEvents(SOCKET s)
+{
+	for (SocketPollEvent *ev = this->events.Begin(); ev != this->events.End(); ev++) {
+		if (ev->sock != s) continue;
+		ev->sock = INVALID_SOCKET;
+		ev->handler = NULL;
+		ev->flags = SPF_NONE;
+	}
+}
+
+/**
+ * Add a handler to the list of handlers that have something to send.
+ * @param handler The handler; it may not be in the list yet.
+ */
+void SocketPoller::AddSendPending(NetworkTCPSocketHandler *handler)
+{
+	*this->send_pending.Append() = handler;
+}
+
+/**
+ * Remove a handler from the list of handlers that have something to send.
+ * Its entry is only cleared, so the list can be removed from while it is
+ * being walked; #CompactSendPending drops the cleared entries.
+ * @param handler The handler to remove.
+ */
+void SocketPoller::RemoveSendPending(NetworkTCPSocketHandler *handler)
+{
+	for (NetworkTCPSocketHandler **h = this->send_pending.Begin(); h != this->send_pending.End(); h++) {
+		if (*h == handler) *h = NULL;
+	}
+}
+
+/**
+ * Drop the entries of removed handlers from the list of handlers that have something to send.
+ */
+void SocketPoller::CompactSendPending()
+{
+	uint count = 0;
+	for (uint i = 0; i < this->send_pending.Length(); i++) {
+		if (this->send_pending[i] != NULL) this->send_pending[count++] = this->send_pending[i];
+	}
+	this->send_pending.Resize(count);
+}
+
+/**
+ * Poller based on select. Works everywhere, but the file descriptor sets
+ * have to be rebuilt on every poll and it is limited to FD_SETSIZE.
+ */
+class SelectSocketPoller : public SocketPoller {
+	/** Registration of a single socket. */
+	struct Entry {
+		SOCKET sock;                      ///< The registered socket.
+		NetworkTCPSocketHandler *handler; ///< Its handler.
+		bool write;                       ///< Whether to poll for writability.
+	};
+
+	SmallVector<Entry, 16> entries; ///< All registered sockets.
+
+	/**
+	 * Find the registration of a socket.
+	 * @param s The socket to look for.
+	 * @return The registration, or \c NULL when not registered.
+	 */
+	Entry *Find(SOCKET s)
+	{
+		for (Entry *e = this->entries.Begin(); e != this->entries.End(); e++) {
+			if (e->sock == s) return e;
+		}
+		return NULL;
+	}
+
+public:
+	/* virtual */ bool Add(SOCKET s, NetworkTCPSocketHandler *handler)
+	{
+		assert(this->Find(s) == NULL);
+		Entry *e = this->entries.Append();
+		e->sock = s;
+		e->handler = handler;
+		e->write = false;
+		return true;
+	}
+
+	/* virtual */ void Remove(SOCKET s)
+	{
+		Entry *e = this->Find(s);
+		if (e != NULL) this->entries.Erase(e);
+		this->InvalidateEvents(s);
+	}
+
+	/* virtual */ void SetWriteInterest(SOCKET s, bool write)
+	{
+		Entry *e = this->Find(s);
+		if (e != NULL) e->write = write;
+	}
+
+	/* virtual */ bool Poll()
+	{
+		fd_set read_fd, write_fd;
+		struct timeval tv;
+
+		this->events.Clear();
+
+		FD_ZERO(&read_fd);
+		FD_ZERO(&write_fd);
+
+		for (const Entry *e = this->entries.Begin(); e != this->entries.End(); e++) {
+			FD_SET(e->sock, &read_fd);
+			if (e->write) FD_SET(e->sock, &write_fd);
+		}
+
+		tv.tv_sec = tv.tv_usec = 0; // don't block at all.
+#if !defined(__MORPHOS__) && !defined(__AMIGA__)
+		if (select(FD_SETSIZE, &read_fd, &write_fd, NULL, &tv) < 0) return false;
+#else
+		if (WaitSelect(FD_SETSIZE, &read_fd, &write_fd, NULL, &tv, NULL) < 0) return false;
+#endif
+
+		for (const Entry *e = this->entries.Begin(); e != this->entries.End(); e++) {
+			SocketPollFlags flags = SPF_NONE;
+			if (FD_ISSET(e->sock, &read_fd)) flags |= SPF_READ;
+			if (FD_ISSET(e->sock, &write_fd)) flags |= SPF_WRITE;
+			if (flags == SPF_NONE) continue;
+
+			SocketPollEvent *ev = this->events.Append();
+			ev->sock = e->sock;
+			ev->handler = e->handler;
+			ev->flags = flags;
+		}
+		return true;
+	}
+};
+
+#ifdef HAVE_EPOLL
+/**
+ * Poller based on Linux' epoll. The kernel keeps the set of sockets, so
+ * polling only costs time for the sockets that are actually ready.
+ */
+class EpollSocketPoller : public SocketPoller {
+	int epoll_fd;                                         ///< The epoll instance.
+	uint registered;                                      ///< Number of registered sockets.
+	SmallVector<NetworkTCPSocketHandler *, 64> handlers;  ///< Handler for each registered socket, indexed by socket.
+	SmallVector<struct epoll_event, 64> ready;            ///< Buffer for epoll_wait.
+
+	/**
+	 * Change the registration of a socket.
+	 * @param op    The epoll_ctl operation.
+	 * @param s     The socket to change.
+	 * @param write Whether to poll for writability.
+	 * @return True iff epoll_ctl succeeded.
+	 */
+	bool Control(int op, SOCKET s, bool write)
+	{
+		struct epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		if (write) ev.events |= EPOLLOUT;
+		ev.data.fd = s;
+		if (epoll_ctl(this->epoll_fd, op, s, &ev) == 0) return true;
+
+		DEBUG(net, 0, "epoll_ctl failed with error %d", GET_LAST_ERROR());
+		return false;
+	}
+
+public:
+	/**
+	 * Create the poller.
+	 * @param epoll_fd The epoll instance to use; will be closed on destruction.
+	 */
+	EpollSocketPoller(int epoll_fd) : epoll_fd(epoll_fd), registered(0) {}
+
+	~EpollSocketPoller()
+	{
+		close(this->epoll_fd);
+	}
+
+	/* virtual */ bool Add(SOCKET s, NetworkTCPSocketHandler *handler)
+	{
+		if (!this->Control(EPOLL_CTL_ADD, s, false)) return false;
+
+		uint old_length = this->handlers.Length();
+		if ((uint)s >= old_length) {
+			this->handlers.Resize(s + 1);
+			for (uint i = old_length; i < (uint)s; i++) this->handlers[i] = NULL;
+		}
+		this->handlers[s] = handler;
+		this->registered++;
+		return true;
+	}
+
+	/* virtual */ void Remove(SOCKET s)
+	{
+		if (this->Control(EPOLL_CTL_DEL, s, false)) {
+			this->handlers[s] = NULL;
+			this->registered--;
+		}
+		this->InvalidateEvents(s);
+	}
+
+	/* virtual */ void SetWriteInterest(SOCKET s, bool write)
+	{
+		this->Control(EPOLL_CTL_MOD, s, write);
+	}
+
+	/* virtual */ bool Poll()
+	{
+		this->events.Clear();
+		if (this->registered == 0) return true;
+
+		/* Make sure every ready socket fits, so we get them all in one go. */
+		if (this->ready.Length() < this->registered) this->ready.Resize(this->registered);
+
+		int n = epoll_wait(this->epoll_fd, this->ready.Begin(), this->ready.Length(), 0);
+		if (n < 0) return GET_LAST_ERROR() == EINTR;
+
+		for (int i = 0; i < n; i++) {
+			const struct epoll_event &r = this->ready[i];
+
+			SocketPollEvent *ev = this->events.Append();
+			ev->sock = r.data.fd;
+			ev->handler = this->handlers[r.data.fd];
+			ev->flags = SPF_NONE;
+			/* Errors and hang-ups are noticed when reading from the socket. */
+			if ((r.events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0) ev->flags |= SPF_READ;
+			if ((r.events & EPOLLOUT) != 0) ev->flags |= SPF_WRITE;
+		}
+		return true;
+	}
+};
+#endif /* HAVE_EPOLL */
+
+/**
+ * Create the best poller for this system.
+ * @return The new poller.
+ */
+/* static */ SocketPoller *SocketPoller::Create()
+{
+#ifdef HAVE_EPOLL
+	/* The size is only a hint (and ignored by modern kernels), but must be positive. */
+	int fd = epoll_create(64);
+	if (fd != -1) {
+		DEBUG(net, 3, "Using epoll to poll sockets");
+		return new EpollSocketPoller(fd);
+	}
+	DEBUG(net, 0, "epoll_create failed with error %d, falling back to select", GET_LAST_ERROR());
+#endif /* HAVE_EPOLL */
+	return new SelectSocketPoller();
+}
+
+#endif /* ENABLE_NETWORK */
@@ -0,0 +1,120 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file poller.h Waiting for readiness of many sockets at once.
+ */
+
+#ifndef NETWORK_CORE_POLLER_H
+#define NETWORK_CORE_POLLER_H
+
+#include "os_abstraction.h"
+#include "../../core/enum_type.hpp"
+#include "../../core/smallvec_type.hpp"
+
+#ifdef ENABLE_NETWORK
+
+class NetworkTCPSocketHandler;
+
+/** What a socket is ready for. */
+enum SocketPollFlags {
+	SPF_NONE  = 0,      ///< Nothing can be done with the socket.
+	SPF_READ  = 1 << 0, ///< There is something to read, a connection to accept or an error to handle.
+	SPF_WRITE = 1 << 1, ///< Data can be written without blocking.
+};
+DECLARE_ENUM_AS_BIT_SET(SocketPollFlags)
+
+/** Readiness of a single socket, as returned by #SocketPoller::Poll. */
+struct SocketPollEvent {
+	SOCKET sock;                      ///< The socket that is ready, or INVALID_SOCKET when it was removed after polling.
+	NetworkTCPSocketHandler *handler; ///< The handler given when adding the socket; \c NULL for listening sockets.
+	SocketPollFlags flags;            ///< What the socket is ready for.
+};
+
+/**
+ * Interface for waiting on a set of sockets. Sockets are registered once and
+ * stay registered until they are removed, so polling costs are proportional
+ * to the number of sockets that are actually ready, when the OS allows it.
+ * Sockets are always polled for reading; polling for writing has to be
+ * requested explicitly, typically after a send would have blocked.
+ */
+class SocketPoller {
+protected:
+	SmallVector<SocketPollEvent, 16> events; ///< The events of the last call to #Poll.
+	SmallVector<NetworkTCPSocketHandler *, 16> send_pending; ///< Handlers that have something to send; \c NULL for handlers removed since the last #CompactSendPending.
+
+	void InvalidateEvents(SOCKET s);
+
+public:
+	/** Make sure the right destructor is called. */
+	virtual ~SocketPoller() {}
+
+	/**
+	 * Start polling a socket for reading.
+	 * @param s       The socket to poll.
+	 * @param handler The handler to report with the events, or \c NULL for listening sockets.
+	 * @return True iff the socket could be added.
+	 */
+	virtual bool Add(SOCKET s, NetworkTCPSocketHandler *handler) = 0;
+
+	/**
+	 * Stop polling a socket. Events of the last #Poll for this socket get invalidated.
+	 * @param s The socket to remove; must be called before the socket gets closed.
+	 */
+	virtual void Remove(SOCKET s) = 0;
+
+	/**
+	 * Set whether to poll the socket for writability as well.
+	 * @param s     The socket to change.
+	 * @param write Whether to report the socket when it becomes writable.
+	 */
+	virtual void SetWriteInterest(SOCKET s, bool write) = 0;
+
+	/**
+	 * Check, without blocking, which of the sockets are ready.
+	 * @return False iff polling failed.
+	 */
+	virtual bool Poll() = 0;
+
+	/**
+	 * Get the first event of the last #Poll.
+	 * @return Pointer to the first event.
+	 */
+	const SocketPollEvent *Begin() const { return this->events.Begin(); }
+
+	/**
+	 * Get the end of the events of the last #Poll.
+	 * @return Pointer behind the last event.
+	 */
+	const SocketPollEvent *End() const { return this->events.End(); }
+
+	void AddSendPending(NetworkTCPSocketHandler *handler);
+	void RemoveSendPending(NetworkTCPSocketHandler *handler);
+	void CompactSendPending();
+
+	/**
+	 * Get the number of entries in the list of handlers that have something to send.
+	 * The list may grow while handling its entries.
+	 * @return The number of entries, including removed ones.
+	 */
+	uint GetSendPendingCount() const { return this->send_pending.Length(); }
+
+	/**
+	 * Get an entry of the list of handlers that have something to send.
+	 * @param index The index of the entry.
+	 * @return The handler, or \c NULL when it got removed from the list.
+	 */
+	NetworkTCPSocketHandler *GetSendPending(uint index) const { return this->send_pending[index]; }
+
+	static SocketPoller *Create();
+};
+
+#endif /* ENABLE_NETWORK */
+
+#endif /* NETWORK_CORE_POLLER_H */
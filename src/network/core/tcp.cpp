@@ -26,7 +26,7 @@
  */
 NetworkTCPSocketHandler::NetworkTCPSocketHandler(SOCKET s) :
 		NetworkSocketHandler(),
-		packet_queue(NULL), packet_recv(NULL),
+		queue_head(0), send_pos(0), packet_recv(NULL), poller(NULL), send_pending(false),
 		sock(s), writable(false)
 {
 }
@@ -35,6 +35,10 @@ NetworkTCPSocketHandler::~NetworkTCPSocketHandler()
 {
 	this->CloseConnection();
 
+	if (this->poller != NULL) {
+		this->SetSendPending(false);
+		this->poller->Remove(this->sock);
+	}
 	if (this->sock != INVALID_SOCKET) closesocket(this->sock);
 	this->sock = INVALID_SOCKET;
 }
@@ -45,11 +49,12 @@ NetworkRecvStatus NetworkTCPSocketHandler::CloseConnection(bool error)
 	NetworkSocketHandler::CloseConnection(error);
 
 	/* Free all pending and partially received packets */
-	while (this->packet_queue != NULL) {
-		Packet *p = this->packet_queue->next;
-		delete this->packet_queue;
-		this->packet_queue = p;
+	for (uint i = this->queue_head; i < this->packet_queue.Length(); i++) {
+		this->packet_queue[i]->Release();
 	}
+	this->packet_queue.Clear();
+	this->queue_head = 0;
+	this->send_pos = 0;
 	delete this->packet_recv;
 	this->packet_recv = NULL;
 
@@ -60,30 +65,88 @@ NetworkRecvStatus NetworkTCPSocketHandler::CloseConnection(bool error)
  * This function puts the packet in the send-queue and it is send as
  * soon as possible. This is the next tick, or maybe one tick later
  * if the OS-network-buffer is full)
+ * The queue takes over one reference to the packet; to queue the same
+ * packet for several sockets, prepare it once and add a reference before
+ * each call.
  * @param packet the packet to send
  */
 void NetworkTCPSocketHandler::SendPacket(Packet *packet)
 {
-	Packet *p;
 	assert(packet != NULL);
 
-	packet->PrepareToSend();
+	/* Shared packets have been prepared by their owner before sharing them. */
+	if (packet->references == 1) packet->PrepareToSend();
 
-	/* Reallocate the packet as in 99+% of the times we send at most 25 bytes and
-	 * keeping the other 1400+ bytes wastes memory, especially when someone tries
-	 * to do a denial of service attack! */
-	packet->buffer = ReallocT(packet->buffer, packet->size);
+	/* Drop the pointers to already sent packets once they make up half of the queue. */
+	if (this->queue_head > 0 && this->queue_head * 2 >= this->packet_queue.Length()) {
+		this->packet_queue.ErasePreservingOrder(0, this->queue_head);
+		this->queue_head = 0;
+	}
 
-	/* Locate last packet buffered for the client */
-	p = this->packet_queue;
-	if (p == NULL) {
-		/* No packets yet */
-		this->packet_queue = packet;
-	} else {
-		/* Skip to the last packet */
-		while (p->next != NULL) p = p->next;
-		p->next = packet;
+	*this->packet_queue.Append() = packet;
+
+	/* A socket that cannot be written to is added once the poller reports it writable. */
+	if (this->writable) this->SetSendPending(true);
+}
+
+/**
+ * Try to send (the rest of) the queued packets with as few system calls
+ * as possible; where supported all packets are handed to the OS at once.
+ * @return The result of the send call; the number of bytes that were sent or -1 on error.
+ */
+ssize_t NetworkTCPSocketHandler::SendQueued()
+{
+	assert(this->HasSendQueue());
+
+#ifdef HAVE_SENDMSG
+	/* POSIX only guarantees sendmsg to accept 16 (IOV_MAX) buffers. */
+	struct iovec iov[16];
+	uint count = 0;
+	for (uint i = this->queue_head; i < this->packet_queue.Length() && count < lengthof(iov); i++, count++) {
+		const Packet *p = this->packet_queue[i];
+		PacketSize skip = (count == 0) ? this->send_pos : 0;
+		iov[count].iov_base = p->buffer + skip;
+		iov[count].iov_len  = p->size - skip;
+	}
+
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = count;
+	return sendmsg(this->sock, &msg, 0);
+#else
+	const Packet *p = this->packet_queue[this->queue_head];
+	return send(this->sock, (const char*)p->buffer + this->send_pos, p->size - this->send_pos, 0);
+#endif /* HAVE_SENDMSG */
+}
+
+/**
+ * Remove the sent bytes from the send queue.
+ * @param bytes The number of bytes the OS accepted.
+ * @return True iff the last packet that was offered is sent completely.
+ */
+bool NetworkTCPSocketHandler::ConsumeSent(size_t bytes)
+{
+	while (bytes > 0) {
+		Packet *p = this->packet_queue[this->queue_head];
+		size_t left = p->size - this->send_pos;
+		if (bytes < left) {
+			this->send_pos += (PacketSize)bytes;
+			return false;
+		}
+
+		/* Go to the next packet */
+		bytes -= left;
+		this->send_pos = 0;
+		this->packet_queue[this->queue_head++] = NULL;
+		p->Release();
+	}
+
+	if (!this->HasSendQueue()) {
+		this->packet_queue.Clear();
+		this->queue_head = 0;
 	}
+	return this->send_pos == 0;
 }
 
 /**
@@ -98,16 +161,12 @@ void NetworkTCPSocketHandler::SendPacket(Packet *packet)
  */
 SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 {
-	ssize_t res;
-	Packet *p;
-
 	/* We can not write to this socket!! */
 	if (!this->writable) return SPS_NONE_SENT;
 	if (!this->IsConnected()) return SPS_CLOSED;
 
-	p = this->packet_queue;
-	while (p != NULL) {
-		res = send(this->sock, (const char*)p->buffer + p->pos, p->size - p->pos, 0);
+	while (this->HasSendQueue()) {
+		ssize_t res = this->SendQueued();
 		if (res == -1) {
 			int err = GET_LAST_ERROR();
 			if (err != EWOULDBLOCK) {
@@ -118,6 +177,12 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 				}
 				return SPS_CLOSED;
 			}
+			/* Wait until the poller tells us we can write again. */
+			if (this->poller != NULL) {
+				this->writable = false;
+				this->poller->SetWriteInterest(this->sock, true);
+				this->SetSendPending(false);
+			}
 			return SPS_PARTLY_SENT;
 		}
 		if (res == 0) {
@@ -126,17 +191,8 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 			return SPS_CLOSED;
 		}
 
-		p->pos += res;
-
-		/* Is this packet sent? */
-		if (p->pos == p->size) {
-			/* Go to the next packet */
-			this->packet_queue = p->next;
-			delete p;
-			p = this->packet_queue;
-		} else {
-			return SPS_PARTLY_SENT;
-		}
+		/* Only a part is sent, so the OS buffer is full. */
+		if (!this->ConsumeSent(res)) return SPS_PARTLY_SENT;
 	}
 
 	return SPS_ALL_SENT;
@@ -221,6 +277,51 @@ Packet *NetworkTCPSocketHandler::ReceivePacket()
 	return p;
 }
 
+/**
+ * Let the given poller watch this socket, so readiness of this socket
+ * gets reported by the poller instead of by #CanSendReceive.
+ * @param poller The poller to register with.
+ * @return True iff the socket could be registered.
+ */
+bool NetworkTCPSocketHandler::RegisterPoller(SocketPoller *poller)
+{
+	assert(this->poller == NULL && this->IsConnected());
+
+	if (!poller->Add(this->sock, this)) return false;
+
+	this->poller = poller;
+	/* A fresh connection has an empty send buffer. */
+	this->writable = true;
+	return true;
+}
+
+/**
+ * The poller reported that the socket can be written to again.
+ */
+void NetworkTCPSocketHandler::OnWritable()
+{
+	this->writable = true;
+	if (this->poller != NULL) this->poller->SetWriteInterest(this->sock, false);
+	if (this->HasSendQueue()) this->SetSendPending(true);
+}
+
+/**
+ * Set whether the send functions of the listen handler have to visit this
+ * socket. Sockets that are not registered with a poller are never visited.
+ * @param pending Whether this socket has something to send.
+ */
+void NetworkTCPSocketHandler::SetSendPending(bool pending)
+{
+	if (this->poller == NULL || this->send_pending == pending) return;
+
+	this->send_pending = pending;
+	if (pending) {
+		this->poller->AddSendPending(this);
+	} else {
+		this->poller->RemoveSendPending(this);
+	}
+}
+
 /**
  * Check whether this socket can send or receive something.
  * @return \c true when there is something to receive.
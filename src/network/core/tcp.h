@@ -16,6 +16,8 @@
 
 #include "address.h"
 #include "packet.h"
+#include "poller.h"
+#include "../../core/smallvec_type.hpp"
 
 #ifdef ENABLE_NETWORK
 
@@ -30,8 +32,15 @@ enum SendPacketsState {
 /** Base socket handler for all TCP sockets */
 class NetworkTCPSocketHandler : public NetworkSocketHandler {
 private:
-	Packet *packet_queue;     ///< Packets that are awaiting delivery
+	SmallVector<Packet *, 16> packet_queue; ///< Packets that are awaiting delivery; the packets before queue_head are already sent
+	uint queue_head;          ///< Index of the first packet in the queue that is not completely sent
+	PacketSize send_pos;      ///< Number of bytes of the first packet that have been sent already
 	Packet *packet_recv;      ///< Partially received packet
+	SocketPoller *poller;     ///< The poller this socket is registered with, if any
+	bool send_pending;        ///< Whether this socket is in the list of sockets with something to send of its poller
+
+	ssize_t SendQueued();
+	bool ConsumeSent(size_t bytes);
 public:
 	SOCKET sock;              ///< The socket currently connected to
 	bool writable;            ///< Can we write to this socket?
@@ -50,11 +59,15 @@ public:
 
 	bool CanSendReceive();
 
+	bool RegisterPoller(SocketPoller *poller);
+	void OnWritable();
+	void SetSendPending(bool pending);
+
 	/**
 	 * Whether there is something pending in the send queue.
 	 * @return true when something is pending in the send queue.
 	 */
-	bool HasSendQueue() { return this->packet_queue != NULL; }
+	bool HasSendQueue() { return this->queue_head < this->packet_queue.Length(); }
 
 	NetworkTCPSocketHandler(SOCKET s = INVALID_SOCKET);
 	~NetworkTCPSocketHandler();
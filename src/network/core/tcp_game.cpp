@@ -29,7 +29,7 @@
  * @param s The socket to connect with.
  */
 NetworkGameSocketHandler::NetworkGameSocketHandler(SOCKET s) : info(NULL), client_id(INVALID_CLIENT_ID),
-		last_frame(_frame_counter), last_frame_server(_frame_counter), last_packet(_realtime_tick)
+		last_frame(_frame_counter), last_frame_server(_frame_counter), last_packet(_realtime_tick), features(NGF_NONE)
 {
 	this->sock = s;
 }
@@ -111,6 +111,7 @@ NetworkRecvStatus NetworkGameSocketHandler::HandlePacket(Packet *p)
 		case PACKET_CLIENT_MOVE:                  return this->Receive_CLIENT_MOVE(p);
 		case PACKET_SERVER_COMPANY_UPDATE:        return this->Receive_SERVER_COMPANY_UPDATE(p);
 		case PACKET_SERVER_CONFIG_UPDATE:         return this->Receive_SERVER_CONFIG_UPDATE(p);
+		case PACKET_SERVER_BATCH:                 return this->Receive_SERVER_BATCH(p);
 
 		default:
 			this->CloseConnection();
@@ -197,5 +198,6 @@ NetworkRecvStatus NetworkGameSocketHandler::Receive_SERVER_MOVE(Packet *p) { ret
 NetworkRecvStatus NetworkGameSocketHandler::Receive_CLIENT_MOVE(Packet *p) { return this->ReceiveInvalidPacket(PACKET_CLIENT_MOVE); }
 NetworkRecvStatus NetworkGameSocketHandler::Receive_SERVER_COMPANY_UPDATE(Packet *p) { return this->ReceiveInvalidPacket(PACKET_SERVER_COMPANY_UPDATE); }
 NetworkRecvStatus NetworkGameSocketHandler::Receive_SERVER_CONFIG_UPDATE(Packet *p) { return this->ReceiveInvalidPacket(PACKET_SERVER_CONFIG_UPDATE); }
+NetworkRecvStatus NetworkGameSocketHandler::Receive_SERVER_BATCH(Packet *p) { return this->ReceiveInvalidPacket(PACKET_SERVER_BATCH); }
 
 #endif /* ENABLE_NETWORK */
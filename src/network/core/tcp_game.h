@@ -123,9 +123,31 @@ enum PacketGameType {
 	PACKET_CLIENT_ERROR,                 ///< A client reports an error to the server.
 	PACKET_SERVER_ERROR_QUIT,            ///< A server tells that a client has hit an error and did quit.
 
+	/* Game progress of a whole frame at once, only when negotiated. */
+	PACKET_SERVER_BATCH,                 ///< Server sends the commands, frame and sync-check of a frame in one go.
+
 	PACKET_END,                          ///< Must ALWAYS be on the end of this list!! (period)
 };
 
+/**
+ * Optional extensions of the protocol. The client tells the server which
+ * it supports when joining, and the server tells which it will use, so
+ * clients that do not know about them keep getting the classic protocol.
+ */
+enum NetworkGameFeatures {
+	NGF_NONE             = 0,      ///< Only the classic protocol.
+	NGF_BATCH            = 1 << 0, ///< Commands, frame and sync-check of a frame are sent in one #PACKET_SERVER_BATCH.
+	NGF_BATCH_COMPRESSED = 1 << 1, ///< The content of a #PACKET_SERVER_BATCH may be compressed.
+};
+DECLARE_ENUM_AS_BIT_SET(NetworkGameFeatures)
+
+/** Flags at the start of a #PACKET_SERVER_BATCH. */
+enum NetworkBatchFlags {
+	NBF_NONE       = 0,      ///< The content follows as is.
+	NBF_COMPRESSED = 1 << 0, ///< The content is compressed with zlib.
+};
+DECLARE_ENUM_AS_BIT_SET(NetworkBatchFlags)
+
 /** Packet that wraps a command */
 struct CommandPacket;
 
@@ -175,6 +197,7 @@ protected:
 	 * string  Name of the client (max NETWORK_NAME_LENGTH).
 	 * uint8   ID of the company to play as (1..MAX_COMPANIES).
 	 * uint8   ID of the clients Language.
+	 * uint8   The #NetworkGameFeatures the client supports (optional).
 	 * @param p The packet that was just received.
 	 */
 	virtual NetworkRecvStatus Receive_CLIENT_JOIN(Packet *p);
@@ -264,6 +287,7 @@ protected:
 	 * uint32  Own client ID.
 	 * uint32  Generation seed.
 	 * string  Network ID of the server.
+	 * uint8   The #NetworkGameFeatures the server will use (only when the client sent the features it supports).
 	 * @param p The packet that was just received.
 	 */
 	virtual NetworkRecvStatus Receive_SERVER_WELCOME(Packet *p);
@@ -514,6 +538,18 @@ protected:
 	 */
 	virtual NetworkRecvStatus Receive_SERVER_CONFIG_UPDATE(Packet *p);
 
+	/**
+	 * Sends everything of a frame to the client in one go; only used when
+	 * the client supports #NGF_BATCH:
+	 * uint8   The #NetworkBatchFlags.
+	 * uint16  Size of the uncompressed content (only when compressed).
+	 * bytes   The (compressed) content: complete PACKET_SERVER_COMMAND,
+	 *         PACKET_SERVER_FRAME and PACKET_SERVER_SYNC packets, each
+	 *         including its size, in the order they have to be handled.
+	 * @param p The packet that was just received.
+	 */
+	virtual NetworkRecvStatus Receive_SERVER_BATCH(Packet *p);
+
 	NetworkRecvStatus HandlePacket(Packet *p);
 
 	NetworkGameSocketHandler(SOCKET s);
@@ -523,6 +559,7 @@ public:
 	uint32 last_frame_server;    ///< Last frame the server has executed
 	CommandQueue incoming_queue; ///< The command-queue awaiting handling
 	uint last_packet;            ///< Time we received the last frame.
+	NetworkGameFeatures features; ///< The optional protocol features used on this connection.
 
 	NetworkRecvStatus CloseConnection(bool error = true);
 
@@ -32,6 +32,8 @@ template <class Tsocket, PacketType Tfull_packet, PacketType Tban_packet>
 class TCPListenHandler {
 	/** List of sockets we listen on. */
 	static SocketList sockets;
+	/** Poller for the listening sockets and all sockets accepted from them. */
+	static SocketPoller *poller;
 
 public:
 	/**
@@ -89,52 +91,45 @@ public:
 				continue;
 			}
 
-			Tsocket::AcceptConnection(s, address);
+			Tsocket *cs = Tsocket::AcceptConnection(s, address);
+			if (!cs->RegisterPoller(poller)) {
+				/* Nothing will be received, so the connection times out while joining. */
+				DEBUG(net, 0, "[%s] Could not poll the connection from %s", Tsocket::GetName(), address.GetHostname());
+			}
 		}
 	}
 
 	/**
-	 * Handle the receiving of packets.
+	 * Get the poller for the listening sockets and all sockets accepted from them.
+	 * @return The poller, or \c NULL when never listened.
+	 */
+	static SocketPoller *GetPoller()
+	{
+		return poller;
+	}
+
+	/**
+	 * Handle the receiving of packets. Only the sockets the poller reports
+	 * as ready are visited; sockets that have nothing to do cost nothing.
 	 * @return true if everything went okay.
 	 */
 	static bool Receive()
 	{
-		fd_set read_fd, write_fd;
-		struct timeval tv;
+		if (poller == NULL || !poller->Poll()) return _networking;
 
-		FD_ZERO(&read_fd);
-		FD_ZERO(&write_fd);
+		for (const SocketPollEvent *ev = poller->Begin(); ev != poller->End(); ev++) {
+			/* The socket got closed while handling an earlier event. */
+			if (ev->sock == INVALID_SOCKET) continue;
 
-
-		Tsocket *cs;
-		FOR_ALL_ITEMS_FROM(Tsocket, idx, cs, 0) {
-			FD_SET(cs->sock, &read_fd);
-			FD_SET(cs->sock, &write_fd);
-		}
-
-		/* take care of listener port */
-		for (SocketList::iterator s = sockets.Begin(); s != sockets.End(); s++) {
-			FD_SET(s->second, &read_fd);
-		}
-
-		tv.tv_sec = tv.tv_usec = 0; // don't block at all.
-#if !defined(__MORPHOS__) && !defined(__AMIGA__)
-		if (select(FD_SETSIZE, &read_fd, &write_fd, NULL, &tv) < 0) return false;
-#else
-		if (WaitSelect(FD_SETSIZE, &read_fd, &write_fd, NULL, &tv, NULL) < 0) return false;
-#endif
-
-		/* accept clients.. */
-		for (SocketList::iterator s = sockets.Begin(); s != sockets.End(); s++) {
-			if (FD_ISSET(s->second, &read_fd)) AcceptClient(s->second);
-		}
-
-		/* read stuff from clients */
-		FOR_ALL_ITEMS_FROM(Tsocket, idx, cs, 0) {
-			cs->writable = !!FD_ISSET(cs->sock, &write_fd);
-			if (FD_ISSET(cs->sock, &read_fd)) {
-				cs->ReceivePackets();
+			/* Only listening sockets are registered without handler. */
+			if (ev->handler == NULL) {
+				AcceptClient(ev->sock);
+				continue;
 			}
+
+			Tsocket *cs = static_cast<Tsocket *>(ev->handler);
+			if ((ev->flags & SPF_WRITE) != 0) cs->OnWritable();
+			if ((ev->flags & SPF_READ) != 0) cs->ReceivePackets();
 		}
 		return _networking;
 	}
@@ -161,6 +156,12 @@ public:
 			return false;
 		}
 
+		/* The poller outlives the listeners, as accepted connections may stay open after closing them. */
+		if (poller == NULL) poller = SocketPoller::Create();
+		for (SocketList::iterator s = sockets.Begin(); s != sockets.End(); s++) {
+			poller->Add(s->second, NULL);
+		}
+
 		return true;
 	}
 
@@ -168,6 +169,7 @@ public:
 	static void CloseListeners()
 	{
 		for (SocketList::iterator s = sockets.Begin(); s != sockets.End(); s++) {
+			if (poller != NULL) poller->Remove(s->second);
 			closesocket(s->second);
 		}
 		sockets.Clear();
@@ -176,6 +178,7 @@ public:
 };
 
 template <class Tsocket, PacketType Tfull_packet, PacketType Tban_packet> SocketList TCPListenHandler<Tsocket, Tfull_packet, Tban_packet>::sockets;
+template <class Tsocket, PacketType Tfull_packet, PacketType Tban_packet> SocketPoller *TCPListenHandler<Tsocket, Tfull_packet, Tban_packet>::poller = NULL;
 
 #endif /* ENABLE_NETWORK */
 
@@ -503,8 +503,9 @@ void ParseConnectionString(const char **company, const char **port, char *connec
  * Handle the accepting of a connection to the server.
  * @param s The socket of the new connection.
  * @param address The address of the peer.
+ * @return The handler for the new connection.
  */
-/* static */ void ServerNetworkGameSocketHandler::AcceptConnection(SOCKET s, const NetworkAddress &address)
+/* static */ ServerNetworkGameSocketHandler *ServerNetworkGameSocketHandler::AcceptConnection(SOCKET s, const NetworkAddress &address)
 {
 	/* Register the login */
 	_network_clients_connected++;
@@ -512,6 +513,7 @@ void ParseConnectionString(const char **company, const char **port, char *connec
 	SetWindowDirty(WC_CLIENT_LIST, 0);
 	ServerNetworkGameSocketHandler *cs = new ServerNetworkGameSocketHandler(s);
 	cs->client_address = address; // Save the IP of the client
+	return cs;
 }
 
 /**
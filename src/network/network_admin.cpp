@@ -103,23 +103,34 @@ ServerNetworkAdminSocketHandler::~ServerNetworkAdminSocketHandler()
 		if (as->status == ADMIN_STATUS_INACTIVE && as->realtime_connect + ADMIN_AUTHORISATION_TIMEOUT < _realtime_tick) {
 			DEBUG(net, 1, "[admin] Admin did not send its authorisation within %d seconds", ADMIN_AUTHORISATION_TIMEOUT / 1000);
 			as->CloseConnection(true);
-			continue;
-		}
-		if (as->writable) {
-			as->SendPackets();
 		}
 	}
+
+	SocketPoller *poller = GetPoller();
+	if (poller == NULL) return;
+
+	/* Only visit the admins that have something to send. */
+	for (uint i = 0; i < poller->GetSendPendingCount(); i++) {
+		as = static_cast<ServerNetworkAdminSocketHandler *>(poller->GetSendPending(i));
+		if (as == NULL) continue;
+
+		as->SendPackets();
+		if (poller->GetSendPending(i) == as && (!as->writable || !as->HasSendQueue())) as->SetSendPending(false);
+	}
+	poller->CompactSendPending();
 }
 
 /**
  * Handle the acception of a connection.
  * @param s The socket of the new connection.
  * @param address The address of the peer.
+ * @return The handler for the new connection.
  */
-/* static */ void ServerNetworkAdminSocketHandler::AcceptConnection(SOCKET s, const NetworkAddress &address)
+/* static */ ServerNetworkAdminSocketHandler *ServerNetworkAdminSocketHandler::AcceptConnection(SOCKET s, const NetworkAddress &address)
 {
 	ServerNetworkAdminSocketHandler *as = new ServerNetworkAdminSocketHandler(s);
 	as->address = address; // Save the IP of the client
+	return as;
 }
 
 /***********
@@ -74,7 +74,7 @@ public:
 	NetworkRecvStatus SendRconEnd(const char *command);
 
 	static void Send();
-	static void AcceptConnection(SOCKET s, const NetworkAddress &address);
+	static ServerNetworkAdminSocketHandler *AcceptConnection(SOCKET s, const NetworkAddress &address);
 	static bool AllowConnection();
 	static void WelcomeAll();
 
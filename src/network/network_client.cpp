@@ -32,6 +32,10 @@
 #include "network_client.h"
 #include "../core/backup_type.hpp"
 
+#if defined(WITH_ZLIB)
+#include <zlib.h>
+#endif /* WITH_ZLIB */
+
 #include "table/strings.h"
 
 #include "../safeguards.h"
@@ -335,6 +339,11 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::SendJoin()
 	p->Send_string(_settings_client.network.client_name); // Client name
 	p->Send_uint8 (_network_join_as);     // PlayAs
 	p->Send_uint8 (NETLANG_ANY);          // Language
+#if defined(WITH_ZLIB)
+	p->Send_uint8 (NGF_BATCH | NGF_BATCH_COMPRESSED); // Features
+#else
+	p->Send_uint8 (NGF_BATCH);            // Features
+#endif /* WITH_ZLIB */
 	my_client->SendPacket(p);
 	return NETWORK_RECV_STATUS_OKAY;
 }
@@ -753,6 +762,9 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_WELCOME(Packet
 	_password_game_seed = p->Recv_uint32();
 	p->Recv_string(_password_server_id, sizeof(_password_server_id));
 
+	/* Older servers do not tell which features they enabled. */
+	this->features = (p->pos < p->size) ? (NetworkGameFeatures)p->Recv_uint8() : NGF_NONE;
+
 	/* Start receiving the map */
 	return SendGetMap();
 }
@@ -918,6 +930,57 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_SYNC(Packet *p)
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_BATCH(Packet *p)
+{
+	if (this->status != STATUS_ACTIVE || (this->features & NGF_BATCH) == 0) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+
+	NetworkBatchFlags flags = (NetworkBatchFlags)p->Recv_uint8();
+	const byte *content = p->buffer + p->pos;
+	uint length = p->size - p->pos;
+
+	byte buffer[BATCH_MAX_CONTENT_SIZE];
+	if ((flags & NBF_COMPRESSED) != 0) {
+#if defined(WITH_ZLIB)
+		uLongf uncompressed = p->Recv_uint16();
+		uLongf expected = uncompressed;
+		if (expected > sizeof(buffer) ||
+				uncompress(buffer, &uncompressed, p->buffer + p->pos, p->size - p->pos) != Z_OK ||
+				uncompressed != expected) {
+			return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+		}
+		content = buffer;
+		length = uncompressed;
+#else
+		/* We never told the server we could handle this. */
+		return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+#endif /* WITH_ZLIB */
+	}
+
+	/* Handle the packets in the batch as if they were received one by one. */
+	uint pos = 0;
+	while (pos < length) {
+		if (length - pos < sizeof(PacketSize) + sizeof(PacketType)) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+
+		PacketSize size = content[pos] | content[pos + 1] << 8;
+		PacketGameType type = (PacketGameType)content[pos + sizeof(PacketSize)];
+		if (size < sizeof(PacketSize) + sizeof(PacketType) || size > SEND_MTU || size > length - pos ||
+				(type != PACKET_SERVER_COMMAND && type != PACKET_SERVER_FRAME && type != PACKET_SERVER_SYNC)) {
+			return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+		}
+
+		Packet *sub = new Packet(this);
+		memcpy(sub->buffer, content + pos, size);
+		sub->PrepareToRead();
+		pos += size;
+
+		NetworkRecvStatus res = this->HandlePacket(sub);
+		delete sub;
+		if (res != NETWORK_RECV_STATUS_OKAY) return res;
+	}
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_COMMAND(Packet *p)
 {
 	if (this->status != STATUS_ACTIVE) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
@@ -60,6 +60,7 @@ protected:
 	virtual NetworkRecvStatus Receive_SERVER_JOIN(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_FRAME(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_SYNC(Packet *p);
+	virtual NetworkRecvStatus Receive_SERVER_BATCH(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_COMMAND(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_CHAT(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_QUIT(Packet *p);
@@ -33,6 +33,10 @@
 #include "../core/random_func.hpp"
 #include "../rev.h"
 
+#if defined(WITH_ZLIB)
+#include <zlib.h>
+#endif /* WITH_ZLIB */
+
 #include "../safeguards.h"
 
 
@@ -225,6 +229,7 @@ ServerNetworkGameSocketHandler::ServerNetworkGameSocketHandler(SOCKET s) : Netwo
 	this->status = STATUS_INACTIVE;
 	this->client_id = _network_client_id++;
 	this->receive_limit = _settings_client.network.bytes_per_frame_burst;
+	this->batching = false;
 
 	/* The Socket and Info pools need to be the same in size. After all,
 	 * each Socket will be associated with at most one Info object. As
@@ -259,6 +264,29 @@ Packet *ServerNetworkGameSocketHandler::ReceivePacket()
 	return p;
 }
 
+/** Size of the header of a PACKET_SERVER_BATCH, without the content. */
+static const uint BATCH_HEADER_SIZE = sizeof(PacketSize) + sizeof(PacketType) + sizeof(uint8);
+
+/* virtual */ void ServerNetworkGameSocketHandler::SendPacket(Packet *packet)
+{
+	if (this->batching) {
+		PacketGameType type = (PacketGameType)packet->buffer[sizeof(PacketSize)];
+		if ((type == PACKET_SERVER_COMMAND || type == PACKET_SERVER_FRAME || type == PACKET_SERVER_SYNC) &&
+				packet->size <= SEND_MTU - BATCH_HEADER_SIZE) {
+			if (packet->references == 1) packet->PrepareToSend();
+			if (this->batch.Length() + packet->size > BATCH_MAX_CONTENT_SIZE) this->FlushBatch();
+			memcpy(this->batch.Append(packet->size), packet->buffer, packet->size);
+			packet->Release();
+			return;
+		}
+
+		/* Keep the order in which the client gets the packets. */
+		this->FlushBatch();
+	}
+
+	this->NetworkTCPSocketHandler::SendPacket(packet);
+}
+
 NetworkRecvStatus ServerNetworkGameSocketHandler::CloseConnection(NetworkRecvStatus status)
 {
 	assert(status != NETWORK_RECV_STATUS_OKAY);
@@ -326,15 +354,23 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::CloseConnection(NetworkRecvSta
 /** Send the packets for the server sockets. */
 /* static */ void ServerNetworkGameSocketHandler::Send()
 {
-	NetworkClientSocket *cs;
-	FOR_ALL_CLIENT_SOCKETS(cs) {
-		if (cs->writable) {
-			if (cs->SendPackets() != SPS_CLOSED && cs->status == STATUS_MAP) {
-				/* This client is in the middle of a map-send, call the function for that */
-				cs->SendMap();
-			}
+	SocketPoller *poller = GetPoller();
+	if (poller == NULL) return;
+
+	/* Only visit the clients that have something to send; sending may add clients to the list or remove them from it. */
+	for (uint i = 0; i < poller->GetSendPendingCount(); i++) {
+		NetworkClientSocket *cs = static_cast<NetworkClientSocket *>(poller->GetSendPending(i));
+		if (cs == NULL) continue;
+
+		if (cs->writable && cs->SendPackets() != SPS_CLOSED && cs->status == STATUS_MAP) {
+			/* This client is in the middle of a map-send, call the function for that */
+			cs->SendMap();
 		}
+
+		/* Clients receiving the map have to be visited until all of it is queued. */
+		if (poller->GetSendPending(i) == cs && (!cs->writable || (!cs->HasSendQueue() && cs->status != STATUS_MAP))) cs->SetSendPending(false);
 	}
+	poller->CompactSendPending();
 }
 
 static void NetworkHandleCommandQueue(NetworkClientSocket *cs);
@@ -541,6 +577,7 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendWelcome()
 	p->Send_uint32(this->client_id);
 	p->Send_uint32(_settings_game.game_creation.generation_seed);
 	p->Send_string(_settings_client.network.network_id);
+	p->Send_uint8 (this->features);
 	this->SendPacket(p);
 
 	/* Transmit info about all the active clients */
@@ -687,8 +724,11 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendJoin(ClientID client_id)
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
-/** Tell the client that they may run to a particular frame. */
-NetworkRecvStatus ServerNetworkGameSocketHandler::SendFrame()
+/**
+ * Create the packet that tells clients that they may run to a particular frame.
+ * @return The packet, without the per client token.
+ */
+static Packet *NewFramePacket()
 {
 	Packet *p = new Packet(PACKET_SERVER_FRAME);
 	p->Send_uint32(_frame_counter);
@@ -699,31 +739,185 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendFrame()
 	p->Send_uint32(_sync_seed_2);
 #endif
 #endif
+	return p;
+}
 
+/**
+ * Create the packet that requests clients to sync.
+ * @return The packet.
+ */
+static Packet *NewSyncPacket()
+{
+	Packet *p = new Packet(PACKET_SERVER_SYNC);
+	p->Send_uint32(_frame_counter);
+	p->Send_uint32(_sync_seed_1);
+
+#ifdef NETWORK_SEND_DOUBLE_SEED
+	p->Send_uint32(_sync_seed_2);
+#endif
+	return p;
+}
+
+/**
+ * Tell the client that they may run to a particular frame.
+ * @param shared The frame packet for this frame as shared between all clients, or \c NULL to create one.
+ */
+NetworkRecvStatus ServerNetworkGameSocketHandler::SendFrame(Packet *shared)
+{
 	/* If token equals 0, we need to make a new token and send that. */
 	if (this->last_token == 0) {
+		Packet *p = NewFramePacket();
 		this->last_token = InteractiveRandomRange(UINT8_MAX - 1) + 1;
 		p->Send_uint8(this->last_token);
+		this->SendPacket(p);
+		return NETWORK_RECV_STATUS_OKAY;
 	}
 
-	this->SendPacket(p);
+	if (shared != NULL) {
+		shared->AddReference();
+		this->SendPacket(shared);
+	} else {
+		this->SendPacket(NewFramePacket());
+	}
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
-/** Request the client to sync. */
-NetworkRecvStatus ServerNetworkGameSocketHandler::SendSync()
+/**
+ * Request the client to sync.
+ * @param shared The sync packet for this frame as shared between all clients, or \c NULL to create one.
+ */
+NetworkRecvStatus ServerNetworkGameSocketHandler::SendSync(Packet *shared)
 {
-	Packet *p = new Packet(PACKET_SERVER_SYNC);
-	p->Send_uint32(_frame_counter);
-	p->Send_uint32(_sync_seed_1);
-
-#ifdef NETWORK_SEND_DOUBLE_SEED
-	p->Send_uint32(_sync_seed_2);
-#endif
-	this->SendPacket(p);
+	if (shared != NULL) {
+		shared->AddReference();
+		this->SendPacket(shared);
+	} else {
+		this->SendPacket(NewSyncPacket());
+	}
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+/** The single packet the last batch resulted in, so other clients getting the same batch can share it. */
+static Packet *_last_batch_packet = NULL;
+/** Whether #_last_batch_packet may be compressed. */
+static bool _last_batch_compressible;
+/** The content of #_last_batch_packet. */
+static SmallVector<byte, 256> _last_batch_content;
+
+/**
+ * Start collecting the commands, frame and sync-check of this frame, so
+ * they can be sent as one packet. Does nothing when the client does not
+ * support (or the server does not use) batching.
+ */
+void ServerNetworkGameSocketHandler::BeginBatch()
+{
+	assert(!this->batching && this->batch.Length() == 0);
+	this->batching = (this->features & NGF_BATCH) != 0;
+}
+
+/** Send the collected packets, and stop collecting them. */
+void ServerNetworkGameSocketHandler::EndBatch()
+{
+	if (!this->batching) return;
+
+	this->FlushBatch();
+	this->batching = false;
+}
+
+/** Forget the last batch; its content will not be sent to more clients. */
+/* static */ void ServerNetworkGameSocketHandler::ClearBatchCache()
+{
+	if (_last_batch_packet != NULL) _last_batch_packet->Release();
+	_last_batch_packet = NULL;
+	_last_batch_content.Clear();
+}
+
+/**
+ * Create a PACKET_SERVER_BATCH for the given content.
+ * @param content  The complete packets to put in the batch.
+ * @param length   The total size of the packets.
+ * @param compress Whether the content may be compressed.
+ * @return The packet, or \c NULL when the content does not fit in a single packet.
+ */
+static Packet *NewBatchPacket(const byte *content, uint length, bool compress)
+{
+	Packet *p = new Packet(PACKET_SERVER_BATCH);
+
+#if defined(WITH_ZLIB)
+	/* Small batches do not get any smaller by compressing them. */
+	if (compress && length > 64) {
+		uLongf compressed = SEND_MTU - BATCH_HEADER_SIZE - sizeof(uint16);
+		if (compress2(p->buffer + p->size + sizeof(uint8) + sizeof(uint16), &compressed, content, length, Z_BEST_SPEED) == Z_OK &&
+				compressed < length) {
+			p->Send_uint8(NBF_COMPRESSED);
+			p->Send_uint16(length);
+			p->size += (PacketSize)compressed;
+			return p;
+		}
+	}
+#endif /* WITH_ZLIB */
+
+	if (length > SEND_MTU - BATCH_HEADER_SIZE) {
+		delete p;
+		return NULL;
+	}
+
+	p->Send_uint8(NBF_NONE);
+	memcpy(p->buffer + p->size, content, length);
+	p->size += length;
+	return p;
+}
+
+/** Send the packets that are collected for a batch. */
+void ServerNetworkGameSocketHandler::FlushBatch()
+{
+	const byte *content = this->batch.Begin();
+	uint length = this->batch.Length();
+	if (length == 0) return;
+
+	bool compress = (this->features & NGF_BATCH_COMPRESSED) != 0;
+
+	/* Most clients get exactly the same batch, so only make it once. */
+	if (_last_batch_packet != NULL && _last_batch_compressible == compress && _last_batch_content.Length() == length &&
+			memcmp(_last_batch_content.Begin(), content, length) == 0) {
+		_last_batch_packet->AddReference();
+		this->NetworkTCPSocketHandler::SendPacket(_last_batch_packet);
+		this->batch.Clear();
+		return;
+	}
+
+	Packet *p = NewBatchPacket(content, length, compress);
+	if (p != NULL) {
+		p->PrepareToSend();
+		ClearBatchCache();
+		_last_batch_packet = p;
+		_last_batch_compressible = compress;
+		memcpy(_last_batch_content.Append(length), content, length);
+
+		p->AddReference();
+		this->NetworkTCPSocketHandler::SendPacket(p);
+		this->batch.Clear();
+		return;
+	}
+
+	/* Too big for one packet; split it at the boundaries of the packets in it. */
+	uint pos = 0;
+	while (pos < length) {
+		p = new Packet(PACKET_SERVER_BATCH);
+		p->Send_uint8(NBF_NONE);
+		while (pos < length) {
+			PacketSize size = content[pos] | content[pos + 1] << 8;
+			if (p->size + size > SEND_MTU) break;
+
+			memcpy(p->buffer + p->size, content + pos, size);
+			p->size += size;
+			pos += size;
+		}
+		this->NetworkTCPSocketHandler::SendPacket(p);
+	}
+	this->batch.Clear();
+}
+
 /**
  * Send a command to the client to execute.
  * @param cp The command to send.
@@ -917,6 +1111,16 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_JOIN(Packet *p)
 	playas = (Owner)p->Recv_uint8();
 	client_lang = (NetworkLanguage)p->Recv_uint8();
 
+	/* Older clients do not tell which features they support. */
+	NetworkGameFeatures features = NGF_NONE;
+	if (p->pos < p->size) features = (NetworkGameFeatures)p->Recv_uint8();
+	if (!_settings_client.network.server_batch_frames) features &= ~NGF_BATCH;
+	if (!_settings_client.network.server_compress_frames || (features & NGF_BATCH) == 0) features &= ~NGF_BATCH_COMPRESSED;
+#if !defined(WITH_ZLIB)
+	features &= ~NGF_BATCH_COMPRESSED;
+#endif /* WITH_ZLIB */
+	this->features = features & (NGF_BATCH | NGF_BATCH_COMPRESSED);
+
 	if (this->HasClientQuit()) return NETWORK_RECV_STATUS_CONN_LOST;
 
 	/* join another company does not affect these values */
@@ -1815,6 +2019,15 @@ void NetworkServer_Tick(bool send_frame)
 	}
 #endif
 
+	/* The frame and sync packets are the same for (nearly) all clients,
+	 * so only build them once and queue the same packet for everyone. */
+	Packet *frame_packet = send_frame ? NewFramePacket() : NULL;
+	if (frame_packet != NULL) frame_packet->PrepareToSend();
+#ifndef ENABLE_NETWORK_SYNC_EVERY_FRAME
+	Packet *sync_packet = send_sync ? NewSyncPacket() : NULL;
+	if (sync_packet != NULL) sync_packet->PrepareToSend();
+#endif
+
 	/* Now we are done with the frame, inform the clients that they can
 	 *  do their frame! */
 	FOR_ALL_CLIENT_SOCKETS(cs) {
@@ -1909,18 +2122,28 @@ void NetworkServer_Tick(bool send_frame)
 		}
 
 		if (cs->status >= NetworkClientSocket::STATUS_PRE_ACTIVE) {
+			cs->BeginBatch();
+
 			/* Check if we can send command, and if we have anything in the queue */
 			NetworkHandleCommandQueue(cs);
 
 			/* Send an updated _frame_counter_max to the client */
-			if (send_frame) cs->SendFrame();
+			if (send_frame) cs->SendFrame(frame_packet);
 
 #ifndef ENABLE_NETWORK_SYNC_EVERY_FRAME
 			/* Send a sync-check packet */
-			if (send_sync) cs->SendSync();
+			if (send_sync) cs->SendSync(sync_packet);
 #endif
+
+			cs->EndBatch();
 		}
 	}
+	ServerNetworkGameSocketHandler::ClearBatchCache();
+
+	if (frame_packet != NULL) frame_packet->Release();
+#ifndef ENABLE_NETWORK_SYNC_EVERY_FRAME
+	if (sync_packet != NULL) sync_packet->Release();
+#endif
 
 	/* See if we need to advertise */
 	NetworkUDPAdvertise();
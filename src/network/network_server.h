@@ -52,6 +52,8 @@ protected:
 	NetworkRecvStatus SendNeedGamePassword();
 	NetworkRecvStatus SendNeedCompanyPassword();
 
+	void FlushBatch();
+
 public:
 	/** Status of a client */
 	enum ClientStatus {
@@ -74,6 +76,8 @@ public:
 	ClientStatus status;         ///< Status of this client
 	CommandQueue outgoing_queue; ///< The command-queue awaiting delivery
 	int receive_limit;           ///< Amount of bytes that we can receive at this moment
+	bool batching;               ///< Whether packets of the current frame are being collected in #batch
+	SmallVector<byte, 256> batch; ///< Complete packets collected for the next PACKET_SERVER_BATCH
 
 	struct PacketWriter *savegame; ///< Writer used to write the savegame.
 	NetworkAddress client_address; ///< IP-address of the client (so he can be banned)
@@ -82,6 +86,7 @@ public:
 	~ServerNetworkGameSocketHandler();
 
 	virtual Packet *ReceivePacket();
+	virtual void SendPacket(Packet *packet);
 	NetworkRecvStatus CloseConnection(NetworkRecvStatus status);
 	void GetClientName(char *client_name, const char *last) const;
 
@@ -97,14 +102,18 @@ public:
 	NetworkRecvStatus SendError(NetworkErrorCode error);
 	NetworkRecvStatus SendChat(NetworkAction action, ClientID client_id, bool self_send, const char *msg, int64 data);
 	NetworkRecvStatus SendJoin(ClientID client_id);
-	NetworkRecvStatus SendFrame();
-	NetworkRecvStatus SendSync();
+	NetworkRecvStatus SendFrame(Packet *shared = NULL);
+	NetworkRecvStatus SendSync(Packet *shared = NULL);
 	NetworkRecvStatus SendCommand(const CommandPacket *cp);
 	NetworkRecvStatus SendCompanyUpdate();
 	NetworkRecvStatus SendConfigUpdate();
 
+	void BeginBatch();
+	void EndBatch();
+	static void ClearBatchCache();
+
 	static void Send();
-	static void AcceptConnection(SOCKET s, const NetworkAddress &address);
+	static ServerNetworkGameSocketHandler *AcceptConnection(SOCKET s, const NetworkAddress &address);
 	static bool AllowConnection();
 
 	/**
@@ -388,7 +388,7 @@ void CDECL grfmsg(int severity, const char *str, ...)
  * @param grfid The grfID to obtain the file for
  * @return The file.
  */
-static GRFFile *GetFileByGRFID(uint32 grfid)
+GRFFile *GetFileByGRFID(uint32 grfid)
 {
 	const GRFFile * const *end = _grf_files.End();
 	for (GRFFile * const *file = _grf_files.Begin(); file != end; file++) {
@@ -4631,6 +4631,7 @@ static void NewSpriteGroup(ByteReader *buf)
 			assert(DeterministicSpriteGroup::CanAllocateItem());
 			DeterministicSpriteGroup *group = new DeterministicSpriteGroup();
 			act_group = group;
+			group->grffile = _cur.grffile;
 			group->var_scope = HasBit(type, 1) ? VSG_SCOPE_PARENT : VSG_SCOPE_SELF;
 
 			switch (GB(type, 2, 2)) {
@@ -9125,6 +9126,9 @@ static void AfterLoadGRFs()
 	}
 	_grf_line_to_action6_sprite_override.clear();
 
+	/* Compile the varaction2 chains, now the parameters of the NewGRFs are final. */
+	CompileSpriteGroups();
+
 	/* Polish cargoes */
 	FinaliseCargoArray();
 
@@ -139,6 +139,11 @@ struct GRFFile : ZeroedMemoryAllocator {
 	uint32 grf_features;                     ///< Bitset of GrfSpecFeature the grf uses
 	PriceMultipliers price_base_multipliers; ///< Price base multipliers as set by the grf.
 
+	uint32 callback_cache_hits;              ///< Number of callback results that were found in the callback cache.
+	uint32 callback_cache_misses;            ///< Number of callbacks that were looked up in the callback cache, but had to be resolved.
+	uint32 tick_callback_cache_hits;         ///< Number of callback results of the game loop that were found in the callback cache.
+	uint32 tick_callback_cache_misses;       ///< Number of callbacks of the game loop that were looked up in the callback cache, but had to be resolved.
+
 	GRFFile(const struct GRFConfig *config);
 	~GRFFile();
 
@@ -188,6 +193,7 @@ void LoadNewGRF(uint load_index, uint file_index);
 void ReloadNewGRFData(); // in saveload/afterload.cpp
 void ResetNewGRFData();
 void ResetPersistentNewGRFData();
+GRFFile *GetFileByGRFID(uint32 grfid);
 
 void CDECL grfmsg(int severity, const char *str, ...) WARN_FORMAT(2, 3);
 
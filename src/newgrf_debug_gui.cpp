@@ -20,6 +20,7 @@
 #include "textbuf_gui.h"
 #include "vehicle_gui.h"
 #include "zoom_func.h"
+#include "settings_type.h"
 
 #include "engine_base.h"
 #include "industry.h"
@@ -30,6 +31,7 @@
 #include "train.h"
 #include "roadveh.h"
 
+#include "newgrf.h"
 #include "newgrf_airporttiles.h"
 #include "newgrf_debug.h"
 #include "newgrf_object.h"
@@ -544,6 +546,20 @@ struct NewGRFInspectWindow : Window {
 			}
 		}
 
+		const GRFFile *grffile = GetFileByGRFID(nih->GetGRFID(index));
+		if (_settings_client.gui.newgrf_draw_callback_cache && grffile != NULL) {
+			uint32 hits = grffile->callback_cache_hits;
+			uint32 lookups = hits + grffile->callback_cache_misses;
+			this->DrawString(r, i++, "Draw-time callback cache of the NewGRF:");
+			this->DrawString(r, i++, "  %u hits, %u misses (%u%% hit rate)", hits, lookups - hits, lookups == 0 ? 0 : (uint)((uint64)hits * 100 / lookups));
+		}
+		if (_settings_game.vehicle.newgrf_tick_callback_cache && grffile != NULL) {
+			uint32 hits = grffile->tick_callback_cache_hits;
+			uint32 lookups = hits + grffile->tick_callback_cache_misses;
+			this->DrawString(r, i++, "Game loop callback cache of the NewGRF:");
+			this->DrawString(r, i++, "  %u hits, %u misses (%u%% hit rate)", hits, lookups - hits, lookups == 0 ? 0 : (uint)((uint64)hits * 100 / lookups));
+		}
+
 		/* Not nice and certainly a hack, but it beats duplicating
 		 * this whole function just to count the actual number of
 		 * elements. Especially because they need to be redrawn. */
@@ -613,6 +629,12 @@ struct NewGRFInspectWindow : Window {
 		this->vscroll->SetCapacityFromWidget(this, WID_NGRFI_MAINPANEL, TOP_OFFSET + BOTTOM_OFFSET);
 	}
 
+	virtual void OnHundredthTick()
+	{
+		/* Keep the statistics of the callback cache up to date. */
+		if (_settings_client.gui.newgrf_draw_callback_cache || _settings_game.vehicle.newgrf_tick_callback_cache) this->SetWidgetDirty(WID_NGRFI_MAINPANEL);
+	}
+
 	/**
 	 * Some data on this window has become invalid.
 	 * @param data Information about the changed data.
@@ -952,6 +952,48 @@ static uint32 VehicleGetVariable(Vehicle *v, const VehicleScopeResolver *object,
 	return in_motion ? group->loaded[set] : group->loading[set];
 }
 
+/* virtual */ bool VehicleResolverObject::GetCallbackCacheKey(CallbackCacheKey *key) const
+{
+	const Vehicle *v = this->self_scope.v;
+
+	key->object = v;
+	key->related = this->parent_scope.v;
+	key->data[0] = this->self_scope.self_type | this->self_scope.info_view << 16;
+	/* The refit GUIs temporarily change the cargo of the vehicle to query the NewGRF. */
+	if (v != NULL) key->data[1] = v->cargo_type | v->cargo_subtype << 8;
+
+	/* What changes while the vehicle moves and loads, so results of the game loop are not reused after that. */
+	if (v != NULL) {
+		key->state[0] = v->x_pos;
+		key->state[1] = v->y_pos;
+		key->state[2] = v->cargo.StoredCount() | v->vehstatus << 16 | v->waiting_triggers << 24;
+		key->state[3] = v->cur_speed | v->random_bits << 16;
+	}
+	return true;
+}
+
+/* virtual */ bool VehicleResolverObject::IsTickCachedCallback() const
+{
+	switch (this->callback) {
+		case CBID_VEHICLE_32DAY_CALLBACK:
+		case CBID_VEHICLE_REFIT_CAPACITY:
+			return true;
+
+		case CBID_VEHICLE_MODIFY_PROPERTY:
+			/* The speed limits and the capacities. */
+			switch (Engine::Get(this->self_scope.self_type)->type) {
+				case VEH_TRAIN:    return this->callback_param1 == PROP_TRAIN_SPEED || this->callback_param1 == PROP_TRAIN_CARGO_CAPACITY;
+				case VEH_ROAD:     return this->callback_param1 == PROP_ROADVEH_SPEED || this->callback_param1 == PROP_ROADVEH_CARGO_CAPACITY;
+				case VEH_SHIP:     return this->callback_param1 == PROP_SHIP_SPEED || this->callback_param1 == PROP_SHIP_CARGO_CAPACITY;
+				case VEH_AIRCRAFT: return this->callback_param1 == PROP_AIRCRAFT_SPEED || this->callback_param1 == PROP_AIRCRAFT_PASSENGER_CAPACITY || this->callback_param1 == PROP_AIRCRAFT_MAIL_CAPACITY;
+				default: return false;
+			}
+
+		default:
+			return false;
+	}
+}
+
 /**
  * Scope resolver of a single vehicle.
  * @param ro Surrounding resolver.
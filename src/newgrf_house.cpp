@@ -86,6 +86,17 @@ HouseResolverObject::HouseResolverObject(HouseID house_id, TileIndex tile, Town
 	this->root_spritegroup = HouseSpec::Get(house_id)->grf_prop.spritegroup[0];
 }
 
+/* virtual */ bool HouseResolverObject::GetCallbackCacheKey(CallbackCacheKey *key) const
+{
+	/* Construction checks and cargo triggers are not drawn. */
+	if (this->house_scope.not_yet_constructed || this->house_scope.watched_cargo_triggers != 0) return false;
+
+	key->object = this->house_scope.town;
+	key->data[0] = this->house_scope.tile;
+	key->data[1] = this->house_scope.house_id;
+	return true;
+}
+
 HouseClassID AllocateHouseClassID(byte grf_class_id, uint32 grfid)
 {
 	/* Start from 1 because 0 means that no class has been assigned. */
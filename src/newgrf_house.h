@@ -53,6 +53,8 @@ struct HouseResolverObject : public ResolverObject {
 			default: return ResolverObject::GetScope(scope, relative);
 		}
 	}
+
+	/* virtual */ bool GetCallbackCacheKey(CallbackCacheKey *key) const;
 };
 
 /**
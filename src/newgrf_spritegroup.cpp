@@ -11,7 +11,10 @@
 
 #include "stdafx.h"
 #include "debug.h"
+#include "newgrf.h"
 #include "newgrf_spritegroup.h"
+#include "command_func.h"
+#include "settings_type.h"
 #include "core/pool_func.hpp"
 
 #include "safeguards.h"
@@ -21,6 +24,23 @@ INSTANTIATE_POOL_METHODS(SpriteGroup)
 
 TemporaryStorageArray<int32, 0x110> _temp_store;
 
+/** Number of entries of the callback cache; must be a power of 2. */
+static const uint CALLBACK_CACHE_SIZE = 2048;
+
+/** A memoised callback result. */
+struct CallbackCacheEntry {
+	CallbackCacheKey key; ///< What the result was resolved for.
+	uint32 generation;    ///< Generation of the cache the result was stored in.
+	uint32 last_value;    ///< ResolverObject::last_value after resolving the callback.
+	uint16 result;        ///< The callback result.
+};
+
+static CallbackCacheEntry _callback_cache[CALLBACK_CACHE_SIZE]; ///< The memoised callback results.
+static uint32 _callback_cache_generation = 0; ///< Generation of the valid entries of the callback cache.
+static bool _callback_cache_active = false;   ///< Whether callback results are memoised at the moment.
+static bool _callback_cache_tick = false;     ///< Whether the callback results are memoised for the game loop instead of for drawing.
+static bool _callback_side_effects = false;   ///< Whether the callbacks being resolved stored something in registers or persistent storage.
+
 
 /**
  * ResolverObject (re)entry point.
@@ -51,6 +71,7 @@ DeterministicSpriteGroup::~DeterministicSpriteGroup()
 {
 	free(this->adjusts);
 	free(this->ranges);
+	free(this->program);
 }
 
 RandomizedSpriteGroup::~RandomizedSpriteGroup()
@@ -157,6 +178,159 @@ ResolverObject::ResolverObject(const GRFFile *grffile, CallbackID callback, uint
 
 ResolverObject::~ResolverObject() {}
 
+/**
+ * Get the key to memoise the callback results of this resolver with.
+ * Only the parts that identify the objects the scopes are resolved for
+ * have to be filled; \a key has been zeroed before.
+ * @param[out] key The key to fill.
+ * @return Whether the callback results of this resolver may be memoised.
+ */
+/* virtual */ bool ResolverObject::GetCallbackCacheKey(CallbackCacheKey *key) const
+{
+	return false;
+}
+
+/**
+ * Check whether the result of the callback being resolved may be memoised
+ * within a tick of the game loop, provided the key changes with every
+ * state of the object the callback depends on.
+ * @return Whether the callback is memoised by the game loop.
+ */
+/* virtual */ bool ResolverObject::IsTickCachedCallback() const
+{
+	return false;
+}
+
+/**
+ * Get the index of the entry a callback result is memoised in.
+ * @param key The key of the callback result.
+ * @return The index in the callback cache.
+ */
+static uint GetCallbackCacheIndex(const CallbackCacheKey &key)
+{
+	assert_compile(sizeof(CallbackCacheKey) % sizeof(uint32) == 0);
+	const uint32 *data = (const uint32 *)&key;
+
+	uint32 hash = 0x811C9DC5;
+	for (uint i = 0; i < sizeof(key) / sizeof(uint32); i++) {
+		hash = (hash ^ data[i]) * 0x01000193;
+	}
+	return (hash ^ (hash >> 16)) & (CALLBACK_CACHE_SIZE - 1);
+}
+
+/**
+ * Resolve callback.
+ * While the callback cache is active, the results of callbacks that do not
+ * store anything in registers or persistent storage are memoised, so
+ * resolving the same callback for the same objects again is cheap.
+ * In the game loop only the callbacks chosen by the resolver are memoised.
+ * @return Callback result.
+ */
+uint16 ResolverObject::ResolveCallback()
+{
+	CallbackCacheKey key;
+	bool cacheable = _callback_cache_active && this->trigger == 0 && this->grffile != NULL && this->root_spritegroup != NULL && !IsCommandRunning();
+	if (cacheable && _callback_cache_tick) cacheable = this->IsTickCachedCallback();
+	if (cacheable) {
+		memset(&key, 0, sizeof(key));
+		cacheable = this->GetCallbackCacheKey(&key);
+	}
+
+	if (!cacheable) {
+		const SpriteGroup *result = Resolve();
+		return result != NULL ? result->GetCallbackResult() : CALLBACK_FAILED;
+	}
+
+	key.root = this->root_spritegroup;
+	key.callback = this->callback;
+	key.callback_param1 = this->callback_param1;
+	key.callback_param2 = this->callback_param2;
+
+	/* The statistics are the only thing about the GRF that changes while resolving. */
+	GRFFile *grffile = const_cast<GRFFile *>(this->grffile);
+	CallbackCacheEntry *entry = &_callback_cache[GetCallbackCacheIndex(key)];
+	if (entry->generation == _callback_cache_generation && memcmp(&entry->key, &key, sizeof(key)) == 0) {
+		if (_callback_cache_tick) {
+			grffile->tick_callback_cache_hits++;
+		} else {
+			grffile->callback_cache_hits++;
+		}
+		/* Resolving would have cleared the registers too. */
+		_temp_store.ClearChanges();
+		this->last_value = entry->last_value;
+		return entry->result;
+	}
+	if (_callback_cache_tick) {
+		grffile->tick_callback_cache_misses++;
+	} else {
+		grffile->callback_cache_misses++;
+	}
+
+	bool side_effects = _callback_side_effects;
+	_callback_side_effects = false;
+
+	const SpriteGroup *group = Resolve();
+	uint16 result = group != NULL ? group->GetCallbackResult() : CALLBACK_FAILED;
+
+	if (!_callback_side_effects) {
+		entry->key = key;
+		entry->generation = _callback_cache_generation;
+		entry->last_value = this->last_value;
+		entry->result = result;
+	}
+	_callback_side_effects |= side_effects;
+	return result;
+}
+
+/**
+ * Drop everything that was memoised before.
+ */
+static void ClearNewGRFCallbackCache()
+{
+	if (++_callback_cache_generation == 0) {
+		memset(_callback_cache, 0, sizeof(_callback_cache));
+		_callback_cache_generation = 1;
+	}
+}
+
+/**
+ * Start memoising callback results, if enabled by the player.
+ * The results of the callbacks are only valid as long as the game state
+ * does not change, so this must only be used while drawing.
+ */
+void StartNewGRFCallbackCache()
+{
+	if (!_settings_client.gui.newgrf_draw_callback_cache) return;
+
+	ClearNewGRFCallbackCache();
+	_callback_cache_active = true;
+	_callback_cache_tick = false;
+}
+
+/**
+ * Start memoising the results of the callbacks of the game loop, if enabled
+ * for the game. Only part of the game state is in the keys of the results,
+ * so a memoised result may differ from resolving the callback again. That
+ * is why this is a setting of the game: all clients have to memoise alike.
+ */
+void StartNewGRFTickCallbackCache()
+{
+	if (!_settings_game.vehicle.newgrf_tick_callback_cache) return;
+
+	ClearNewGRFCallbackCache();
+	_callback_cache_active = true;
+	_callback_cache_tick = true;
+}
+
+/**
+ * Stop memoising callback results, as the game state may change again.
+ */
+void StopNewGRFCallbackCache()
+{
+	_callback_cache_active = false;
+	_callback_cache_tick = false;
+}
+
 /**
  * Get the real sprites of the grf.
  * @param group Group to get.
@@ -193,10 +367,11 @@ static uint32 RotateRight(uint32 val, uint32 rot)
 }
 
 
-/* Evaluate an adjustment for a variable of the given size.
- * U is the unsigned type and S is the signed type to use. */
-template <typename U, typename S>
-static U EvalAdjustT(const DeterministicSpriteGroupAdjust *adjust, ScopeResolver *scope, U last_value, uint32 value)
+/* Evaluate the operand of an adjustment for a variable of the given size.
+ * U is the unsigned type and S is the signed type to use.
+ * T is either a DeterministicSpriteGroupAdjust or its compiled instruction. */
+template <typename U, typename S, typename T>
+static inline uint32 EvalAdjustValueT(const T *adjust, uint32 value)
 {
 	value >>= adjust->shift_num;
 	value  &= adjust->and_mask;
@@ -209,7 +384,15 @@ static U EvalAdjustT(const DeterministicSpriteGroupAdjust *adjust, ScopeResolver
 		case DSGA_TYPE_NONE: break;
 	}
 
-	switch (adjust->operation) {
+	return value;
+}
+
+/* Apply the operation of an adjustment for a variable of the given size.
+ * U is the unsigned type and S is the signed type to use. */
+template <typename U, typename S>
+static inline U EvalAdjustOperationT(DeterministicSpriteGroupAdjustOperation operation, ScopeResolver *scope, U last_value, uint32 value)
+{
+	switch (operation) {
 		case DSGA_OP_ADD:  return last_value + value;
 		case DSGA_OP_SUB:  return last_value - value;
 		case DSGA_OP_SMIN: return min((S)last_value, (S)value);
@@ -237,20 +420,32 @@ static U EvalAdjustT(const DeterministicSpriteGroupAdjust *adjust, ScopeResolver
 	}
 }
 
+/* Evaluate an adjustment for a variable of the given size.
+ * U is the unsigned type and S is the signed type to use. */
+template <typename U, typename S>
+static U EvalAdjustT(const DeterministicSpriteGroupAdjust *adjust, ScopeResolver *scope, U last_value, uint32 value)
+{
+	return EvalAdjustOperationT<U, S>(adjust->operation, scope, last_value, EvalAdjustValueT<U, S>(adjust, value));
+}
 
-const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) const
+/**
+ * Evaluate the adjusts of a group one by one, the way they were read from the NewGRF.
+ * @param group The group to evaluate.
+ * @param object The object to resolve for.
+ * @param[out] available Set to false when a variable is not available.
+ * @return The value to choose the next group with.
+ */
+static uint32 EvaluateAdjusts(const DeterministicSpriteGroup *group, ResolverObject &object, bool *available)
 {
 	uint32 last_value = 0;
 	uint32 value = 0;
-	uint i;
 
-	ScopeResolver *scope = object.GetScope(this->var_scope);
+	ScopeResolver *scope = object.GetScope(group->var_scope);
 
-	for (i = 0; i < this->num_adjusts; i++) {
-		DeterministicSpriteGroupAdjust *adjust = &this->adjusts[i];
+	for (uint i = 0; i < group->num_adjusts; i++) {
+		const DeterministicSpriteGroupAdjust *adjust = &group->adjusts[i];
 
 		/* Try to get the variable. We shall assume it is available, unless told otherwise. */
-		bool available = true;
 		if (adjust->variable == 0x7E) {
 			const SpriteGroup *subgroup = SpriteGroup::Resolve(adjust->subroutine, object, false);
 			if (subgroup == NULL) {
@@ -261,18 +456,16 @@ const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) con
 
 			/* Note: 'last_value' and 'reseed' are shared between the main chain and the procedure */
 		} else if (adjust->variable == 0x7B) {
-			value = GetVariable(object, scope, adjust->parameter, last_value, &available);
+			value = GetVariable(object, scope, adjust->parameter, last_value, available);
 		} else {
-			value = GetVariable(object, scope, adjust->variable, adjust->parameter, &available);
+			value = GetVariable(object, scope, adjust->variable, adjust->parameter, available);
 		}
 
-		if (!available) {
-			/* Unsupported variable: skip further processing and return either
-			 * the group from the first range or the default group. */
-			return SpriteGroup::Resolve(this->num_ranges > 0 ? this->ranges[0].group : this->default_group, object, false);
-		}
+		if (!*available) return 0;
 
-		switch (this->size) {
+		if (adjust->operation == DSGA_OP_STO || adjust->operation == DSGA_OP_STOP) _callback_side_effects = true;
+
+		switch (group->size) {
 			case DSG_SIZE_BYTE:  value = EvalAdjustT<uint8,  int8> (adjust, scope, last_value, value); break;
 			case DSG_SIZE_WORD:  value = EvalAdjustT<uint16, int16>(adjust, scope, last_value, value); break;
 			case DSG_SIZE_DWORD: value = EvalAdjustT<uint32, int32>(adjust, scope, last_value, value); break;
@@ -281,23 +474,241 @@ const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) con
 		last_value = value;
 	}
 
-	object.last_value = last_value;
+	return value;
+}
+
+/**
+ * Run the compiled program of a group for a variable of the given size.
+ * U is the unsigned type and S is the signed type to use.
+ * @param group The group to run the program of.
+ * @param object The object to resolve for.
+ * @param[out] available Set to false when a variable is not available.
+ * @return The value to choose the next group with.
+ */
+template <typename U, typename S>
+static uint32 RunProgramT(const DeterministicSpriteGroup *group, ResolverObject &object, bool *available)
+{
+	uint32 last_value = group->initial_value;
+	if (group->num_instructions == 0) return last_value;
+
+	if (group->stores) _callback_side_effects = true;
+
+	ScopeResolver *scope = object.GetScope(group->var_scope);
+
+	const DeterministicSpriteGroupInstruction *end = group->program + group->num_instructions;
+	for (const DeterministicSpriteGroupInstruction *insn = group->program; insn != end; insn++) {
+		uint32 value;
+		switch (insn->source) {
+			case DSGS_CONSTANT:
+				last_value = EvalAdjustOperationT<U, S>((DeterministicSpriteGroupAdjustOperation)insn->operation, scope, last_value, insn->value);
+				continue;
+
+			case DSGS_SCOPE:
+				value = scope->GetVariable(insn->variable, insn->parameter, available);
+				break;
+
+			case DSGS_VARIABLE:
+				value = GetVariable(object, scope, insn->variable, insn->parameter, available);
+				break;
+
+			case DSGS_PROCEDURE: {
+				const SpriteGroup *subgroup = SpriteGroup::Resolve(insn->subroutine, object, false);
+				value = subgroup != NULL ? subgroup->GetCallbackResult() : CALLBACK_FAILED;
+				break;
+			}
+
+			case DSGS_PARAMETERISED:
+				value = GetVariable(object, scope, insn->parameter, last_value, available);
+				break;
+
+			default: NOT_REACHED();
+		}
+
+		if (!*available) return 0;
+
+		last_value = EvalAdjustOperationT<U, S>((DeterministicSpriteGroupAdjustOperation)insn->operation, scope, last_value, EvalAdjustValueT<U, S>(insn, value));
+	}
+
+	return last_value;
+}
+
+const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) const
+{
+	/* Chains of deterministic groups are followed here, instead of recursing for each of them. */
+	const DeterministicSpriteGroup *group = this;
+	for (;;) {
+		bool available = true;
+		uint32 value;
+		if (!group->compiled || group->grffile != object.grffile) {
+			/* The program was compiled with the parameters of another NewGRF. */
+			value = EvaluateAdjusts(group, object, &available);
+		} else {
+			switch (group->size) {
+				case DSG_SIZE_BYTE:  value = RunProgramT<uint8,  int8> (group, object, &available); break;
+				case DSG_SIZE_WORD:  value = RunProgramT<uint16, int16>(group, object, &available); break;
+				case DSG_SIZE_DWORD: value = RunProgramT<uint32, int32>(group, object, &available); break;
+				default: NOT_REACHED();
+			}
+		}
+
+		const SpriteGroup *next;
+		if (!available) {
+			/* Unsupported variable: skip further processing and return either
+			 * the group from the first range or the default group. */
+			next = group->num_ranges > 0 ? group->ranges[0].group : group->default_group;
+		} else {
+			object.last_value = value;
+
+			if (group->num_ranges == 0) {
+				/* nvar == 0 is a special case -- we turn our value into a callback result */
+				if (value != CALLBACK_FAILED) value = GB(value, 0, 15);
+				static CallbackResultSpriteGroup nvarzero(0, true);
+				nvarzero.result = value;
+				return &nvarzero;
+			}
+
+			next = group->default_group;
+			for (uint i = 0; i < group->num_ranges; i++) {
+				if (group->ranges[i].low <= value && value <= group->ranges[i].high) {
+					next = group->ranges[i].group;
+					break;
+				}
+			}
+		}
+
+		if (next == NULL || next->type != SGT_DETERMINISTIC) return SpriteGroup::Resolve(next, object, false);
+		group = (const DeterministicSpriteGroup *)next;
+	}
+}
 
-	if (this->num_ranges == 0) {
-		/* nvar == 0 is a special case -- we turn our value into a callback result */
-		if (value != CALLBACK_FAILED) value = GB(value, 0, 15);
-		static CallbackResultSpriteGroup nvarzero(0, true);
-		nvarzero.result = value;
-		return &nvarzero;
+/**
+ * Get the value of a variable that cannot change after the NewGRFs are loaded.
+ * @param variable The variable.
+ * @param parameter The parameter of the variable.
+ * @param grffile The NewGRF the variable is read by.
+ * @param[out] value The value of the variable.
+ * @return Whether the variable is constant.
+ */
+static bool GetConstantVariable(byte variable, byte parameter, const GRFFile *grffile, uint32 *value)
+{
+	switch (variable) {
+		case 0x0B: // TTDPatch version
+		case 0x1A: // Always -1
+		case 0x1D: // TTD platform
+		case 0x21: // OpenTTD version
+			return GetGlobalVariable(variable, value, grffile);
+
+		case 0x7F: // NewGRF parameter
+			*value = grffile != NULL ? grffile->GetParam(parameter) : 0;
+			return true;
+
+		default:
+			return false;
 	}
+}
+
+/**
+ * Fold the operand of a constant instruction for a variable of the given size.
+ * U is the unsigned type and S is the signed type to use.
+ * @param insn The instruction.
+ * @param value The value of its variable.
+ */
+template <typename U, typename S>
+static void FoldConstantT(DeterministicSpriteGroupInstruction *insn, uint32 value)
+{
+	insn->source = DSGS_CONSTANT;
+	insn->value = EvalAdjustValueT<U, S>(insn, value);
+}
 
-	for (i = 0; i < this->num_ranges; i++) {
-		if (this->ranges[i].low <= value && value <= this->ranges[i].high) {
-			return SpriteGroup::Resolve(this->ranges[i].group, object, false);
+/**
+ * Compile the adjusts into a program that is quicker to run. Variables that
+ * are constant once the NewGRFs are loaded are evaluated now, and leading
+ * adjusts that only work with such constants are folded into #initial_value.
+ * The program has to give exactly the same results as evaluating the adjusts.
+ */
+void DeterministicSpriteGroup::Compile()
+{
+	free(this->program);
+	this->program = MallocT<DeterministicSpriteGroupInstruction>(this->num_adjusts);
+	this->num_instructions = 0;
+	this->initial_value = 0;
+	this->stores = false;
+
+	bool folding = true;
+	for (uint i = 0; i < this->num_adjusts; i++) {
+		const DeterministicSpriteGroupAdjust *adjust = &this->adjusts[i];
+		DeterministicSpriteGroupInstruction *insn = &this->program[this->num_instructions];
+
+		insn->operation  = adjust->operation;
+		insn->type       = adjust->type;
+		insn->variable   = adjust->variable;
+		insn->parameter  = adjust->parameter;
+		insn->shift_num  = adjust->shift_num;
+		insn->and_mask   = adjust->and_mask;
+		insn->add_val    = adjust->add_val;
+		insn->divmod_val = adjust->divmod_val;
+
+		bool store = adjust->operation == DSGA_OP_STO || adjust->operation == DSGA_OP_STOP;
+		if (store) this->stores = true;
+
+		uint32 value;
+		if (adjust->variable == 0x7E) {
+			insn->source = DSGS_PROCEDURE;
+			insn->subroutine = adjust->subroutine;
+		} else if (adjust->variable == 0x7B) {
+			insn->source = DSGS_PARAMETERISED;
+		} else if (GetConstantVariable(adjust->variable, adjust->parameter, this->grffile, &value)) {
+			switch (this->size) {
+				case DSG_SIZE_BYTE:  FoldConstantT<uint8,  int8> (insn, value); break;
+				case DSG_SIZE_WORD:  FoldConstantT<uint16, int16>(insn, value); break;
+				case DSG_SIZE_DWORD: FoldConstantT<uint32, int32>(insn, value); break;
+				default: NOT_REACHED();
+			}
+		} else if (adjust->variable >= 0x40 && adjust->variable != 0x5F && adjust->variable != 0x7D && adjust->variable != 0x7F) {
+			/* Neither a global variable nor one that needs the resolver object. */
+			insn->source = DSGS_SCOPE;
+		} else {
+			insn->source = DSGS_VARIABLE;
 		}
+
+		if (folding && insn->source == DSGS_CONSTANT && !store) {
+			/* Operations on constants before anything is read or stored give constants. */
+			switch (this->size) {
+				case DSG_SIZE_BYTE:  this->initial_value = EvalAdjustOperationT<uint8,  int8> (adjust->operation, NULL, this->initial_value, insn->value); break;
+				case DSG_SIZE_WORD:  this->initial_value = EvalAdjustOperationT<uint16, int16>(adjust->operation, NULL, this->initial_value, insn->value); break;
+				case DSG_SIZE_DWORD: this->initial_value = EvalAdjustOperationT<uint32, int32>(adjust->operation, NULL, this->initial_value, insn->value); break;
+				default: NOT_REACHED();
+			}
+			continue;
+		}
+
+		folding = false;
+		this->num_instructions++;
+	}
+
+	this->compiled = true;
+}
+
+/**
+ * Compile all deterministic sprite groups, once the NewGRFs are loaded and
+ * their parameters are final.
+ */
+void CompileSpriteGroups()
+{
+	uint count = 0;
+	uint folded = 0;
+
+	SpriteGroup *group;
+	FOR_ALL_ITEMS(SpriteGroup, spritegroup_index, group) {
+		if (group->type != SGT_DETERMINISTIC) continue;
+
+		DeterministicSpriteGroup *dsg = (DeterministicSpriteGroup *)group;
+		dsg->Compile();
+		count++;
+		folded += dsg->num_adjusts - dsg->num_instructions;
 	}
 
-	return SpriteGroup::Resolve(this->default_group, object, false);
+	DEBUG(grf, 2, "Compiled %u deterministic sprite groups, folded %u adjusts", count, folded);
 }
 
 
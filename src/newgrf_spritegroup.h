@@ -166,6 +166,32 @@ struct DeterministicSpriteGroupRange {
 	uint32 high;
 };
 
+/** Where a #DeterministicSpriteGroupInstruction gets its operand from. */
+enum DeterministicSpriteGroupSource {
+	DSGS_CONSTANT,      ///< The operand was folded when compiling the group.
+	DSGS_VARIABLE,      ///< A variable that is common to all features.
+	DSGS_SCOPE,         ///< A variable of the scope of the group.
+	DSGS_PROCEDURE,     ///< The result of a procedure call (variable 0x7E).
+	DSGS_PARAMETERISED, ///< A variable with the last value as parameter (variable 0x7B).
+};
+
+/** A compiled #DeterministicSpriteGroupAdjust. */
+struct DeterministicSpriteGroupInstruction {
+	byte source;       ///< #DeterministicSpriteGroupSource of the operand.
+	byte operation;    ///< #DeterministicSpriteGroupAdjustOperation to perform.
+	byte type;         ///< #DeterministicSpriteGroupAdjustType of the operand.
+	byte variable;     ///< Variable to read.
+	byte parameter;    ///< Parameter of the variable.
+	byte shift_num;    ///< Number of bits to shift the variable right.
+	uint32 and_mask;   ///< Mask to apply to the variable.
+	uint32 add_val;    ///< Value to add to the variable.
+	uint32 divmod_val; ///< Value to divide the variable by.
+	union {
+		uint32 value;                  ///< Folded operand, for #DSGS_CONSTANT.
+		const SpriteGroup *subroutine; ///< Procedure to call, for #DSGS_PROCEDURE.
+	};
+};
+
 
 struct DeterministicSpriteGroup : SpriteGroup {
 	DeterministicSpriteGroup() : SpriteGroup(SGT_DETERMINISTIC) {}
@@ -181,6 +207,15 @@ struct DeterministicSpriteGroup : SpriteGroup {
 	/* Dynamically allocated, this is the sole owner */
 	const SpriteGroup *default_group;
 
+	const GRFFile *grffile;                       ///< NewGRF that defined the group.
+	bool compiled;                                ///< Whether #program is valid.
+	bool stores;                                  ///< Whether the adjusts store into temporary or persistent storage.
+	uint num_instructions;                        ///< Number of instructions in #program.
+	DeterministicSpriteGroupInstruction *program; ///< The adjusts that could not be folded.
+	uint32 initial_value;                         ///< Result of the folded adjusts before the first instruction.
+
+	void Compile();
+
 protected:
 	const SpriteGroup *Resolve(ResolverObject &object) const;
 };
@@ -299,6 +334,21 @@ struct ScopeResolver {
 	virtual void StorePSA(uint reg, int32 value);
 };
 
+/**
+ * Everything the result of a callback depends on, besides the game state.
+ * Used by #ResolverObject::ResolveCallback to find memoised callback results.
+ */
+struct CallbackCacheKey {
+	const SpriteGroup *root; ///< Root SpriteGroup the callback is resolved with.
+	const void *object;      ///< Main object the callback is resolved for.
+	const void *related;     ///< Other object the resolver has a scope for.
+	uint32 data[2];          ///< Further values that are passed to the scope resolvers.
+	uint32 state[4];         ///< State of the main object that may change within a tick of the game loop.
+	uint32 callback_param1;  ///< First parameter (var 10) of the callback.
+	uint32 callback_param2;  ///< Second parameter (var 18) of the callback.
+	CallbackID callback;     ///< Callback being resolved.
+};
+
 /**
  * Interface for #SpriteGroup-s to access the gamestate.
  *
@@ -332,18 +382,13 @@ struct ResolverObject {
 		return SpriteGroup::Resolve(this->root_spritegroup, *this);
 	}
 
-	/**
-	 * Resolve callback.
-	 * @return Callback result.
-	 */
-	uint16 ResolveCallback()
-	{
-		const SpriteGroup *result = Resolve();
-		return result != NULL ? result->GetCallbackResult() : CALLBACK_FAILED;
-	}
+	uint16 ResolveCallback();
 
 	virtual const SpriteGroup *ResolveReal(const RealSpriteGroup *group) const;
 
+	virtual bool GetCallbackCacheKey(CallbackCacheKey *key) const;
+	virtual bool IsTickCachedCallback() const;
+
 	virtual ScopeResolver *GetScope(VarSpriteGroupScope scope = VSG_SCOPE_SELF, byte relative = 0);
 
 	/**
@@ -372,4 +417,10 @@ struct ResolverObject {
 	}
 };
 
+void CompileSpriteGroups();
+
+void StartNewGRFCallbackCache();
+void StartNewGRFTickCallbackCache();
+void StopNewGRFCallbackCache();
+
 #endif /* NEWGRF_SPRITEGROUP_H */
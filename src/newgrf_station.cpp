@@ -491,6 +491,15 @@ uint32 Waypoint::GetNewGRFVariable(const ResolverObject &object, byte variable,
 	return UINT_MAX;
 }
 
+/* virtual */ bool StationResolverObject::GetCallbackCacheKey(CallbackCacheKey *key) const
+{
+	key->object = this->station_scope.st;
+	key->related = this->station_scope.statspec;
+	key->data[0] = this->station_scope.tile;
+	key->data[1] = this->station_scope.cargo_type | this->station_scope.axis << 8;
+	return true;
+}
+
 /* virtual */ const SpriteGroup *StationResolverObject::ResolveReal(const RealSpriteGroup *group) const
 {
 	if (this->station_scope.st == NULL || this->station_scope.statspec->cls_id == STAT_CLASS_WAYP) {
@@ -68,6 +68,8 @@ struct StationResolverObject : public ResolverObject {
 	}
 
 	/* virtual */ const SpriteGroup *ResolveReal(const RealSpriteGroup *group) const;
+
+	/* virtual */ bool GetCallbackCacheKey(CallbackCacheKey *key) const;
 };
 
 enum StationClassID {
@@ -18,6 +18,7 @@
 #include "yapf_destrail.hpp"
 #include "../../viewport_func.h"
 #include "../../newgrf_station.h"
+#include "../../benchmark.h"
 
 #include "../../safeguards.h"
 
@@ -537,6 +538,8 @@ struct CYapfAnySafeTileRail2 : CYapfT<CYapfRail_TypesT<CYapfAnySafeTileRail2, CF
 
 Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target)
 {
+	BenchmarkTimer timer(BE_YAPF);
+
 	/* default is YAPF type 2 */
 	typedef Trackdir (*PfnChooseRailTrack)(const Train*, TileIndex, DiagDirection, TrackBits, bool&, bool, PBSTileInfo*);
 	PfnChooseRailTrack pfnChooseRailTrack = &CYapfRail1::stChooseRailTrack;
@@ -552,6 +555,8 @@ Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdi
 
 bool YapfTrainCheckReverse(const Train *v)
 {
+	BenchmarkTimer timer(BE_YAPF);
+
 	const Train *last_veh = v->Last();
 
 	/* get trackdirs of both ends */
@@ -611,6 +616,8 @@ bool YapfTrainCheckReverse(const Train *v)
 
 FindDepotData YapfTrainFindNearestDepot(const Train *v, int max_penalty)
 {
+	BenchmarkTimer timer(BE_YAPF);
+
 	FindDepotData fdd;
 
 	const Train *last_veh = v->Last();
@@ -634,6 +641,8 @@ FindDepotData YapfTrainFindNearestDepot(const Train *v, int max_penalty)
 
 bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, bool override_railtype)
 {
+	BenchmarkTimer timer(BE_YAPF);
+
 	typedef bool (*PfnFindNearestSafeTile)(const Train*, TileIndex, Trackdir, bool);
 	PfnFindNearestSafeTile pfnFindNearestSafeTile = CYapfAnySafeTileRail1::stFindNearestSafeTile;
 
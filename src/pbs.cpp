@@ -14,6 +14,7 @@
 #include "vehicle_func.h"
 #include "newgrf_station.h"
 #include "pathfinder/follow_track.hpp"
+#include "benchmark.h"
 
 #include "safeguards.h"
 
@@ -291,6 +292,7 @@ static Vehicle *FindTrainOnTrackEnum(Vehicle *v, void *data)
 PBSTileInfo FollowTrainReservation(const Train *v, Vehicle **train_on_res)
 {
 	assert(v->type == VEH_TRAIN);
+	BenchmarkTimer timer(BE_PBS);
 
 	TileIndex tile = v->tile;
 	Trackdir  trackdir = v->GetVehicleTrackdir();
@@ -333,6 +335,8 @@ PBSTileInfo FollowTrainReservation(const Train *v, Vehicle **train_on_res)
 Train *GetTrainForReservation(TileIndex tile, Track track)
 {
 	assert(HasReservedTracks(tile, TrackToTrackBits(track)));
+	BenchmarkTimer timer(BE_PBS);
+
 	Trackdir  trackdir = TrackToTrackdir(track);
 
 	RailTypes rts = GetRailTypeInfo(GetTileRailType(tile))->compatible_railtypes;
@@ -55,6 +55,7 @@
 #include "../order_backup.h"
 #include "../error.h"
 #include "../disaster_vehicle.h"
+#include "../spatial_index.h"
 
 
 #include "saveload_internal.h"
@@ -286,6 +287,7 @@ static void InitializeWindowsAndCaches()
 
 	GroupStatistics::UpdateAfterLoad();
 
+	RebuildSpatialIndices();
 	Station::RecomputeIndustriesNearForAll();
 	RebuildSubsidisedSourceAndDestinationCache();
 
@@ -559,6 +561,9 @@ bool AfterLoadGame()
 		_pause_mode &= ~PMB_PAUSED_NETWORK;
 	}
 
+	/* The conversions below look up the closest towns. */
+	RebuildSpatialIndices();
+
 	/* In very old versions, size of train stations was stored differently.
 	 * They had swapped width and height if station was built along the Y axis.
 	 * TTO and TTD used 3 bits for width/height, while OpenTTD used 4.
@@ -2987,6 +2992,9 @@ bool AfterLoadGame()
 	/* Restore the signals */
 	ResetSignalHandlers();
 
+	/* Signal blocks might have been explored while the map was still being converted. */
+	InvalidateSignalBlocks(INVALID_TILE);
+
 	AfterLoadLinkGraphs();
 	return true;
 }
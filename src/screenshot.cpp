@@ -608,9 +608,15 @@ static void CurrentScreenCallback(void *userdata, void *buf, uint y, uint pitch,
 	blitter->CopyImageToBuffer(src, buf, _screen.width, n, pitch);
 }
 
+/** Data about a screenshot of (a part of) the world that is being made. */
+struct LargeWorldScreenshot {
+	ViewPort vp;   ///< The viewport to draw.
+	uint progress; ///< Last reported percentage of drawn lines.
+};
+
 /**
  * generate a large piece of the world
- * @param userdata Viewport area to draw
+ * @param userdata The #LargeWorldScreenshot to draw
  * @param buf Videobuffer with same bitdepth as current blitter
  * @param y First line to render
  * @param pitch Pitch of the videobuffer
@@ -618,7 +624,8 @@ static void CurrentScreenCallback(void *userdata, void *buf, uint y, uint pitch,
  */
 static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, uint n)
 {
-	ViewPort *vp = (ViewPort *)userdata;
+	LargeWorldScreenshot *lws = (LargeWorldScreenshot *)userdata;
+	ViewPort *vp = &lws->vp;
 	DrawPixelInfo dpi, *old_dpi;
 	int wx, left;
 
@@ -643,7 +650,10 @@ static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, ui
 	dpi.left = 0;
 	dpi.top = y;
 
-	/* Render viewport in blocks of 1600 pixels width */
+	/* Render viewport in blocks of 1600 pixels width; the blocks
+	 * of a band are blitted in parallel when there are threads. */
+	ViewportStartDeferredDraw();
+
 	left = 0;
 	while (vp->width - left != 0) {
 		wx = min(vp->width - left, 1600);
@@ -657,11 +667,19 @@ static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, ui
 		);
 	}
 
+	ViewportFinishDeferredDraw(vp);
+
 	_cur_dpi = old_dpi;
 
 	/* Switch back to rendering to the screen */
 	_screen = old_screen;
 	_screen_disable_anim = old_disable_anim;
+
+	uint progress = (uint)((uint64)(y + n) * 100 / vp->height);
+	if (progress / 10 != lws->progress / 10) {
+		lws->progress = progress;
+		DEBUG(misc, 1, "Making screenshot %s: %u%% done", _screenshot_name, progress);
+	}
 }
 
 /**
@@ -760,11 +778,12 @@ void SetupScreenshotViewport(ScreenshotType t, ViewPort *vp)
  */
 static bool MakeLargeWorldScreenshot(ScreenshotType t)
 {
-	ViewPort vp;
-	SetupScreenshotViewport(t, &vp);
+	LargeWorldScreenshot lws;
+	SetupScreenshotViewport(t, &lws.vp);
+	lws.progress = 0;
 
 	const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
-	return sf->proc(MakeScreenshotName(SCREENSHOT_NAME, sf->extension), LargeWorldCallback, &vp, vp.width, vp.height,
+	return sf->proc(MakeScreenshotName(SCREENSHOT_NAME, sf->extension), LargeWorldCallback, &lws, lws.vp.width, lws.vp.height,
 			BlitterFactory::GetCurrentBlitter()->GetScreenDepth(), _cur_palette.palette);
 }
 
@@ -103,6 +103,8 @@ struct GUISettings {
 	bool   disable_unsuitable_building;      ///< disable infrastructure building when no suitable vehicles are available
 	byte   autosave;                         ///< how often should we do autosaves?
 	bool   threaded_saves;                   ///< should we do threaded saves?
+	uint8  viewport_threads;                 ///< number of extra threads drawing the viewports, 0 to draw them on the main thread only
+	uint8  genworld_threads;                 ///< number of threads generating the world, 0 for one per CPU core
 	bool   keep_all_autosave;                ///< name the autosave in a different way
 	bool   autosave_on_exit;                 ///< save an autosave when you quit the game, but do not ask "Do you really want to quit?"
 	uint8  date_format_in_default_names;     ///< should the default savegame/screenshot name use long dates (31th Dec 2008), short dates (31-12-2008) or ISO dates (2008-12-31)
@@ -156,6 +158,7 @@ struct GUISettings {
 	bool   scenario_developer;               ///< activate scenario developer: allow modifying NewGRFs in an existing game
 	uint8  settings_restriction_mode;        ///< selected restriction mode in adv. settings GUI. @see RestrictionMode
 	bool   newgrf_show_old_versions;         ///< whether to show old versions in the NewGRF list
+	bool   newgrf_draw_callback_cache;       ///< memoise the results of NewGRF callbacks while drawing (not during the game loop)
 	uint8  newgrf_default_palette;           ///< default palette to use for NewGRFs without action 14 palette information
 
 	/**
@@ -242,6 +245,8 @@ struct NetworkSettings {
 	uint16 server_port;                                   ///< port the server listens on
 	uint16 server_admin_port;                             ///< port the server listens on for the admin network
 	bool   server_admin_chat;                             ///< allow private chat for the server to be distributed to the admin network
+	bool   server_batch_frames;                           ///< send the commands, frame and sync-check of a frame in one packet to clients that support it
+	bool   server_compress_frames;                        ///< compress these packets for clients that support it
 	char   server_name[NETWORK_NAME_LENGTH];              ///< name of the server
 	char   server_password[NETWORK_PASSWORD_LENGTH];      ///< password for joining this server
 	char   rcon_password[NETWORK_PASSWORD_LENGTH];        ///< password for rconsole (server side)
@@ -458,6 +463,7 @@ struct VehicleSettings {
 	uint8  plane_speed;                      ///< divisor for speed of aircraft
 	uint8  freight_trains;                   ///< value to multiply the weight of cargo by
 	bool   dynamic_engines;                  ///< enable dynamic allocation of engine data
+	bool   newgrf_tick_callback_cache;       ///< memoise the results of the speed, capacity and 32 day callbacks of vehicles within a tick
 	bool   never_expire_vehicles;            ///< never expire vehicles
 	byte   extend_vehicle_life;              ///< extend vehicle life by this many years
 	byte   road_side;                        ///< the side of the road vehicles drive on
@@ -17,6 +17,10 @@
 #include "viewport_func.h"
 #include "train.h"
 #include "company_base.h"
+#include "benchmark.h"
+#include "core/sort_func.hpp"
+
+#include <map>
 
 #include "safeguards.h"
 
@@ -166,6 +170,19 @@ public:
 		return true;
 	}
 
+	/**
+	 * Reads an element without removing it from the set
+	 * @param i index of the element
+	 * @param tile pointer where tile is written to
+	 * @param dir pointer where dir is written to
+	 */
+	void Peek(uint i, TileIndex *tile, Tdir *dir) const
+	{
+		assert(i < this->n);
+		*tile = this->data[i].tile;
+		*dir = this->data[i].dir;
+	}
+
 	/**
 	 * Reads the last added element into the set
 	 * @param tile pointer where tile is written to
@@ -184,7 +201,6 @@ public:
 	}
 };
 
-static SmallSet<Trackdir, SIG_TBU_SIZE> _tbuset("_tbuset");         ///< set of signals that will be updated
 static SmallSet<DiagDirection, SIG_TBD_SIZE> _tbdset("_tbdset");    ///< set of open nodes in current signal block
 static SmallSet<DiagDirection, SIG_GLOB_SIZE> _globset("_globset"); ///< set of places to be updated in following runs
 
@@ -198,6 +214,148 @@ static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
 }
 
 
+/** Current signal block state flags */
+enum SigFlags {
+	SF_NONE   = 0,
+	SF_TRAIN  = 1 << 0, ///< train found in segment
+	SF_EXIT   = 1 << 1, ///< exitsignal found
+	SF_EXIT2  = 1 << 2, ///< two or more exits found
+	SF_GREEN  = 1 << 3, ///< green exitsignal found
+	SF_GREEN2 = 1 << 4, ///< two or more green exits found
+	SF_FULL   = 1 << 5, ///< some of buffers was full, do not continue
+	SF_PBS    = 1 << 6, ///< pbs signal found
+};
+
+DECLARE_ENUM_AS_BIT_SET(SigFlags)
+
+
+/** Place where a signal block has to be checked for trains */
+struct SignalBlockProbe {
+	TileIndex tile;   ///< tile to check
+	TrackBits tracks; ///< only trains on these tracks count, #TRACK_BIT_NONE for any train outside a depot
+};
+
+/** Signal (tile and trackdir) stored in a signal block */
+struct SignalBlockSignal {
+	TileIndex tile;     ///< tile of the signal
+	Trackdir trackdir;  ///< trackdir of the signal
+};
+
+/** Side of a tile stored in a signal block */
+struct SignalBlockSide {
+	TileIndex tile;     ///< tile
+	DiagDirection dir;  ///< side of the tile
+};
+
+/**
+ * Result of exploring a signal block from a given start. The outcome of
+ * the search only depends on the track layout of the tiles it visited, so
+ * the block is kept until one of those tiles is changed. Whether the block
+ * is occupied is derived from the number of trains on its tiles, which is
+ * kept up to date as trains move from tile to tile.
+ */
+struct SignalBlock {
+	uint64 key;                                ///< where the search started, see SignalBlockKey()
+	SigFlags flags;                            ///< flags that depend on the layout only: #SF_PBS and #SF_FULL
+	uint trains;                               ///< number of trains on the tiles of the block; not all of them have to occupy it
+	SmallVector<TileIndex, 16> tiles;          ///< tiles visited by the search, sorted once the search is done
+	SmallVector<SignalBlockProbe, 16> probes;  ///< places where trains occupy the block
+	SmallVector<SignalBlockSignal, 4> signals; ///< signals at the border of the block facing into it, in the order they were found
+	SmallVector<SignalBlockSignal, 4> exits;   ///< pre-signal exits facing out of the block
+	SmallVector<SignalBlockSide, 16> sides;    ///< sides that the search removed from #_globset, in that order
+
+	/**
+	 * Create an empty signal block.
+	 * @param key where the search starts
+	 */
+	SignalBlock(uint64 key) : key(key), flags(SF_NONE), trains(0) {}
+
+	/**
+	 * Add a place to check for trains.
+	 * @param tile tile to check
+	 * @param tracks tracks to check, #TRACK_BIT_NONE for all but depots
+	 */
+	inline void AddProbe(TileIndex tile, TrackBits tracks)
+	{
+		SignalBlockProbe *probe = this->probes.Append();
+		probe->tile = tile;
+		probe->tracks = tracks;
+	}
+
+	/**
+	 * Add a signal to update when the state of the block changes.
+	 * @param tile tile of the signal
+	 * @param trackdir trackdir of the signal
+	 * @return false iff there are too many signals to update
+	 */
+	bool AddSignal(TileIndex tile, Trackdir trackdir)
+	{
+		if (this->signals.Length() == SIG_TBU_SIZE) {
+			DEBUG(misc, 0, "SignalSegment too complex. Too many signals (maximum %d)", SIG_TBU_SIZE);
+			return false;
+		}
+
+		SignalBlockSignal *sig = this->signals.Append();
+		sig->tile = tile;
+		sig->trackdir = trackdir;
+		return true;
+	}
+
+	bool IsOccupied() const;
+	SigFlags GetFlags() const;
+};
+
+static std::map<uint64, SignalBlock *> _signal_blocks;                 ///< all known signal blocks, by where the search started
+static std::multimap<TileIndex, SignalBlock *> _signal_block_tiles;    ///< the signal blocks that visited a tile
+static std::map<TileIndex, uint> _signal_tile_trains;                  ///< number of trains per tile, only for tiles with trains
+
+/**
+ * Check whether a train occupies the signal block.
+ * @return true iff there is a train in the block
+ */
+bool SignalBlock::IsOccupied() const
+{
+	/* No train on any tile of the block; no need to look for them. */
+	if (this->trains == 0) return false;
+
+	for (const SignalBlockProbe *probe = this->probes.Begin(); probe != this->probes.End(); probe++) {
+		if (probe->tracks == TRACK_BIT_NONE) {
+			if (HasVehicleOnPos(probe->tile, NULL, &TrainOnTileEnum)) return true;
+		} else {
+			if (EnsureNoTrainOnTrackBits(probe->tile, probe->tracks).Failed()) return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Determine the current state of the signal block.
+ * @return SigFlags
+ */
+SigFlags SignalBlock::GetFlags() const
+{
+	SigFlags flags = this->flags;
+	if (flags & SF_FULL) return flags;
+
+	if (this->IsOccupied()) flags |= SF_TRAIN;
+
+	for (const SignalBlockSignal *exit = this->exits.Begin(); exit != this->exits.End(); exit++) {
+		if (flags & SF_EXIT) flags |= SF_EXIT2; // found two (or more) exits
+		flags |= SF_EXIT; // found at least one exit - allow for compiler optimizations
+		if (GetSignalStateByTrackdir(exit->tile, exit->trackdir) == SIGNAL_STATE_GREEN) { // found green presignal exit
+			if (flags & SF_GREEN) {
+				flags |= SF_GREEN2;
+				break;
+			}
+			flags |= SF_GREEN;
+		}
+	}
+
+	return flags;
+}
+
+
 /**
  * Perform some operations before adding data into Todo set
  * The new and reverse direction is removed from _globset, because we are sure
@@ -209,13 +367,21 @@ static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
  * @param d1 direction (tile side) we are entering
  * @param t2 tile we are leaving
  * @param d2 direction (tile side) we are leaving
+ * @param block signal block that is being explored
  * @return false iff reverse direction was in Todo set
  */
-static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
+static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2, SignalBlock *block)
 {
 	_globset.Remove(t1, d1); // it can be in Global but not in Todo
 	_globset.Remove(t2, d2); // remove in all cases
 
+	/* remember the removals, so they can be repeated when the block is used again */
+	SignalBlockSide *side = block->sides.Append(2);
+	side[0].tile = t1;
+	side[0].dir = d1;
+	side[1].tile = t2;
+	side[1].dir = d2;
+
 	assert(!_tbdset.IsIn(t1, d1)); // it really shouldn't be there already
 
 	if (_tbdset.Remove(t2, d2)) return false;
@@ -235,45 +401,34 @@ static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t
  * @param d1 direction (tile side) we are entering
  * @param t2 tile we are leaving
  * @param d2 direction (tile side) we are leaving
+ * @param block signal block that is being explored
  * @return false iff the Todo buffer would be overrun
  */
-static inline bool MaybeAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
+static inline bool MaybeAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2, SignalBlock *block)
 {
-	if (!CheckAddToTodoSet(t1, d1, t2, d2)) return true;
+	if (!CheckAddToTodoSet(t1, d1, t2, d2, block)) return true;
 
 	return _tbdset.Add(t1, d1);
 }
 
 
-/** Current signal block state flags */
-enum SigFlags {
-	SF_NONE   = 0,
-	SF_TRAIN  = 1 << 0, ///< train found in segment
-	SF_EXIT   = 1 << 1, ///< exitsignal found
-	SF_EXIT2  = 1 << 2, ///< two or more exits found
-	SF_GREEN  = 1 << 3, ///< green exitsignal found
-	SF_GREEN2 = 1 << 4, ///< two or more green exits found
-	SF_FULL   = 1 << 5, ///< some of buffers was full, do not continue
-	SF_PBS    = 1 << 6, ///< pbs signal found
-};
-
-DECLARE_ENUM_AS_BIT_SET(SigFlags)
-
-
 /**
- * Search signal block
+ * Search signal block, starting at the open nodes in _tbdset
+ *
+ * Instead of looking for trains and checking the state of exit signals,
+ * everything needed to do so is stored in the block.
  *
  * @param owner owner whose signals we are updating
- * @return SigFlags
+ * @param block signal block to fill
  */
-static SigFlags ExploreSegment(Owner owner)
+static void ExploreSegment(Owner owner, SignalBlock *block)
 {
-	SigFlags flags = SF_NONE;
-
 	TileIndex tile;
 	DiagDirection enterdir;
 
 	while (_tbdset.Get(&tile, &enterdir)) {
+		*block->tiles.Append() = tile;
+
 		TileIndex oldtile = tile; // tile we are leaving
 		DiagDirection exitdir = enterdir == INVALID_DIAGDIR ? INVALID_DIAGDIR : ReverseDiagDir(enterdir); // expected new exit direction (for straight line)
 
@@ -283,13 +438,13 @@ static SigFlags ExploreSegment(Owner owner)
 
 				if (IsRailDepot(tile)) {
 					if (enterdir == INVALID_DIAGDIR) { // from 'inside' - train just entered or left the depot
-						if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+						block->AddProbe(tile, TRACK_BIT_NONE);
 						exitdir = GetRailDepotDirection(tile);
 						tile += TileOffsByDiagDir(exitdir);
 						enterdir = ReverseDiagDir(exitdir);
 						break;
 					} else if (enterdir == GetRailDepotDirection(tile)) { // entered a depot
-						if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+						block->AddProbe(tile, TRACK_BIT_NONE);
 						continue;
 					} else {
 						continue;
@@ -302,11 +457,11 @@ static SigFlags ExploreSegment(Owner owner)
 
 				if (tracks == TRACK_BIT_HORZ || tracks == TRACK_BIT_VERT) { // there is exactly one incidating track, no need to check
 					tracks = tracks_masked;
-					/* If no train detected yet, and there is not no train -> there is a train -> set the flag */
-					if (!(flags & SF_TRAIN) && EnsureNoTrainOnTrackBits(tile, tracks).Failed()) flags |= SF_TRAIN;
+					/* only a train on this very track occupies the block */
+					block->AddProbe(tile, tracks);
 				} else {
 					if (tracks_masked == TRACK_BIT_NONE) continue; // no incidating track
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					block->AddProbe(tile, TRACK_BIT_NONE);
 				}
 
 				if (HasSignals(tile)) { // there is exactly one track - not zero, because there is exit from this tile
@@ -320,21 +475,19 @@ static SigFlags ExploreSegment(Owner owner)
 						 * (if it is a presignal EXIT and it changes, it will be added to 'to-be-done' set later) */
 						if (HasSignalOnTrackdir(tile, reversedir)) {
 							if (IsPbsSignal(sig)) {
-								flags |= SF_PBS;
-							} else if (!_tbuset.Add(tile, reversedir)) {
-								return flags | SF_FULL;
+								block->flags |= SF_PBS;
+							} else if (!block->AddSignal(tile, reversedir)) {
+								block->flags |= SF_FULL;
+								return;
 							}
 						}
-						if (HasSignalOnTrackdir(tile, trackdir) && !IsOnewaySignal(tile, track)) flags |= SF_PBS;
-
-						/* if it is a presignal EXIT in OUR direction and we haven't found 2 green exits yes, do special check */
-						if (!(flags & SF_GREEN2) && IsPresignalExit(tile, track) && HasSignalOnTrackdir(tile, trackdir)) { // found presignal exit
-							if (flags & SF_EXIT) flags |= SF_EXIT2; // found two (or more) exits
-							flags |= SF_EXIT; // found at least one exit - allow for compiler optimizations
-							if (GetSignalStateByTrackdir(tile, trackdir) == SIGNAL_STATE_GREEN) { // found green presignal exit
-								if (flags & SF_GREEN) flags |= SF_GREEN2;
-								flags |= SF_GREEN;
-							}
+						if (HasSignalOnTrackdir(tile, trackdir) && !IsOnewaySignal(tile, track)) block->flags |= SF_PBS;
+
+						/* if it is a presignal EXIT in OUR direction, its state is checked when the block is updated */
+						if (IsPresignalExit(tile, track) && HasSignalOnTrackdir(tile, trackdir)) { // found presignal exit
+							SignalBlockSignal *exit = block->exits.Append();
+							exit->tile = tile;
+							exit->trackdir = trackdir;
 						}
 
 						continue;
@@ -345,7 +498,10 @@ static SigFlags ExploreSegment(Owner owner)
 					if (dir != enterdir && (tracks & _enterdir_to_trackbits[dir])) { // any track incidating?
 						TileIndex newtile = tile + TileOffsByDiagDir(dir);  // new tile to check
 						DiagDirection newdir = ReverseDiagDir(dir); // direction we are entering from
-						if (!MaybeAddToTodoSet(newtile, newdir, tile, dir)) return flags | SF_FULL;
+						if (!MaybeAddToTodoSet(newtile, newdir, tile, dir, block)) {
+							block->flags |= SF_FULL;
+							return;
+						}
 					}
 				}
 
@@ -358,7 +514,7 @@ static SigFlags ExploreSegment(Owner owner)
 				if (DiagDirToAxis(enterdir) != GetRailStationAxis(tile)) continue; // different axis
 				if (IsStationTileBlocked(tile)) continue; // 'eye-candy' station tile
 
-				if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+				block->AddProbe(tile, TRACK_BIT_NONE);
 				tile += TileOffsByDiagDir(exitdir);
 				break;
 
@@ -367,7 +523,7 @@ static SigFlags ExploreSegment(Owner owner)
 				if (GetTileOwner(tile) != owner) continue;
 				if (DiagDirToAxis(enterdir) == GetCrossingRoadAxis(tile)) continue; // different axis
 
-				if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+				block->AddProbe(tile, TRACK_BIT_NONE);
 				tile += TileOffsByDiagDir(exitdir);
 				break;
 
@@ -377,13 +533,13 @@ static SigFlags ExploreSegment(Owner owner)
 				DiagDirection dir = GetTunnelBridgeDirection(tile);
 
 				if (enterdir == INVALID_DIAGDIR) { // incoming from the wormhole
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					block->AddProbe(tile, TRACK_BIT_NONE);
 					enterdir = dir;
 					exitdir = ReverseDiagDir(dir);
 					tile += TileOffsByDiagDir(exitdir); // just skip to next tile
 				} else { // NOT incoming from the wormhole!
 					if (ReverseDiagDir(enterdir) != dir) continue;
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					block->AddProbe(tile, TRACK_BIT_NONE);
 					tile = GetOtherTunnelBridgeEnd(tile); // just skip to exit tile
 					enterdir = INVALID_DIAGDIR;
 					exitdir = INVALID_DIAGDIR;
@@ -395,24 +551,141 @@ static SigFlags ExploreSegment(Owner owner)
 				continue; // continue the while() loop
 		}
 
-		if (!MaybeAddToTodoSet(tile, enterdir, oldtile, exitdir)) return flags | SF_FULL;
+		if (!MaybeAddToTodoSet(tile, enterdir, oldtile, exitdir, block)) {
+			block->flags |= SF_FULL;
+			return;
+		}
 	}
+}
 
-	return flags;
+
+/**
+ * Sort the tiles of a signal block by index.
+ * @param a the first tile
+ * @param b the second tile
+ * @return <0 when a < b, 0 when a == b and >0 when a > b
+ */
+static int CDECL TileIndexSorter(const TileIndex *a, const TileIndex *b)
+{
+	return (int)(*a > *b) - (int)(*a < *b);
 }
 
 
 /**
- * Update signals around segment in _tbuset
+ * Make a newly explored signal block known, so it gets used and invalidated.
+ * @param block the signal block
+ */
+static void RegisterSignalBlock(SignalBlock *block)
+{
+	/* Remove duplicate tiles, so trains on them are counted once. */
+	QSortT(block->tiles.Begin(), block->tiles.Length(), &TileIndexSorter);
+	uint n = 0;
+	for (uint i = 0; i < block->tiles.Length(); i++) {
+		if (n == 0 || block->tiles[n - 1] != block->tiles[i]) block->tiles[n++] = block->tiles[i];
+	}
+	block->tiles.Resize(n);
+
+	for (const TileIndex *tile = block->tiles.Begin(); tile != block->tiles.End(); tile++) {
+		_signal_block_tiles.insert(std::make_pair(*tile, block));
+
+		std::map<TileIndex, uint>::const_iterator it = _signal_tile_trains.find(*tile);
+		if (it != _signal_tile_trains.end()) block->trains += it->second;
+	}
+
+	_signal_blocks[block->key] = block;
+}
+
+
+/**
+ * Forget a signal block.
+ * @param block the signal block
+ */
+static void DeleteSignalBlock(SignalBlock *block)
+{
+	for (const TileIndex *tile = block->tiles.Begin(); tile != block->tiles.End(); tile++) {
+		std::pair<std::multimap<TileIndex, SignalBlock *>::iterator, std::multimap<TileIndex, SignalBlock *>::iterator> range = _signal_block_tiles.equal_range(*tile);
+		for (std::multimap<TileIndex, SignalBlock *>::iterator it = range.first; it != range.second; ++it) {
+			if (it->second != block) continue;
+			_signal_block_tiles.erase(it);
+			break;
+		}
+	}
+
+	_signal_blocks.erase(block->key);
+	delete block;
+}
+
+
+/**
+ * Determine the key of the signal block that starts at the open nodes in _tbdset.
+ * @param owner owner whose signals we are updating
+ * @return the key
+ */
+static uint64 SignalBlockKey(Owner owner)
+{
+	assert_compile(2 * MAX_MAP_SIZE_BITS + 3 <= 27);
+	assert(_tbdset.Items() <= 2);
+
+	uint64 key = owner;
+	for (uint i = 0; i < _tbdset.Items(); i++) {
+		TileIndex tile;
+		DiagDirection dir;
+		_tbdset.Peek(i, &tile, &dir);
+		key = key << 27 | (uint64)tile << 3 | dir;
+	}
+
+	return key << 1 | (_tbdset.Items() == 2 ? 1 : 0);
+}
+
+
+/**
+ * Get the signal block that starts at the open nodes in _tbdset,
+ * and explore it when it is not known yet. Either way _tbdset is
+ * emptied and the open blocks in _globset the search would find
+ * are removed.
+ * @param owner owner whose signals we are updating
+ * @return the signal block
+ */
+static const SignalBlock *GetSignalBlock(Owner owner)
+{
+	uint64 key = SignalBlockKey(owner);
+
+	std::map<uint64, SignalBlock *>::const_iterator it = _signal_blocks.find(key);
+	if (it != _signal_blocks.end()) {
+		const SignalBlock *block = it->second;
+		_tbdset.Reset();
+
+		/* A search would have removed these from the global set; for a full block all sets are reset anyway. */
+		if (!_globset.IsEmpty() && !(block->flags & SF_FULL)) {
+			for (const SignalBlockSide *side = block->sides.Begin(); side != block->sides.End(); side++) {
+				_globset.Remove(side->tile, side->dir);
+			}
+		}
+
+		return block;
+	}
+
+	SignalBlock *block = new SignalBlock(key);
+	ExploreSegment(owner, block);
+	_tbdset.Reset(); // only left filled when the block is full
+	RegisterSignalBlock(block);
+	return block;
+}
+
+
+/**
+ * Update signals around segment
  *
  * @param flags info about segment
+ * @param block the segment
  */
-static void UpdateSignalsAroundSegment(SigFlags flags)
+static void UpdateSignalsAroundSegment(SigFlags flags, const SignalBlock *block)
 {
-	TileIndex tile;
-	Trackdir trackdir;
-
-	while (_tbuset.Get(&tile, &trackdir)) {
+	/* Update in reverse order, the signals used to be kept in a LIFO set. */
+	for (const SignalBlockSignal *sig_item = block->signals.End(); sig_item != block->signals.Begin();) {
+		sig_item--;
+		TileIndex tile = sig_item->tile;
+		Trackdir trackdir = sig_item->trackdir;
 		assert(HasSignalOnTrackdir(tile, trackdir));
 
 		SignalType sig = GetSignalType(tile, TrackdirToTrack(trackdir));
@@ -456,7 +729,6 @@ static void UpdateSignalsAroundSegment(SigFlags flags)
 /** Reset all sets after one set overflowed */
 static inline void ResetSets()
 {
-	_tbuset.Reset();
 	_tbdset.Reset();
 	_globset.Reset();
 }
@@ -472,6 +744,7 @@ static inline void ResetSets()
 static SigSegState UpdateSignalsInBuffer(Owner owner)
 {
 	assert(Company::IsValidID(owner));
+	BenchmarkTimer timer(BE_SIGNALS);
 
 	bool first = true;  // first block?
 	SigSegState state = SIGSEG_FREE; // value to return
@@ -480,7 +753,6 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 	DiagDirection dir;
 
 	while (_globset.Get(&tile, &dir)) {
-		assert(_tbuset.IsEmpty());
 		assert(_tbdset.IsEmpty());
 
 		/* After updating signal, data stored are always MP_RAILWAY with signals.
@@ -529,7 +801,8 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 		assert(!_tbdset.Overflowed()); // it really shouldn't overflow by these one or two items
 		assert(!_tbdset.IsEmpty()); // it wouldn't hurt anyone, but shouldn't happen too
 
-		SigFlags flags = ExploreSegment(owner);
+		const SignalBlock *block = GetSignalBlock(owner);
+		SigFlags flags = block->GetFlags();
 
 		if (first) {
 			first = false;
@@ -547,7 +820,7 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 			break;
 		}
 
-		UpdateSignalsAroundSegment(flags);
+		UpdateSignalsAroundSegment(flags, block);
 	}
 
 	return state;
@@ -557,6 +830,81 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 static Owner _last_owner = INVALID_OWNER; ///< last owner whose track was put into _globset
 
 
+/**
+ * Forget all signal blocks that visited a tile.
+ * @param tile the tile
+ */
+static void DeleteSignalBlocksAt(TileIndex tile)
+{
+	for (;;) {
+		std::multimap<TileIndex, SignalBlock *>::iterator it = _signal_block_tiles.find(tile);
+		if (it == _signal_block_tiles.end()) break;
+		DeleteSignalBlock(it->second);
+	}
+}
+
+/**
+ * Forget the signal blocks that visited a tile, because its track layout,
+ * signals or owner changed. When the tile is one end of a tunnel or bridge,
+ * the other end is done too.
+ * @param tile the changed tile, or #INVALID_TILE to forget all signal blocks
+ */
+void InvalidateSignalBlocks(TileIndex tile)
+{
+	if (tile == INVALID_TILE) {
+		for (std::map<uint64, SignalBlock *>::iterator it = _signal_blocks.begin(); it != _signal_blocks.end(); ++it) {
+			delete it->second;
+		}
+		_signal_blocks.clear();
+		_signal_block_tiles.clear();
+		return;
+	}
+
+	DeleteSignalBlocksAt(tile);
+	if (IsTileType(tile, MP_TUNNELBRIDGE)) DeleteSignalBlocksAt(GetOtherTunnelBridgeEnd(tile));
+}
+
+/** Forget all signal blocks and the trains on the tiles. */
+void ResetSignalBlocks()
+{
+	InvalidateSignalBlocks(INVALID_TILE);
+	_signal_tile_trains.clear();
+}
+
+/**
+ * Count a train that entered a tile.
+ * @param tile the tile
+ * @note Trains are counted when the vehicle position hash is updated, so
+ *       signals may only be updated after that, like the train controller does.
+ */
+void AddTrainToSignalBlocks(TileIndex tile)
+{
+	_signal_tile_trains[tile]++;
+
+	std::pair<std::multimap<TileIndex, SignalBlock *>::iterator, std::multimap<TileIndex, SignalBlock *>::iterator> range = _signal_block_tiles.equal_range(tile);
+	for (std::multimap<TileIndex, SignalBlock *>::iterator it = range.first; it != range.second; ++it) {
+		it->second->trains++;
+	}
+}
+
+/**
+ * Stop counting a train that left a tile.
+ * @param tile the tile
+ */
+void RemoveTrainFromSignalBlocks(TileIndex tile)
+{
+	std::map<TileIndex, uint>::iterator trains = _signal_tile_trains.find(tile);
+	assert(trains != _signal_tile_trains.end() && trains->second > 0);
+	if (--trains->second == 0) _signal_tile_trains.erase(trains);
+
+	std::pair<std::multimap<TileIndex, SignalBlock *>::iterator, std::multimap<TileIndex, SignalBlock *>::iterator> range = _signal_block_tiles.equal_range(tile);
+	for (std::multimap<TileIndex, SignalBlock *>::iterator it = range.first; it != range.second; ++it) {
+		assert(it->second->trains > 0);
+		it->second->trains--;
+	}
+}
+
+
 /**
  * Update signals in buffer
  * Called from 'outside'
@@ -591,6 +939,9 @@ void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner)
 
 	_last_owner = owner;
 
+	/* the track at the tile changed, so the blocks there have to be explored again */
+	InvalidateSignalBlocks(tile);
+
 	_globset.Add(tile, _search_dir_1[track]);
 	_globset.Add(tile, _search_dir_2[track]);
 
@@ -616,6 +967,9 @@ void AddSideToSignalBuffer(TileIndex tile, DiagDirection side, Owner owner)
 
 	_last_owner = owner;
 
+	/* the track at the tile changed, so the blocks there have to be explored again */
+	InvalidateSignalBlocks(tile);
+
 	_globset.Add(tile, side);
 
 	if (_globset.Items() >= SIG_GLOB_UPDATE) {
@@ -60,4 +60,9 @@ void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner);
 void AddSideToSignalBuffer(TileIndex tile, DiagDirection side, Owner owner);
 void UpdateSignalsInBuffer();
 
+void InvalidateSignalBlocks(TileIndex tile);
+void ResetSignalBlocks();
+void AddTrainToSignalBlocks(TileIndex tile);
+void RemoveTrainFromSignalBlocks(TileIndex tile);
+
 #endif /* SIGNAL_FUNC_H */
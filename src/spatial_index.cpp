@@ -0,0 +1,201 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file spatial_index.cpp Implementation of the index to find towns, industries and stations by their location. */
+
+#include "stdafx.h"
+#include "spatial_index.h"
+#include "town.h"
+#include "industry.h"
+#include "station_base.h"
+
+#include "safeguards.h"
+
+SpatialIndex _town_spatial_index;     ///< Towns by their centre tile.
+SpatialIndex _industry_spatial_index; ///< Industries by the area they cover.
+SpatialIndex _station_spatial_index;  ///< Stations by the tile of their sign.
+
+/**
+ * Remove all items from the index and size it for the current map.
+ */
+void SpatialIndex::Reset()
+{
+	delete[] this->cells;
+	this->size_x = MapSizeX() >> CELL_BITS;
+	this->size_y = MapSizeY() >> CELL_BITS;
+	this->cells = new Cell[this->size_x * this->size_y];
+}
+
+/**
+ * Get the cells an area overlaps.
+ * @param area        The area, which may not be empty.
+ * @param[out] left   The westmost cell column.
+ * @param[out] top    The northmost cell row.
+ * @param[out] right  The eastmost cell column.
+ * @param[out] bottom The southmost cell row.
+ */
+void SpatialIndex::GetCells(const TileArea &area, uint *left, uint *top, uint *right, uint *bottom) const
+{
+	assert(area.w != 0 && area.h != 0);
+	assert(this->size_x == MapSizeX() >> CELL_BITS && this->size_y == MapSizeY() >> CELL_BITS);
+
+	*left   = TileX(area.tile) >> CELL_BITS;
+	*top    = TileY(area.tile) >> CELL_BITS;
+	*right  = min<uint>(TileX(area.tile) + area.w - 1, MapMaxX()) >> CELL_BITS;
+	*bottom = min<uint>(TileY(area.tile) + area.h - 1, MapMaxY()) >> CELL_BITS;
+}
+
+/**
+ * Add an item to the index.
+ * @param id   Pool index of the item.
+ * @param area Area covered by the item.
+ */
+void SpatialIndex::Add(uint16 id, const TileArea &area)
+{
+	uint left, top, right, bottom;
+	this->GetCells(area, &left, &top, &right, &bottom);
+
+	for (uint y = top; y <= bottom; y++) {
+		for (uint x = left; x <= right; x++) {
+			Entry *entry = this->cells[y * this->size_x + x].Append();
+			entry->area = area;
+			entry->id = id;
+		}
+	}
+}
+
+/**
+ * Remove an item from the index.
+ * @param id   Pool index of the item.
+ * @param area Area covered by the item, as it was added.
+ */
+void SpatialIndex::Remove(uint16 id, const TileArea &area)
+{
+	uint left, top, right, bottom;
+	this->GetCells(area, &left, &top, &right, &bottom);
+
+	for (uint y = top; y <= bottom; y++) {
+		for (uint x = left; x <= right; x++) {
+			Cell &cell = this->cells[y * this->size_x + x];
+			Entry *entry = cell.Begin();
+			while (entry != cell.End() && entry->id != id) entry++;
+
+			/* The item must have been added with this very area, otherwise
+			 * it would stay behind in a cell after its pool slot is freed. */
+			assert(entry != cell.End());
+			cell.Erase(entry);
+		}
+	}
+}
+
+/**
+ * Find all items whose area intersects the given area.
+ * @param area       The area to search in.
+ * @param[out] items The list to append the pool indices of the items to, each once and in no particular order.
+ */
+void SpatialIndex::FindInArea(const TileArea &area, SpatialIndexItemList *items) const
+{
+	uint left, top, right, bottom;
+	this->GetCells(area, &left, &top, &right, &bottom);
+
+	for (uint y = top; y <= bottom; y++) {
+		for (uint x = left; x <= right; x++) {
+			const Cell &cell = this->cells[y * this->size_x + x];
+			for (const Entry *entry = cell.Begin(); entry != cell.End(); entry++) {
+				if (!entry->area.Intersects(area)) continue;
+
+				/* Items covering several cells are only reported by the cell
+				 * holding the northern corner of their overlap with the area. */
+				uint overlap_x = max(TileX(entry->area.tile), TileX(area.tile));
+				uint overlap_y = max(TileY(entry->area.tile), TileY(area.tile));
+				if (overlap_x >> CELL_BITS != x || overlap_y >> CELL_BITS != y) continue;
+
+				*items->Append() = entry->id;
+			}
+		}
+	}
+}
+
+/**
+ * Find the item closest to a tile, measured as the manhattan distance to the
+ * northern tile of the area of the item. When several items are at the same
+ * distance, the one with the lowest pool index is returned, just like a loop
+ * over the pool would do.
+ * @param tile      The tile to search from.
+ * @param threshold The distance of the item has to be smaller than this.
+ * @param filter    Optional filter for the items to consider.
+ * @param user_data Data passed to \a filter.
+ * @return Pool index of the closest item, or #INVALID_ITEM if there is none within \a threshold.
+ */
+uint16 SpatialIndex::FindNearest(TileIndex tile, uint threshold, SpatialIndexFilterProc *filter, void *user_data) const
+{
+	assert(this->size_x == MapSizeX() >> CELL_BITS && this->size_y == MapSizeY() >> CELL_BITS);
+
+	int cx = TileX(tile) >> CELL_BITS;
+	int cy = TileY(tile) >> CELL_BITS;
+	int max_r = max(max(cx, (int)this->size_x - 1 - cx), max(cy, (int)this->size_y - 1 - cy));
+
+	uint16 best = INVALID_ITEM;
+	uint best_dist = threshold;
+
+	/* Search the squares of cells around the cell of the tile, growing outwards. */
+	for (int r = 0; r <= max_r; r++) {
+		/* Tiles in the cells of this square are at least this far away. */
+		uint min_dist = (r == 0) ? 0 : (r - 1) * (1 << CELL_BITS) + 1;
+		if (best == INVALID_ITEM ? min_dist >= threshold : min_dist > best_dist) break;
+
+		for (int y = max(cy - r, 0); y <= min(cy + r, (int)this->size_y - 1); y++) {
+			/* Only the edge of the square has not been searched yet. */
+			int step = (y == cy - r || y == cy + r) ? 1 : 2 * r;
+
+			for (int x = cx - r; x <= cx + r; x += step) {
+				if (x < 0 || x >= (int)this->size_x) continue;
+
+				const Cell &cell = this->cells[y * this->size_x + x];
+				for (const Entry *entry = cell.Begin(); entry != cell.End(); entry++) {
+					uint dist = DistanceManhattan(tile, entry->area.tile);
+					if (best == INVALID_ITEM ? dist >= threshold : (dist > best_dist || (dist == best_dist && entry->id >= best))) continue;
+					if (filter != NULL && !filter(entry->id, user_data)) continue;
+
+					best = entry->id;
+					best_dist = dist;
+				}
+			}
+		}
+	}
+
+	return best;
+}
+
+/**
+ * Empty the indices, e.g. when a new game is started.
+ */
+void InitializeSpatialIndices()
+{
+	_town_spatial_index.Reset();
+	_industry_spatial_index.Reset();
+	_station_spatial_index.Reset();
+}
+
+/**
+ * Fill the indices with all towns, industries and stations, e.g. after loading a game.
+ */
+void RebuildSpatialIndices()
+{
+	InitializeSpatialIndices();
+
+	const Town *t;
+	FOR_ALL_TOWNS(t) _town_spatial_index.Add(t->index, TileArea(t->xy, 1, 1));
+
+	const Industry *i;
+	FOR_ALL_INDUSTRIES(i) _industry_spatial_index.Add(i->index, i->location);
+
+	const Station *st;
+	FOR_ALL_STATIONS(st) _station_spatial_index.Add(st->index, TileArea(st->xy, 1, 1));
+}
@@ -0,0 +1,70 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file spatial_index.h Index to find towns, industries and stations by their location. */
+
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include "tilearea_type.h"
+#include "core/smallvec_type.hpp"
+
+/**
+ * Filter for the items considered by SpatialIndex::FindNearest.
+ * @param id        Pool index of the item.
+ * @param user_data Additional data passed to SpatialIndex::FindNearest.
+ * @return Whether the item may be returned.
+ */
+typedef bool SpatialIndexFilterProc(uint16 id, void *user_data);
+
+/** List of pool indices found by a SpatialIndex. */
+typedef SmallVector<uint16, 16> SpatialIndexItemList;
+
+/**
+ * Index of the items of a pool, e.g. the towns, by the area they cover on the map.
+ * The map is divided in square cells, and each item is listed in every cell its area overlaps.
+ * The index has to be told about every item that is created, removed or moved.
+ */
+class SpatialIndex {
+	/** An item listed in a cell. */
+	struct Entry {
+		TileArea area; ///< The area covered by the item.
+		uint16 id;     ///< The pool index of the item.
+	};
+
+	typedef SmallVector<Entry, 4> Cell; ///< The items of a single cell.
+
+	Cell *cells; ///< All cells, row by row.
+	uint size_x; ///< Number of cells along the X axis.
+	uint size_y; ///< Number of cells along the Y axis.
+
+	void GetCells(const TileArea &area, uint *left, uint *top, uint *right, uint *bottom) const;
+
+public:
+	static const uint CELL_BITS = 5;           ///< Log2 of the size of a cell in tiles.
+	static const uint16 INVALID_ITEM = 0xFFFF; ///< Returned when no item was found.
+
+	SpatialIndex() : cells(NULL), size_x(0), size_y(0) {}
+	~SpatialIndex() { delete[] this->cells; }
+
+	void Reset();
+	void Add(uint16 id, const TileArea &area);
+	void Remove(uint16 id, const TileArea &area);
+
+	void FindInArea(const TileArea &area, SpatialIndexItemList *items) const;
+	uint16 FindNearest(TileIndex tile, uint threshold, SpatialIndexFilterProc *filter = NULL, void *user_data = NULL) const;
+};
+
+extern SpatialIndex _town_spatial_index;
+extern SpatialIndex _industry_spatial_index;
+extern SpatialIndex _station_spatial_index;
+
+void RebuildSpatialIndices();
+
+#endif /* SPATIAL_INDEX_H */
@@ -19,6 +19,7 @@
 #include "blitter/factory.hpp"
 #include "core/math_func.hpp"
 #include "core/mem_func.hpp"
+#include "thread/worker_pool.h"
 
 #include "table/sprites.h"
 #include "table/strings.h"
@@ -36,7 +37,8 @@ struct SpriteCache {
 	size_t file_pos;
 	uint32 id;
 	uint16 file_slot;
-	int16 lru;
+	SpriteID lru_prev;   ///< The cached sprite used just after this one, or #SPRITE_LRU_END.
+	SpriteID lru_next;   ///< The cached sprite used just before this one, or #SPRITE_LRU_END.
 	SpriteTypeByte type; ///< In some cases a single sprite is misused by two NewGRFs. Once as real sprite and once as recolour sprite. If the recolour sprite gets into the cache it might be drawn as real sprite which causes enormous trouble.
 	bool warned;         ///< True iff the user has been warned about incorrect use of this sprite
 	byte container_ver;  ///< Container version of the GRF the sprite is from.
@@ -78,16 +80,25 @@ static SpriteCache *AllocateSpriteCache(uint index)
 
 struct MemBlock {
 	size_t size;
+	size_t owner; ///< Index of the sprite the data of a used block belongs to.
 	byte data[];
 };
 
-static uint _sprite_lru_counter;
+/** End of the list of cached sprites ordered by their last use. */
+static const SpriteID SPRITE_LRU_END = UINT32_MAX;
+/** Owner of a block that is not (yet) the data of a cached sprite. */
+static const size_t MEMBLOCK_NO_OWNER = SIZE_MAX;
+
+static SpriteID _sprite_lru_first = SPRITE_LRU_END; ///< The cached sprite that was used most recently.
+static SpriteID _sprite_lru_last = SPRITE_LRU_END;  ///< The cached sprite that was used least recently, i.e. the first to be removed.
 static MemBlock *_spritecache_ptr;
 static uint _allocated_sprite_cache_size = 0;
 static int _compact_cache_counter;
+static uint _spritecache_generation; ///< Changed whenever cached sprites are moved or removed.
 
 static void CompactSpriteCache();
 static void *AllocSprite(size_t mem_req);
+static void DeleteEntryFromSpriteCache(uint item);
 
 /**
  * Skip the given amount of sprite graphics data.
@@ -372,6 +383,30 @@ static void *ReadRecolourSprite(uint16 file_slot, uint num)
 	return dest;
 }
 
+/**
+ * Load the zoom levels of a sprite that are in its GRF.
+ * @param sprite      The sprite to load into, one entry per zoom level.
+ * @param sc          Location of sprite.
+ * @param sprite_type Type of sprite.
+ * @return Bit mask of the loaded zoom levels; 0 if the sprite could not be loaded.
+ */
+static uint8 LoadGrfSprite(SpriteLoader::Sprite *sprite, const SpriteCache *sc, SpriteType sprite_type)
+{
+	uint8 sprite_avail = 0;
+	sprite[ZOOM_LVL_NORMAL].type = sprite_type;
+
+	SpriteLoaderGrf sprite_loader(sc->container_ver);
+	if (sprite_type != ST_MAPGEN && BlitterFactory::GetCurrentBlitter()->GetScreenDepth() == 32) {
+		/* Try for 32bpp sprites first. */
+		sprite_avail = sprite_loader.LoadSprite(sprite, sc->file_slot, sc->file_pos, sprite_type, true);
+	}
+	if (sprite_avail == 0) {
+		sprite_avail = sprite_loader.LoadSprite(sprite, sc->file_slot, sc->file_pos, sprite_type, false);
+	}
+
+	return sprite_avail;
+}
+
 /**
  * Read a sprite from disk.
  * @param sc          Location of sprite.
@@ -383,7 +418,6 @@ static void *ReadRecolourSprite(uint16 file_slot, uint num)
 static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_type, AllocatorProc *allocator)
 {
 	uint8 file_slot = sc->file_slot;
-	size_t file_pos = sc->file_pos;
 
 	assert(sprite_type != ST_RECOLOUR);
 	assert(IsMapgenSpriteID(id) == (sprite_type == ST_MAPGEN));
@@ -392,17 +426,7 @@ static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_ty
 	DEBUG(sprite, 9, "Load sprite %d", id);
 
 	SpriteLoader::Sprite sprite[ZOOM_LVL_COUNT];
-	uint8 sprite_avail = 0;
-	sprite[ZOOM_LVL_NORMAL].type = sprite_type;
-
-	SpriteLoaderGrf sprite_loader(sc->container_ver);
-	if (sprite_type != ST_MAPGEN && BlitterFactory::GetCurrentBlitter()->GetScreenDepth() == 32) {
-		/* Try for 32bpp sprites first. */
-		sprite_avail = sprite_loader.LoadSprite(sprite, file_slot, file_pos, sprite_type, true);
-	}
-	if (sprite_avail == 0) {
-		sprite_avail = sprite_loader.LoadSprite(sprite, file_slot, file_pos, sprite_type, false);
-	}
+	uint8 sprite_avail = LoadGrfSprite(sprite, sc, sprite_type);
 
 	if (sprite_avail == 0) {
 		if (sprite_type == ST_MAPGEN) return NULL;
@@ -556,10 +580,11 @@ bool LoadNextSprite(int load_index, byte file_slot, uint file_sprite_id, byte co
 	}
 
 	SpriteCache *sc = AllocateSpriteCache(load_index);
+	if (sc->ptr != NULL) DeleteEntryFromSpriteCache(load_index);
 	sc->file_slot = file_slot;
 	sc->file_pos = file_pos;
 	sc->ptr = data;
-	sc->lru = 0;
+	if (data != NULL) ((MemBlock *)data - 1)->owner = load_index;
 	sc->id = file_sprite_id;
 	sc->type = type;
 	sc->warned = false;
@@ -573,6 +598,7 @@ void DupSprite(SpriteID old_spr, SpriteID new_spr)
 {
 	SpriteCache *scnew = AllocateSpriteCache(new_spr); // may reallocate: so put it first
 	SpriteCache *scold = GetSpriteCache(old_spr);
+	if (scnew->ptr != NULL) DeleteEntryFromSpriteCache(new_spr);
 
 	scnew->file_slot = scold->file_slot;
 	scnew->file_pos = scold->file_pos;
@@ -592,7 +618,7 @@ void DupSprite(SpriteID old_spr, SpriteID new_spr)
 static const size_t S_FREE_MASK = sizeof(size_t) - 1;
 
 /* to make sure nobody adds things to MemBlock without checking S_FREE_MASK first */
-assert_compile(sizeof(MemBlock) == sizeof(size_t));
+assert_compile(sizeof(MemBlock) == 2 * sizeof(size_t));
 /* make sure it's a power of two */
 assert_compile((sizeof(size_t) & (sizeof(size_t) - 1)) == 0);
 
@@ -614,34 +640,81 @@ static size_t GetSpriteCacheUsage()
 }
 
 
-void IncreaseSpriteLRU()
+/**
+ * Remove a cached sprite from the list of sprites ordered by their last use.
+ * @param sprite The sprite.
+ * @param sc     Its entry in the sprite cache.
+ */
+static void UnlinkSpriteLRU(SpriteID sprite, SpriteCache *sc)
 {
-	/* Increase all LRU values */
-	if (_sprite_lru_counter > 16384) {
-		SpriteID i;
+	if (sc->lru_prev != SPRITE_LRU_END) {
+		GetSpriteCache(sc->lru_prev)->lru_next = sc->lru_next;
+	} else {
+		_sprite_lru_first = sc->lru_next;
+	}
+	if (sc->lru_next != SPRITE_LRU_END) {
+		GetSpriteCache(sc->lru_next)->lru_prev = sc->lru_prev;
+	} else {
+		_sprite_lru_last = sc->lru_prev;
+	}
+}
 
-		DEBUG(sprite, 3, "Fixing lru %u, inuse=" PRINTF_SIZE, _sprite_lru_counter, GetSpriteCacheUsage());
+/**
+ * Add a cached sprite as most recently used sprite to the list of sprites ordered by their last use.
+ * @param sprite The sprite.
+ * @param sc     Its entry in the sprite cache.
+ */
+static void LinkSpriteLRU(SpriteID sprite, SpriteCache *sc)
+{
+	sc->lru_prev = SPRITE_LRU_END;
+	sc->lru_next = _sprite_lru_first;
+	if (_sprite_lru_first != SPRITE_LRU_END) {
+		GetSpriteCache(_sprite_lru_first)->lru_prev = sprite;
+	} else {
+		_sprite_lru_last = sprite;
+	}
+	_sprite_lru_first = sprite;
+}
 
-		for (i = 0; i != _spritecache_items; i++) {
-			SpriteCache *sc = GetSpriteCache(i);
-			if (sc->ptr != NULL) {
-				if (sc->lru >= 0) {
-					sc->lru = -1;
-				} else if (sc->lru != -32768) {
-					sc->lru--;
-				}
-			}
-		}
-		_sprite_lru_counter = 0;
+/**
+ * Add a cached sprite as least recently used sprite to the list of sprites ordered by their last use.
+ * @param sprite The sprite.
+ * @param sc     Its entry in the sprite cache.
+ */
+static void AppendSpriteLRU(SpriteID sprite, SpriteCache *sc)
+{
+	sc->lru_prev = _sprite_lru_last;
+	sc->lru_next = SPRITE_LRU_END;
+	if (_sprite_lru_last != SPRITE_LRU_END) {
+		GetSpriteCache(_sprite_lru_last)->lru_next = sprite;
+	} else {
+		_sprite_lru_first = sprite;
 	}
+	_sprite_lru_last = sprite;
+}
 
-	/* Compact sprite cache every now and then. */
+/** Called every tick to compact the sprite cache every now and then. */
+void IncreaseSpriteLRU()
+{
 	if (++_compact_cache_counter >= 740) {
 		CompactSpriteCache();
 		_compact_cache_counter = 0;
 	}
 }
 
+/**
+ * Merge the free blocks directly after a free block into it. Freed blocks
+ * are only merged with the blocks after them, so a free block may still
+ * be followed by other free blocks until it is looked at again.
+ * @param s The free block.
+ */
+static inline void CoalesceFreeBlocks(MemBlock *s)
+{
+	while (NextBlock(s)->size & S_FREE_MASK) {
+		s->size += NextBlock(s)->size & ~S_FREE_MASK;
+	}
+}
+
 /**
  * Called when holes in the sprite cache should be removed.
  * That is accomplished by moving the cached data.
@@ -654,32 +727,26 @@ static void CompactSpriteCache()
 
 	for (s = _spritecache_ptr; s->size != 0;) {
 		if (s->size & S_FREE_MASK) {
+			CoalesceFreeBlocks(s);
+
 			MemBlock *next = NextBlock(s);
 			MemBlock temp;
-			SpriteID i;
-
-			/* Since free blocks are automatically coalesced, this should hold true. */
-			assert(!(next->size & S_FREE_MASK));
 
 			/* If the next block is the sentinel block, we can safely return */
 			if (next->size == 0) break;
 
-			/* Locate the sprite belonging to the next pointer. */
-			for (i = 0; GetSpriteCache(i)->ptr != next->data; i++) {
-				assert(i != _spritecache_items);
-			}
-
-			GetSpriteCache(i)->ptr = s->data; // Adjust sprite array entry
+			/* Adjust the entry of the sprite belonging to the next block. */
+			SpriteCache *sc = GetSpriteCache(next->owner);
+			assert(sc->ptr == next->data);
+			sc->ptr = s->data;
+			_spritecache_generation++;
 			/* Swap this and the next block */
 			temp = *s;
 			memmove(s, next, next->size);
 			s = NextBlock(s);
 			*s = temp;
 
-			/* Coalesce free blocks */
-			while (NextBlock(s)->size & S_FREE_MASK) {
-				s->size += NextBlock(s)->size & ~S_FREE_MASK;
-			}
+			CoalesceFreeBlocks(s);
 		} else {
 			s = NextBlock(s);
 		}
@@ -692,43 +759,30 @@ static void CompactSpriteCache()
  */
 static void DeleteEntryFromSpriteCache(uint item)
 {
+	SpriteCache *sc = GetSpriteCache(item);
+
 	/* Mark the block as free (the block must be in use) */
-	MemBlock *s = (MemBlock*)GetSpriteCache(item)->ptr - 1;
+	MemBlock *s = (MemBlock*)sc->ptr - 1;
 	assert(!(s->size & S_FREE_MASK));
+	assert(s->owner == item);
 	s->size |= S_FREE_MASK;
-	GetSpriteCache(item)->ptr = NULL;
+	sc->ptr = NULL;
+	if (sc->type != ST_RECOLOUR) UnlinkSpriteLRU(item, sc);
+	_spritecache_generation++;
 
-	/* And coalesce adjacent free blocks */
-	for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-		if (s->size & S_FREE_MASK) {
-			while (NextBlock(s)->size & S_FREE_MASK) {
-				s->size += NextBlock(s)->size & ~S_FREE_MASK;
-			}
-		}
-	}
+	CoalesceFreeBlocks(s);
 }
 
+/** Delete the least recently used sprite from the sprite cache; recolour sprites are never deleted. */
 static void DeleteEntryFromSpriteCache()
 {
-	uint best = UINT_MAX;
-	int cur_lru;
-
 	DEBUG(sprite, 3, "DeleteEntryFromSpriteCache, inuse=" PRINTF_SIZE, GetSpriteCacheUsage());
 
-	cur_lru = 0xffff;
-	for (SpriteID i = 0; i != _spritecache_items; i++) {
-		SpriteCache *sc = GetSpriteCache(i);
-		if (sc->type != ST_RECOLOUR && sc->ptr != NULL && sc->lru < cur_lru) {
-			cur_lru = sc->lru;
-			best = i;
-		}
-	}
-
 	/* Display an error message and die, in case we found no sprite at all.
 	 * This shouldn't really happen, unless all sprites are locked. */
-	if (best == UINT_MAX) error("Out of sprite memory");
+	if (_sprite_lru_last == SPRITE_LRU_END) error("Out of sprite memory");
 
-	DeleteEntryFromSpriteCache(best);
+	DeleteEntryFromSpriteCache(_sprite_lru_last);
 }
 
 static void *AllocSprite(size_t mem_req)
@@ -744,6 +798,7 @@ static void *AllocSprite(size_t mem_req)
 
 		for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
 			if (s->size & S_FREE_MASK) {
+				CoalesceFreeBlocks(s);
 				size_t cur_size = s->size & ~S_FREE_MASK;
 
 				/* Is the block exactly the size we need or
@@ -752,6 +807,7 @@ static void *AllocSprite(size_t mem_req)
 						cur_size >= mem_req + sizeof(MemBlock)) {
 					/* Set size and in use */
 					s->size = mem_req;
+					s->owner = MEMBLOCK_NO_OWNER;
 
 					/* Do we need to inject a free block too? */
 					if (cur_size != mem_req) {
@@ -768,6 +824,120 @@ static void *AllocSprite(size_t mem_req)
 	}
 }
 
+/**
+ * Get a number that changes whenever sprites in the cache are moved or
+ * removed. As long as it stays the same, pointers to cached sprites that
+ * were obtained before remain valid.
+ * @return The current generation of the sprite cache.
+ */
+uint GetSpriteCacheGeneration()
+{
+	return _spritecache_generation;
+}
+
+/** Most sprites that are loaded by a single call to #PrefetchSprites. */
+static const uint MAX_PREFETCH_BATCH = 32;
+
+/** A sprite that is loaded before it is drawn; see #PrefetchSprites. */
+struct PrefetchedSprite {
+	SpriteID id;                                 ///< The sprite.
+	SpriteLoader::Sprite sprite[ZOOM_LVL_COUNT]; ///< The loaded zoom levels, with data of their own instead of the buffers of the sprite loader.
+	Sprite *encoded;                             ///< The sprite encoded by the blitter, allocated by #AllocPrefetchedSprite.
+};
+
+static WorkerPool _sprite_workers("ottd:sprite"); ///< Threads encoding prefetched sprites.
+
+/**
+ * Allocate memory for a sprite encoded by a worker thread. Only the main
+ * thread may change the sprite cache, so the sprite is copied into the
+ * cache afterwards; the header of the block keeps the size for that.
+ * @param mem_req Size of the encoded sprite.
+ * @return The memory for the encoded sprite.
+ */
+static void *AllocPrefetchedSprite(size_t mem_req)
+{
+	MemBlock *s = (MemBlock *)MallocT<byte>(sizeof(MemBlock) + mem_req);
+	s->size = mem_req;
+	s->owner = MEMBLOCK_NO_OWNER;
+	return s->data;
+}
+
+/**
+ * Encode a single prefetched sprite for the current blitter.
+ * @param param The array of prefetched sprites.
+ * @param job   The index of the sprite in the array.
+ */
+static void EncodePrefetchedSpriteJob(void *param, uint job)
+{
+	PrefetchedSprite *ps = (PrefetchedSprite *)param + job;
+	ps->encoded = BlitterFactory::GetCurrentBlitter()->Encode(ps->sprite, AllocPrefetchedSprite);
+}
+
+/**
+ * Load sprites into the sprite cache before they are drawn, so the first
+ * drawing of them does not have to wait for them. The files can only be
+ * read by a single thread, so the sprites are loaded on the calling thread,
+ * but they are encoded for the blitter by multiple threads at once.
+ * Prefetched sprites are the first to be removed from the cache again and
+ * prefetching gives up as soon as it had to remove any sprite, so sprites
+ * that are on the screen are not replaced by sprites that might be.
+ * @param sprites The sprites that are likely to be drawn soon. Sprites that are cached already are skipped.
+ * @param count   The number of sprites.
+ * @param threads The number of threads to encode with, besides the calling thread.
+ * @return The number of handled sprites; when less than \a count, the others should be passed again later.
+ */
+uint PrefetchSprites(const SpriteID *sprites, uint count, uint threads)
+{
+	PrefetchedSprite batch[MAX_PREFETCH_BATCH];
+	uint loaded = 0;
+	uint handled = 0;
+
+	for (; handled < count && loaded < MAX_PREFETCH_BATCH; handled++) {
+		SpriteID id = sprites[handled];
+		if (!SpriteExists(id)) continue;
+
+		const SpriteCache *sc = GetSpriteCache(id);
+		if (sc->ptr != NULL || sc->type != ST_NORMAL) continue;
+
+		/* Sprites that fail to load are left to GetRawSprite, which replaces them. */
+		PrefetchedSprite *ps = &batch[loaded];
+		uint8 sprite_avail = LoadGrfSprite(ps->sprite, sc, ST_NORMAL);
+		if (sprite_avail == 0 || !ResizeSprites(ps->sprite, sprite_avail, sc->file_slot, sc->id)) continue;
+
+		DEBUG(sprite, 9, "Prefetch sprite %d", id);
+
+		for (ZoomLevel zoom = ZOOM_LVL_BEGIN; zoom != ZOOM_LVL_END; zoom++) {
+			uint size = ps->sprite[zoom].width * ps->sprite[zoom].height;
+			SpriteLoader::CommonPixel *data = MallocT<SpriteLoader::CommonPixel>(size);
+			MemCpyT(data, ps->sprite[zoom].data, size);
+			ps->sprite[zoom].data = data;
+		}
+		ps->id = id;
+		loaded++;
+	}
+
+	_sprite_workers.SetThreads(threads);
+	_sprite_workers.Run(&EncodePrefetchedSpriteJob, batch, loaded);
+
+	uint generation = _spritecache_generation;
+	for (PrefetchedSprite *ps = batch; ps != batch + loaded; ps++) {
+		for (ZoomLevel zoom = ZOOM_LVL_BEGIN; zoom != ZOOM_LVL_END; zoom++) free(ps->sprite[zoom].data);
+
+		MemBlock *encoded = (MemBlock *)ps->encoded - 1;
+		SpriteCache *sc = GetSpriteCache(ps->id);
+		if (sc->ptr == NULL) {
+			void *ptr = AllocSprite(encoded->size);
+			memcpy(ptr, encoded->data, encoded->size);
+			((MemBlock *)ptr - 1)->owner = ps->id;
+			sc->ptr = ptr;
+			AppendSpriteLRU(ps->id, sc);
+		}
+		free(encoded);
+	}
+
+	return generation == _spritecache_generation ? handled : count;
+}
+
 /**
  * Handles the case when a sprite of different type is requested than is present in the SpriteCache.
  * For ST_FONT sprites, it is normal. In other cases, default sprite is loaded instead.
@@ -840,11 +1010,23 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator)
 	if (allocator == NULL) {
 		/* Load sprite into/from spritecache */
 
-		/* Update LRU */
-		sc->lru = ++_sprite_lru_counter;
-
-		/* Load the sprite, if it is not loaded, yet */
-		if (sc->ptr == NULL) sc->ptr = ReadSprite(sc, sprite, type, AllocSprite);
+		if (sc->ptr == NULL) {
+			/* Load the sprite, if it is not loaded, yet. A sprite that fails to
+			 * load gets a copy of the fallback sprite in a block of its own, which
+			 * is cached for it like any other sprite, so it is not read again. */
+			void *ptr = ReadSprite(sc, sprite, type, AllocSprite);
+			if (ptr == NULL) return NULL;
+
+			MemBlock *s = (MemBlock *)ptr - 1;
+			assert(s->owner == MEMBLOCK_NO_OWNER);
+			s->owner = sprite;
+			sc->ptr = ptr;
+			LinkSpriteLRU(sprite, sc);
+		} else if (_sprite_lru_first != sprite && type != ST_RECOLOUR) {
+			/* Update LRU; recolour sprites are never removed, so they are not in it */
+			UnlinkSpriteLRU(sprite, sc);
+			LinkSpriteLRU(sprite, sc);
+		}
 
 		return sc->ptr;
 	} else {
@@ -856,6 +1038,8 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator)
 
 static void GfxInitSpriteCache()
 {
+	_spritecache_generation++;
+
 	/* initialize sprite cache heap */
 	int bpp = BlitterFactory::GetCurrentBlitter()->GetScreenDepth();
 	uint target_size = (bpp > 0 ? _sprite_cache_size * bpp / 8 : 1) * 1024 * 1024;
@@ -913,6 +1097,8 @@ void GfxInitSpriteMem()
 	free(_spritecache);
 	_spritecache_items = 0;
 	_spritecache = NULL;
+	_sprite_lru_first = SPRITE_LRU_END;
+	_sprite_lru_last = SPRITE_LRU_END;
 
 	_compact_cache_counter = 0;
 }
@@ -923,11 +1109,8 @@ void GfxInitSpriteMem()
  */
 void GfxClearSpriteCache()
 {
-	/* Clear sprite ptr for all cached items */
-	for (uint i = 0; i != _spritecache_items; i++) {
-		SpriteCache *sc = GetSpriteCache(i);
-		if (sc->type != ST_RECOLOUR && sc->ptr != NULL) DeleteEntryFromSpriteCache(i);
-	}
+	/* Clear sprite ptr for all cached items, except for the recolour sprites */
+	while (_sprite_lru_last != SPRITE_LRU_END) DeleteEntryFromSpriteCache(_sprite_lru_last);
 }
 
 /* static */ ReusableBuffer<SpriteLoader::CommonPixel> SpriteLoader::Sprite::buffer[ZOOM_LVL_COUNT];
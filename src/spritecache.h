@@ -50,6 +50,8 @@ static inline const byte *GetNonSprite(SpriteID sprite, SpriteType type)
 void GfxInitSpriteMem();
 void GfxClearSpriteCache();
 void IncreaseSpriteLRU();
+uint GetSpriteCacheGeneration();
+uint PrefetchSprites(const SpriteID *sprites, uint count, uint threads);
 
 void ReadGRFSpriteOffsets(byte container_version);
 size_t GetGRFSpriteOffset(uint32 id);
@@ -26,6 +26,7 @@
 #include "core/random_func.hpp"
 #include "linkgraph/linkgraph.h"
 #include "linkgraph/linkgraphschedule.h"
+#include "spatial_index.h"
 
 #include "table/strings.h"
 
@@ -64,6 +65,12 @@ Station::Station(TileIndex tile) :
 	last_vehicle_type(VEH_INVALID)
 {
 	/* this->random_bits is set in Station::AddFacility() */
+
+	if (tile != INVALID_TILE) _station_spatial_index.Add(this->index, TileArea(tile, 1, 1));
+
+	/* Not registered in the catchment index until the station gets tiles. */
+	this->catchment_index_blocks.left = this->catchment_index_blocks.top = 0;
+	this->catchment_index_blocks.right = this->catchment_index_blocks.bottom = -1;
 }
 
 /**
@@ -86,6 +93,10 @@ Station::~Station()
 		this->loading_vehicles.front()->LeaveStation();
 	}
 
+	this->rect.MakeEmpty();
+	this->UpdateCatchmentIndex();
+	_station_spatial_index.Remove(this->index, TileArea(this->xy, 1, 1));
+
 	Aircraft *a;
 	FOR_ALL_AIRCRAFT(a) {
 		if (!a->IsNormalAircraft()) continue;
@@ -187,7 +198,12 @@ RoadStop *Station::GetPrimaryRoadStop(const RoadVehicle *v) const
 void Station::AddFacility(StationFacility new_facility_bit, TileIndex facil_xy)
 {
 	if (this->facilities == FACIL_NONE) {
-		this->xy = facil_xy;
+		if (this->xy != facil_xy) {
+			/* Keep the spatial index in sync with the new sign location. */
+			if (this->xy != INVALID_TILE) _station_spatial_index.Remove(this->index, TileArea(this->xy, 1, 1));
+			_station_spatial_index.Add(this->index, TileArea(facil_xy, 1, 1));
+			this->xy = facil_xy;
+		}
 		this->random_bits = Random();
 	}
 	this->facilities |= new_facility_bit;
@@ -352,10 +368,13 @@ static bool FindIndustryToDeliver(TileIndex ind_tile, void *user_data)
 
 /**
  * Recomputes Station::industries_near, list of industries possibly
- * accepting cargo in station's catchment radius
+ * accepting cargo in station's catchment radius, and updates the
+ * station catchment index as the station rectangle might have changed.
  */
 void Station::RecomputeIndustriesNear()
 {
+	this->UpdateCatchmentIndex();
+
 	this->industries_near.Clear();
 	if (this->rect.IsEmpty()) return;
 
@@ -383,6 +402,108 @@ void Station::RecomputeIndustriesNear()
 	FOR_ALL_STATIONS(st) st->RecomputeIndustriesNear();
 }
 
+/************************************************************************/
+/*                    Station catchment index                           */
+/************************************************************************/
+
+static const uint CATCHMENT_INDEX_BLOCK_BITS = 4; ///< Log2 of the size of the square blocks of tiles of the catchment index.
+
+static StationList *_catchment_index = NULL; ///< Per block of tiles the stations whose catchment might reach into the block.
+static uint _catchment_index_size_x = 0;     ///< Number of blocks of the catchment index along the X axis.
+static uint _catchment_index_size_y = 0;     ///< Number of blocks of the catchment index along the Y axis.
+
+uint _station_catchment_version = 1; ///< Changes each time a station or its catchment might have changed, see Industry::GetStationsNear().
+
+/**
+ * Clear the station catchment index and size it for the current map.
+ */
+void InitializeStationCatchmentIndex()
+{
+	delete[] _catchment_index;
+	_catchment_index_size_x = MapSizeX() >> CATCHMENT_INDEX_BLOCK_BITS;
+	_catchment_index_size_y = MapSizeY() >> CATCHMENT_INDEX_BLOCK_BITS;
+	_catchment_index = new StationList[_catchment_index_size_x * _catchment_index_size_y];
+	_station_catchment_version++;
+}
+
+/**
+ * Make sure the station catchment index matches the size of the map.
+ * The map is only resized when no stations exist, e.g. while loading a game.
+ */
+static inline void ValidateStationCatchmentIndex()
+{
+	if (_catchment_index_size_x != MapSizeX() >> CATCHMENT_INDEX_BLOCK_BITS || _catchment_index_size_y != MapSizeY() >> CATCHMENT_INDEX_BLOCK_BITS) {
+		InitializeStationCatchmentIndex();
+	}
+}
+
+/**
+ * Register the station in the blocks of the catchment index its catchment
+ * might reach into, i.e. its rectangle grown by the maximum catchment radius.
+ * Must be called each time the station rectangle changes.
+ */
+void Station::UpdateCatchmentIndex()
+{
+	ValidateStationCatchmentIndex();
+
+	/* Station tiles or facilities might have changed within the same rectangle as well. */
+	_station_catchment_version++;
+
+	Rect blocks;
+	if (this->rect.IsEmpty()) {
+		blocks.left = blocks.top = 0;
+		blocks.right = blocks.bottom = -1;
+	} else {
+		blocks.left   = max<int>(this->rect.left   - MAX_CATCHMENT, 0)         >> CATCHMENT_INDEX_BLOCK_BITS;
+		blocks.top    = max<int>(this->rect.top    - MAX_CATCHMENT, 0)         >> CATCHMENT_INDEX_BLOCK_BITS;
+		blocks.right  = min<int>(this->rect.right  + MAX_CATCHMENT, MapMaxX()) >> CATCHMENT_INDEX_BLOCK_BITS;
+		blocks.bottom = min<int>(this->rect.bottom + MAX_CATCHMENT, MapMaxY()) >> CATCHMENT_INDEX_BLOCK_BITS;
+	}
+
+	Rect &old = this->catchment_index_blocks;
+	if (old.left == blocks.left && old.top == blocks.top && old.right == blocks.right && old.bottom == blocks.bottom) return;
+
+	for (int y = old.top; y <= old.bottom; y++) {
+		for (int x = old.left; x <= old.right; x++) {
+			StationList &list = _catchment_index[y * _catchment_index_size_x + x];
+			list.Erase(list.Find(this));
+		}
+	}
+	for (int y = blocks.top; y <= blocks.bottom; y++) {
+		for (int x = blocks.left; x <= blocks.right; x++) {
+			*_catchment_index[y * _catchment_index_size_x + x].Append() = this;
+		}
+	}
+
+	old = blocks;
+}
+
+/**
+ * Find the stations whose catchment might reach into the given area.
+ * This is a superset of the stations that actually have the area in
+ * their catchment, in no particular order.
+ * @param area     The area to find the stations for.
+ * @param stations The list to add the stations to.
+ */
+void FindStationsInCatchmentIndex(const TileArea &area, StationList *stations)
+{
+	ValidateStationCatchmentIndex();
+
+	uint left   = TileX(area.tile) >> CATCHMENT_INDEX_BLOCK_BITS;
+	uint top    = TileY(area.tile) >> CATCHMENT_INDEX_BLOCK_BITS;
+	uint right  = min(TileX(area.tile) + area.w - 1, MapMaxX()) >> CATCHMENT_INDEX_BLOCK_BITS;
+	uint bottom = min(TileY(area.tile) + area.h - 1, MapMaxY()) >> CATCHMENT_INDEX_BLOCK_BITS;
+
+	for (uint y = top; y <= bottom; y++) {
+		for (uint x = left; x <= right; x++) {
+			const StationList &list = _catchment_index[y * _catchment_index_size_x + x];
+			for (Station * const *st = list.Begin(); st != list.End(); st++) {
+				stations->Include(*st);
+			}
+		}
+	}
+}
+
 /************************************************************************/
 /*                     StationRect implementation                       */
 /************************************************************************/
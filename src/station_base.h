@@ -473,6 +473,7 @@ public:
 	uint32 always_accepted;       ///< Bitmask of always accepted cargo types (by houses, HQs, industry tiles when industry doesn't accept cargo)
 
 	IndustryVector industries_near; ///< Cached list of industries near the station that can accept cargo, @see DeliverGoodsToIndustry()
+	Rect catchment_index_blocks;    ///< Blocks of the station catchment index the station is registered in, @see FindStationsInCatchmentIndex()
 
 	Station(TileIndex tile = INVALID_TILE);
 	~Station();
@@ -487,6 +488,7 @@ public:
 	/* virtual */ uint GetPlatformLength(TileIndex tile) const;
 	void RecomputeIndustriesNear();
 	static void RecomputeIndustriesNearForAll();
+	void UpdateCatchmentIndex();
 
 	uint GetCatchmentRadius() const;
 	Rect GetCatchmentRect() const;
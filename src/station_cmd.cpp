@@ -52,6 +52,7 @@
 #include "company_gui.h"
 #include "linkgraph/linkgraph_base.h"
 #include "linkgraph/refresh.h"
+#include "spatial_index.h"
 #include "widgets/station_widget.h"
 
 #include "table/strings.h"
@@ -351,6 +352,18 @@ static StringID GenerateStationName(Station *st, TileIndex tile, StationNaming n
 }
 #undef M
 
+/**
+ * Check whether a station is a deleted station of the current company.
+ * @param id The station to check.
+ * @param user_data Unused.
+ * @return True if the station is not in use and owned by the current company.
+ */
+static bool IsDeletedStationOfCurrentCompany(uint16 id, void *user_data)
+{
+	const Station *st = Station::Get(id);
+	return !st->IsInUse() && st->owner == _current_company;
+}
+
 /**
  * Find the closest deleted station of the current company
  * @param tile the tile to search from.
@@ -358,22 +371,8 @@ static StringID GenerateStationName(Station *st, TileIndex tile, StationNaming n
  */
 static Station *GetClosestDeletedStation(TileIndex tile)
 {
-	uint threshold = 8;
-	Station *best_station = NULL;
-	Station *st;
-
-	FOR_ALL_STATIONS(st) {
-		if (!st->IsInUse() && st->owner == _current_company) {
-			uint cur_dist = DistanceManhattan(tile, st->xy);
-
-			if (cur_dist < threshold) {
-				threshold = cur_dist;
-				best_station = st;
-			}
-		}
-	}
-
-	return best_station;
+	StationID best_station = _station_spatial_index.FindNearest(tile, 8, &IsDeletedStationOfCurrentCompany);
+	return best_station == SpatialIndex::INVALID_ITEM ? NULL : Station::Get(best_station);
 }
 
 
@@ -503,9 +502,11 @@ CargoArray GetProductionAroundTiles(TileIndex tile, int w, int h, int rad)
 	 * area loop might not hit an industry tile while
 	 * the industry would produce cargo for the station.
 	 */
-	const Industry *i;
-	FOR_ALL_INDUSTRIES(i) {
-		if (!ta.Intersects(i->location)) continue;
+	SpatialIndexItemList industries;
+	_industry_spatial_index.FindInArea(ta, &industries);
+
+	for (const uint16 *id = industries.Begin(); id != industries.End(); id++) {
+		const Industry *i = Industry::Get(*id);
 
 		for (uint j = 0; j < lengthof(i->produced_cargo); j++) {
 			CargoID cargo = i->produced_cargo[j];
@@ -648,10 +649,16 @@ static void UpdateStationSignCoord(BaseStation *st)
 	if (r->IsEmpty()) return; // no tiles belong to this station
 
 	/* clamp sign coord to be inside the station rect */
+	TileIndex old_xy = st->xy;
 	st->xy = TileXY(ClampU(TileX(st->xy), r->left, r->right), ClampU(TileY(st->xy), r->top, r->bottom));
 	st->UpdateVirtCoord();
 
 	if (!Station::IsExpected(st)) return;
+	if (st->xy != old_xy) {
+		_station_spatial_index.Remove(st->index, TileArea(old_xy, 1, 1));
+		_station_spatial_index.Add(st->index, TileArea(st->xy, 1, 1));
+	}
+
 	Station *full_station = Station::From(st);
 	for (CargoID c = 0; c < NUM_CARGO; ++c) {
 		LinkGraphID lg = full_station->goods[c].link_graph;
@@ -3787,30 +3794,60 @@ void FindStationsAroundTiles(const TileArea &location, StationList *stations)
 	if (max_x >= MapSizeX()) max_x = MapSizeX() - 1;
 	if (max_y >= MapSizeY()) max_y = MapSizeY() - 1;
 
-	for (uint cy = min_y; cy < max_y; cy++) {
-		for (uint cx = min_x; cx < max_x; cx++) {
-			TileIndex cur_tile = TileXY(cx, cy);
-			if (!IsTileType(cur_tile, MP_STATION)) continue;
+	/* Only the stations registered around the producer can have tiles in the area. */
+	StationList candidates;
+	FindStationsInCatchmentIndex(location, &candidates);
+	if (candidates.Length() == 0) return;
 
-			Station *st = Station::GetByTile(cur_tile);
-			/* st can be NULL in case of waypoints */
-			if (st == NULL) continue;
+	/* The stations are listed in the order a scan over the area would find them,
+	 * as the order decides which station gets the cargo when ratings are equal. */
+	StationList found;
+	SmallVector<TileIndex, 2> first_tiles;
 
-			if (_settings_game.station.modified_catchment) {
-				int rad = st->GetCatchmentRadius();
-				int rad_x = cx - x;
-				int rad_y = cy - y;
+	for (Station * const *st_iter = candidates.Begin(); st_iter != candidates.End(); ++st_iter) {
+		Station *st = *st_iter;
+		if (st->rect.IsEmpty()) continue;
+
+		/* Part of the area where tiles of this station can be. */
+		int left   = max<int>(min_x, st->rect.left);
+		int right  = min<int>(max_x - 1, st->rect.right);
+		int top    = max<int>(min_y, st->rect.top);
+		int bottom = min<int>(max_y - 1, st->rect.bottom);
+
+		if (_settings_game.station.modified_catchment) {
+			int rad = st->GetCatchmentRadius();
+			left   = max<int>(left, (int)x - rad);
+			right  = min<int>(right, (int)(x + location.w) + rad - 1);
+			top    = max<int>(top, (int)y - rad);
+			bottom = min<int>(bottom, (int)(y + location.h) + rad - 1);
+		}
 
-				if (rad_x < -rad || rad_x >= rad + location.w) continue;
-				if (rad_y < -rad || rad_y >= rad + location.h) continue;
+		TileIndex first_tile = INVALID_TILE;
+		for (int cy = top; cy <= bottom && first_tile == INVALID_TILE; cy++) {
+			for (int cx = left; cx <= right; cx++) {
+				TileIndex cur_tile = TileXY(cx, cy);
+				if (IsTileType(cur_tile, MP_STATION) && GetStationIndex(cur_tile) == st->index) {
+					first_tile = cur_tile;
+					break;
+				}
 			}
+		}
+		if (first_tile == INVALID_TILE) continue;
 
-			/* Insert the station in the set. This will fail if it has
-			 * already been added.
-			 */
-			stations->Include(st);
+		*found.Append() = st;
+		*first_tiles.Append() = first_tile;
+		for (uint i = found.Length() - 1; i > 0 && first_tiles[i - 1] > first_tiles[i]; i--) {
+			Swap(found[i - 1], found[i]);
+			Swap(first_tiles[i - 1], first_tiles[i]);
 		}
 	}
+
+	for (Station * const *st_iter = found.Begin(); st_iter != found.End(); ++st_iter) {
+		/* Insert the station in the set. This will fail if it has
+		 * already been added.
+		 */
+		stations->Include(*st_iter);
+	}
 }
 
 /**
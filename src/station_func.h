@@ -23,6 +23,9 @@
 void ModifyStationRatingAround(TileIndex tile, Owner owner, int amount, uint radius);
 
 void FindStationsAroundTiles(const TileArea &location, StationList *stations);
+void FindStationsInCatchmentIndex(const TileArea &area, StationList *stations);
+
+extern uint _station_catchment_version;
 
 void ShowStationViewWindow(StationID station);
 void UpdateAllStationVirtCoords();
@@ -16,6 +16,7 @@
 #include "genworld.h"
 #include "core/random_func.hpp"
 #include "landscape_type.h"
+#include "thread/worker_pool.h"
 
 #include "safeguards.h"
 
@@ -147,8 +148,11 @@
  *
  * As you can see above, each noise function was called just once. Therefore
  * we don't need to use noise function that calculates the noise from x, y and
- * some prime. The same quality result we can obtain using standard Random()
- * function instead.
+ * some prime. The same quality result we can obtain using a simple hash of x, y
+ * and a seed taken from the standard Random() function instead. As the noise
+ * of a point does not depend on the order in which the points are visited, the
+ * rows of the height map can be generated by multiple threads, while a seed
+ * still yields the same map regardless of the number of threads.
  *
  */
 
@@ -328,15 +332,114 @@ static inline void FreeHeightMap()
 	_height_map.h = NULL;
 }
 
+/**
+ * Mix the bits of a value, so every input bit affects every output bit.
+ * @param h The value to mix.
+ * @return The mixed value.
+ */
+static inline uint32 MixNoiseBits(uint32 h)
+{
+	h ^= h >> 16;
+	h *= 0x85EBCA6B;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35;
+	h ^= h >> 16;
+	return h;
+}
+
 /**
  * Generates new random height in given amplitude (generated numbers will range from - amplitude to + amplitude)
- * @param rMax Limit of result
+ * @param seed      Seed of the height map.
+ * @param frequency Frequency the height is generated for.
+ * @param x         X position of the height.
+ * @param y         Y position of the height.
+ * @param rMax      Limit of result
  * @return generated height
  */
-static inline height_t RandomHeight(amplitude_t rMax)
+static inline height_t RandomHeight(uint32 seed, int frequency, int x, int y, amplitude_t rMax)
 {
+	uint32 r = MixNoiseBits(seed ^ frequency);
+	r = MixNoiseBits(r ^ x);
+	r = MixNoiseBits(r ^ y);
+
 	/* Spread height into range -rMax..+rMax */
-	return A2H(RandomRange(2 * rMax + 1) - rMax);
+	return A2H((amplitude_t)(((uint64)r * (2 * rMax + 1)) >> 32) - rMax);
+}
+
+/** Parameters of one frequency of #HeightMapGenerate. */
+struct HeightMapNoiseRound {
+	uint32 seed;           ///< Seed of the height map.
+	int frequency;         ///< The frequency.
+	amplitude_t amplitude; ///< Amplitude of the noise of the frequency.
+	int step;              ///< Distance between the points of the frequency.
+};
+
+/**
+ * Set the base heights of a row of the first frequency.
+ * @param param The #HeightMapNoiseRound.
+ * @param job   The number of the row, in steps.
+ */
+static void HeightMapBaseRowJob(void *param, uint job)
+{
+	const HeightMapNoiseRound *round = (const HeightMapNoiseRound *)param;
+	int y = job * round->step;
+
+	for (int x = 0; x <= _height_map.size_x; x += round->step) {
+		_height_map.height(x, y) = (round->amplitude > 0) ? RandomHeight(round->seed, round->frequency, x, y, round->amplitude) : 0;
+	}
+}
+
+/**
+ * Interpolate height values at odd x of an even row.
+ * @param param The #HeightMapNoiseRound.
+ * @param job   The number of the row, in double steps.
+ */
+static void HeightMapInterpolateRowJob(void *param, uint job)
+{
+	const HeightMapNoiseRound *round = (const HeightMapNoiseRound *)param;
+	int step = round->step;
+	int y = job * 2 * step;
+
+	for (int x = 0; x <= _height_map.size_x - 2 * step; x += 2 * step) {
+		height_t h00 = _height_map.height(x + 0 * step, y);
+		height_t h02 = _height_map.height(x + 2 * step, y);
+		height_t h01 = (h00 + h02) / 2;
+		_height_map.height(x + 1 * step, y) = h01;
+	}
+}
+
+/**
+ * Interpolate height values of an odd row from the even rows around it.
+ * @param param The #HeightMapNoiseRound.
+ * @param job   The number of the even row above it, in double steps.
+ */
+static void HeightMapInterpolateColumnsJob(void *param, uint job)
+{
+	const HeightMapNoiseRound *round = (const HeightMapNoiseRound *)param;
+	int step = round->step;
+	int y = job * 2 * step;
+
+	for (int x = 0; x <= _height_map.size_x; x += step) {
+		height_t h00 = _height_map.height(x, y + 0 * step);
+		height_t h20 = _height_map.height(x, y + 2 * step);
+		height_t h10 = (h00 + h20) / 2;
+		_height_map.height(x, y + 1 * step) = h10;
+	}
+}
+
+/**
+ * Add noise to a row for the next higher frequency.
+ * @param param The #HeightMapNoiseRound.
+ * @param job   The number of the row, in steps.
+ */
+static void HeightMapNoiseRowJob(void *param, uint job)
+{
+	const HeightMapNoiseRound *round = (const HeightMapNoiseRound *)param;
+	int y = job * round->step;
+
+	for (int x = 0; x <= _height_map.size_x; x += round->step) {
+		_height_map.height(x, y) += RandomHeight(round->seed, round->frequency, x, y, round->amplitude);
+	}
 }
 
 /**
@@ -354,6 +457,9 @@ static void HeightMapGenerate()
 	int start = max(MAX_TGP_FREQUENCIES - (int)min(MapLogX(), MapLogY()), 0);
 	bool first = true;
 
+	HeightMapNoiseRound round;
+	round.seed = Random();
+
 	for (int frequency = start; frequency < MAX_TGP_FREQUENCIES; frequency++) {
 		const amplitude_t amplitude = GetAmplitude(frequency);
 
@@ -363,45 +469,26 @@ static void HeightMapGenerate()
 
 		const int step = 1 << (MAX_TGP_FREQUENCIES - frequency - 1);
 
+		round.frequency = frequency;
+		round.amplitude = amplitude;
+		round.step = step;
+
 		if (first) {
 			/* This is first round, we need to establish base heights with step = size_min */
-			for (int y = 0; y <= _height_map.size_y; y += step) {
-				for (int x = 0; x <= _height_map.size_x; x += step) {
-					height_t height = (amplitude > 0) ? RandomHeight(amplitude) : 0;
-					_height_map.height(x, y) = height;
-				}
-			}
+			_genworld_workers.Run(&HeightMapBaseRowJob, &round, _height_map.size_y / step + 1);
 			first = false;
 			continue;
 		}
 
 		/* It is regular iteration round.
 		 * Interpolate height values at odd x, even y tiles */
-		for (int y = 0; y <= _height_map.size_y; y += 2 * step) {
-			for (int x = 0; x <= _height_map.size_x - 2 * step; x += 2 * step) {
-				height_t h00 = _height_map.height(x + 0 * step, y);
-				height_t h02 = _height_map.height(x + 2 * step, y);
-				height_t h01 = (h00 + h02) / 2;
-				_height_map.height(x + 1 * step, y) = h01;
-			}
-		}
+		_genworld_workers.Run(&HeightMapInterpolateRowJob, &round, _height_map.size_y / (2 * step) + 1);
 
 		/* Interpolate height values at odd y tiles */
-		for (int y = 0; y <= _height_map.size_y - 2 * step; y += 2 * step) {
-			for (int x = 0; x <= _height_map.size_x; x += step) {
-				height_t h00 = _height_map.height(x, y + 0 * step);
-				height_t h20 = _height_map.height(x, y + 2 * step);
-				height_t h10 = (h00 + h20) / 2;
-				_height_map.height(x, y + 1 * step) = h10;
-			}
-		}
+		_genworld_workers.Run(&HeightMapInterpolateColumnsJob, &round, _height_map.size_y / (2 * step));
 
 		/* Add noise for next higher frequency (smaller steps) */
-		for (int y = 0; y <= _height_map.size_y; y += step) {
-			for (int x = 0; x <= _height_map.size_x; x += step) {
-				_height_map.height(x, y) += RandomHeight(amplitude);
-			}
-		}
+		_genworld_workers.Run(&HeightMapNoiseRowJob, &round, _height_map.size_y / step + 1);
 	}
 }
 
@@ -443,12 +530,24 @@ static int *HeightMapMakeHistogram(height_t h_min, height_t h_max, int *hist_buf
 	return hist;
 }
 
-/** Applies sine wave redistribution onto height map */
-static void HeightMapSineTransform(height_t h_min, height_t h_max)
+/** Range of heights for #HeightMapSineTransformRowJob. */
+struct HeightMapSineTransformRange {
+	height_t h_min; ///< Lowest height to transform.
+	height_t h_max; ///< Highest height after the transformation.
+};
+
+/**
+ * Applies sine wave redistribution onto a row of the height map.
+ * @param param The #HeightMapSineTransformRange.
+ * @param job   The row.
+ */
+static void HeightMapSineTransformRowJob(void *param, uint job)
 {
-	height_t *h;
+	const HeightMapSineTransformRange *range = (const HeightMapSineTransformRange *)param;
+	height_t h_min = range->h_min;
+	height_t h_max = range->h_max;
 
-	FOR_ALL_TILES_IN_HEIGHT(h) {
+	for (height_t *h = &_height_map.height(0, job); h <= &_height_map.height(_height_map.size_x, job); h++) {
 		double fheight;
 
 		if (*h < h_min) continue;
@@ -520,6 +619,142 @@ static void HeightMapSineTransform(height_t h_min, height_t h_max)
 	}
 }
 
+/** Applies sine wave redistribution onto height map */
+static void HeightMapSineTransform(height_t h_min, height_t h_max)
+{
+	HeightMapSineTransformRange range = { h_min, h_max };
+	_genworld_workers.Run(&HeightMapSineTransformRowJob, &range, _height_map.size_y + 1);
+}
+
+/** Basically scale height X to height Y. Everything in between is interpolated. */
+struct control_point_t {
+	height_t x; ///< The height to scale from.
+	height_t y; ///< The height to scale to.
+};
+
+/** Helper structure to index the different curve maps. */
+struct control_point_list_t {
+	size_t length;               ///< The length of the curve map.
+	const control_point_t *list; ///< The actual curve map.
+};
+
+/** Position of a tile along one axis of the grid choosing the curve maps. */
+struct CurveGridPosition {
+	uint p1;  ///< First grid position to interpolate between.
+	uint p2;  ///< Second grid position to interpolate between.
+	float r;  ///< Bi-linear ratio of the second grid position.
+	float ri; ///< Bi-linear ratio of the first grid position.
+};
+
+/** Data shared by the rows of #HeightMapCurves. */
+struct HeightMapCurvesData {
+	const control_point_list_t *curve_maps; ///< The curve maps.
+	uint num_curve_maps;                    ///< Number of curve maps.
+	const byte *c;                          ///< Grid of the curve maps to use.
+	uint sx;                                ///< Width of the grid.
+	uint sy;                                ///< Height of the grid.
+	const CurveGridPosition *x_pos;         ///< Grid positions of all columns of the height map.
+};
+
+/**
+ * Get the position of a tile along one axis of the grid choosing the curve maps.
+ * @param grid_size Size of the grid along the axis.
+ * @param pos       Position of the tile along the axis.
+ * @param map_size  Size of the height map along the axis.
+ * @return The grid positions and bi-linear ratios.
+ */
+static CurveGridPosition GetCurveGridPosition(uint grid_size, int pos, int map_size)
+{
+	CurveGridPosition gp;
+
+	float f = (float)(grid_size * pos) / map_size + 1.0f;
+	gp.p1 = (uint)f;
+	gp.p2 = gp.p1;
+	gp.r = 2.0f * (f - gp.p1) - 1.0f;
+	gp.r = sin(gp.r * M_PI_2);
+	gp.r = sin(gp.r * M_PI_2);
+	gp.r = 0.5f * (gp.r + 1.0f);
+	gp.ri = 1.0f - gp.r;
+
+	if (gp.p1 > 0) {
+		gp.p1--;
+		if (gp.p2 >= grid_size) gp.p2--;
+	}
+
+	return gp;
+}
+
+/**
+ * Apply the curve maps to a row of the height map.
+ * @param param The #HeightMapCurvesData.
+ * @param job   The row.
+ */
+static void HeightMapCurvesRowJob(void *param, uint job)
+{
+	const HeightMapCurvesData *data = (const HeightMapCurvesData *)param;
+	const control_point_list_t *curve_maps = data->curve_maps;
+	const byte *c = data->c;
+	uint sx = data->sx;
+
+	height_t ht[4];
+	assert(data->num_curve_maps <= lengthof(ht));
+	MemSetT(ht, 0, lengthof(ht));
+
+	/* Get our Y grid position and bi-linear ratio */
+	int y = job;
+	CurveGridPosition y_pos = GetCurveGridPosition(data->sy, y, _height_map.size_y);
+
+	for (int x = 0; x < _height_map.size_x; x++) {
+		const CurveGridPosition &x_pos = data->x_pos[x];
+
+		uint corner_a = c[x_pos.p1 + sx * y_pos.p1];
+		uint corner_b = c[x_pos.p1 + sx * y_pos.p2];
+		uint corner_c = c[x_pos.p2 + sx * y_pos.p1];
+		uint corner_d = c[x_pos.p2 + sx * y_pos.p2];
+
+		/* Bitmask of which curve maps are chosen, so that we do not bother
+		 * calculating a curve which won't be used. */
+		uint corner_bits = 0;
+		corner_bits |= 1 << corner_a;
+		corner_bits |= 1 << corner_b;
+		corner_bits |= 1 << corner_c;
+		corner_bits |= 1 << corner_d;
+
+		height_t *h = &_height_map.height(x, y);
+
+		/* Do not touch sea level */
+		if (*h < I2H(1)) continue;
+
+		/* Only scale above sea level */
+		*h -= I2H(1);
+
+		/* Apply all curve maps that are used on this tile. */
+		for (uint t = 0; t < data->num_curve_maps; t++) {
+			if (!HasBit(corner_bits, t)) continue;
+
+			bool found = false;
+			const control_point_t *cm = curve_maps[t].list;
+			for (uint i = 0; i < curve_maps[t].length - 1; i++) {
+				const control_point_t &p1 = cm[i];
+				const control_point_t &p2 = cm[i + 1];
+
+				if (*h >= p1.x && *h < p2.x) {
+					ht[t] = p1.y + (*h - p1.x) * (p2.y - p1.y) / (p2.x - p1.x);
+					found = true;
+					break;
+				}
+			}
+			assert(found);
+		}
+
+		/* Apply interpolation of curve map results. */
+		*h = (height_t)((ht[corner_a] * y_pos.ri + ht[corner_b] * y_pos.r) * x_pos.ri + (ht[corner_c] * y_pos.ri + ht[corner_d] * y_pos.r) * x_pos.r);
+
+		/* Readd sea level */
+		*h += I2H(1);
+	}
+}
+
 /**
  * Additional map variety is provided by applying different curve maps
  * to different parts of the map. A randomized low resolution grid contains
@@ -540,11 +775,6 @@ static void HeightMapCurves(uint level)
 {
 	height_t mh = TGPGetMaxHeight() - I2H(1); // height levels above sea level only
 
-	/** Basically scale height X to height Y. Everything in between is interpolated. */
-	struct control_point_t {
-		height_t x; ///< The height to scale from.
-		height_t y; ///< The height to scale to.
-	};
 	/* Scaled curve maps; value is in height_ts. */
 #define F(fraction) ((height_t)(fraction * mh))
 	const control_point_t curve_map_1[] = { { F(0.0), F(0.0) },                       { F(0.8), F(0.13) },                       { F(1.0), F(0.4)  } };
@@ -553,11 +783,6 @@ static void HeightMapCurves(uint level)
 	const control_point_t curve_map_4[] = { { F(0.0), F(0.0) }, { F(0.4),  F(0.3)  }, { F(0.7), F(0.8)  }, { F(0.92), F(0.99) }, { F(1.0), F(0.99) } };
 #undef F
 
-	/** Helper structure to index the different curve maps. */
-	struct control_point_list_t {
-		size_t length;               ///< The length of the curve map.
-		const control_point_t *list; ///< The actual curve map.
-	};
 	const control_point_list_t curve_maps[] = {
 		{ lengthof(curve_map_1), curve_map_1 },
 		{ lengthof(curve_map_2), curve_map_2 },
@@ -565,9 +790,6 @@ static void HeightMapCurves(uint level)
 		{ lengthof(curve_map_4), curve_map_4 },
 	};
 
-	height_t ht[lengthof(curve_maps)];
-	MemSetT(ht, 0, lengthof(ht));
-
 	/* Set up a grid to choose curve maps based on location; attempt to get a somewhat square grid */
 	float factor = sqrt((float)_height_map.size_x / (float)_height_map.size_y);
 	uint sx = Clamp((int)(((1 << level) * factor) + 0.5), 1, 128);
@@ -578,88 +800,17 @@ static void HeightMapCurves(uint level)
 		c[i] = Random() % lengthof(curve_maps);
 	}
 
-	/* Apply curves */
+	/* Get our X grid positions and bi-linear ratios */
+	CurveGridPosition *x_pos = MallocT<CurveGridPosition>(_height_map.size_x);
 	for (int x = 0; x < _height_map.size_x; x++) {
+		x_pos[x] = GetCurveGridPosition(sx, x, _height_map.size_x);
+	}
 
-		/* Get our X grid positions and bi-linear ratio */
-		float fx = (float)(sx * x) / _height_map.size_x + 1.0f;
-		uint x1 = (uint)fx;
-		uint x2 = x1;
-		float xr = 2.0f * (fx - x1) - 1.0f;
-		xr = sin(xr * M_PI_2);
-		xr = sin(xr * M_PI_2);
-		xr = 0.5f * (xr + 1.0f);
-		float xri = 1.0f - xr;
-
-		if (x1 > 0) {
-			x1--;
-			if (x2 >= sx) x2--;
-		}
-
-		for (int y = 0; y < _height_map.size_y; y++) {
-
-			/* Get our Y grid position and bi-linear ratio */
-			float fy = (float)(sy * y) / _height_map.size_y + 1.0f;
-			uint y1 = (uint)fy;
-			uint y2 = y1;
-			float yr = 2.0f * (fy - y1) - 1.0f;
-			yr = sin(yr * M_PI_2);
-			yr = sin(yr * M_PI_2);
-			yr = 0.5f * (yr + 1.0f);
-			float yri = 1.0f - yr;
-
-			if (y1 > 0) {
-				y1--;
-				if (y2 >= sy) y2--;
-			}
-
-			uint corner_a = c[x1 + sx * y1];
-			uint corner_b = c[x1 + sx * y2];
-			uint corner_c = c[x2 + sx * y1];
-			uint corner_d = c[x2 + sx * y2];
-
-			/* Bitmask of which curve maps are chosen, so that we do not bother
-			 * calculating a curve which won't be used. */
-			uint corner_bits = 0;
-			corner_bits |= 1 << corner_a;
-			corner_bits |= 1 << corner_b;
-			corner_bits |= 1 << corner_c;
-			corner_bits |= 1 << corner_d;
-
-			height_t *h = &_height_map.height(x, y);
-
-			/* Do not touch sea level */
-			if (*h < I2H(1)) continue;
-
-			/* Only scale above sea level */
-			*h -= I2H(1);
-
-			/* Apply all curve maps that are used on this tile. */
-			for (uint t = 0; t < lengthof(curve_maps); t++) {
-				if (!HasBit(corner_bits, t)) continue;
-
-				bool found = false;
-				const control_point_t *cm = curve_maps[t].list;
-				for (uint i = 0; i < curve_maps[t].length - 1; i++) {
-					const control_point_t &p1 = cm[i];
-					const control_point_t &p2 = cm[i + 1];
-
-					if (*h >= p1.x && *h < p2.x) {
-						ht[t] = p1.y + (*h - p1.x) * (p2.y - p1.y) / (p2.x - p1.x);
-						found = true;
-						break;
-					}
-				}
-				assert(found);
-			}
-
-			/* Apply interpolation of curve map results. */
-			*h = (height_t)((ht[corner_a] * yri + ht[corner_b] * yr) * xri + (ht[corner_c] * yri + ht[corner_d] * yr) * xr);
+	/* Apply curves */
+	HeightMapCurvesData data = { curve_maps, lengthof(curve_maps), c, sx, sy, x_pos };
+	_genworld_workers.Run(&HeightMapCurvesRowJob, &data, _height_map.size_y);
 
-			/* Readd sea level */
-			*h += I2H(1);
-		}
-	}
+	free(x_pos);
 }
 
 /** Adjusts heights in height map to contain required amount of water tiles */
@@ -833,27 +984,90 @@ static void HeightMapSmoothCoasts(uint8 water_borders)
 	}
 }
 
+/** Number of columns of the height map smoothed by one job of #HeightMapSmoothSlopes. */
+static const int SMOOTH_SLOPES_COLUMNS = 64;
+
+/** Parameters of a pass of #HeightMapSmoothSlopes. */
+struct HeightMapSmoothSlopesPass {
+	height_t dh_max; ///< Maximum height difference between neighbouring points.
+	bool forward;    ///< Whether to limit points by the points before them, otherwise by the points after them.
+};
+
+/**
+ * Limit the heights of a row by the heights of their neighbours in the row.
+ * @param param The #HeightMapSmoothSlopesPass.
+ * @param job   The row.
+ */
+static void HeightMapSmoothSlopesRowJob(void *param, uint job)
+{
+	const HeightMapSmoothSlopesPass *pass = (const HeightMapSmoothSlopesPass *)param;
+	int y = job;
+
+	if (pass->forward) {
+		for (int x = 1; x <= _height_map.size_x; x++) {
+			height_t h_max = _height_map.height(x - 1, y) + pass->dh_max;
+			if (_height_map.height(x, y) > h_max) _height_map.height(x, y) = h_max;
+		}
+	} else {
+		for (int x = _height_map.size_x - 1; x >= 0; x--) {
+			height_t h_max = _height_map.height(x + 1, y) + pass->dh_max;
+			if (_height_map.height(x, y) > h_max) _height_map.height(x, y) = h_max;
+		}
+	}
+}
+
+/**
+ * Limit the heights of a number of columns by the heights of their neighbours in the columns.
+ * @param param The #HeightMapSmoothSlopesPass.
+ * @param job   The group of #SMOOTH_SLOPES_COLUMNS columns.
+ */
+static void HeightMapSmoothSlopesColumnsJob(void *param, uint job)
+{
+	const HeightMapSmoothSlopesPass *pass = (const HeightMapSmoothSlopesPass *)param;
+	int x_begin = job * SMOOTH_SLOPES_COLUMNS;
+	int x_end = min(x_begin + SMOOTH_SLOPES_COLUMNS, _height_map.size_x + 1);
+
+	if (pass->forward) {
+		for (int y = 1; y <= _height_map.size_y; y++) {
+			for (int x = x_begin; x < x_end; x++) {
+				height_t h_max = _height_map.height(x, y - 1) + pass->dh_max;
+				if (_height_map.height(x, y) > h_max) _height_map.height(x, y) = h_max;
+			}
+		}
+	} else {
+		for (int y = _height_map.size_y - 1; y >= 0; y--) {
+			for (int x = x_begin; x < x_end; x++) {
+				height_t h_max = _height_map.height(x, y + 1) + pass->dh_max;
+				if (_height_map.height(x, y) > h_max) _height_map.height(x, y) = h_max;
+			}
+		}
+	}
+}
+
 /**
  * This routine provides the essential cleanup necessary before OTTD can
  * display the terrain. When generated, the terrain heights can jump more than
  * one level between tiles. This routine smooths out those differences so that
  * the most it can change is one level. When OTTD can support cliffs, this
  * routine may not be necessary.
+ *
+ * Limiting every height by its western and northern neighbour while walking
+ * from the north corner to the south corner gives the same result as first
+ * limiting all rows and then all columns, which can be done for all rows or
+ * columns at once. The same holds for the walk back to the north corner.
  */
 static void HeightMapSmoothSlopes(height_t dh_max)
 {
-	for (int y = 0; y <= (int)_height_map.size_y; y++) {
-		for (int x = 0; x <= (int)_height_map.size_x; x++) {
-			height_t h_max = min(_height_map.height(x > 0 ? x - 1 : x, y), _height_map.height(x, y > 0 ? y - 1 : y)) + dh_max;
-			if (_height_map.height(x, y) > h_max) _height_map.height(x, y) = h_max;
-		}
-	}
-	for (int y = _height_map.size_y; y >= 0; y--) {
-		for (int x = _height_map.size_x; x >= 0; x--) {
-			height_t h_max = min(_height_map.height(x < _height_map.size_x ? x + 1 : x, y), _height_map.height(x, y < _height_map.size_y ? y + 1 : y)) + dh_max;
-			if (_height_map.height(x, y) > h_max) _height_map.height(x, y) = h_max;
-		}
-	}
+	uint rows = _height_map.size_y + 1;
+	uint column_groups = (_height_map.size_x + SMOOTH_SLOPES_COLUMNS) / SMOOTH_SLOPES_COLUMNS;
+
+	HeightMapSmoothSlopesPass pass = { dh_max, true };
+	_genworld_workers.Run(&HeightMapSmoothSlopesRowJob, &pass, rows);
+	_genworld_workers.Run(&HeightMapSmoothSlopesColumnsJob, &pass, column_groups);
+
+	pass.forward = false;
+	_genworld_workers.Run(&HeightMapSmoothSlopesRowJob, &pass, rows);
+	_genworld_workers.Run(&HeightMapSmoothSlopesColumnsJob, &pass, column_groups);
 }
 
 /**
@@ -0,0 +1,174 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_pool.cpp Threads for running many small, independent jobs in parallel. */
+
+#include "../stdafx.h"
+#include "worker_pool.h"
+
+#include "../safeguards.h"
+
+/**
+ * Create a pool without threads.
+ * @param name Name of the threads of the pool.
+ */
+WorkerPool::WorkerPool(const char *name) :
+	name(name),
+	work_mutex(ThreadMutex::New()),
+	done_mutex(ThreadMutex::New()),
+	proc(NULL),
+	param(NULL),
+	jobs(0),
+	next(0),
+	done(0),
+	exit(false)
+{
+}
+
+/** Stop the threads of the pool. */
+WorkerPool::~WorkerPool()
+{
+	this->SetThreads(0);
+	delete this->work_mutex;
+	delete this->done_mutex;
+}
+
+/**
+ * Change the number of threads of the pool. This may only be called
+ * when no batch is running.
+ * @param threads The wanted number of threads, besides the thread starting the batches.
+ */
+void WorkerPool::SetThreads(uint threads)
+{
+	if (threads == this->workers.Length()) return;
+
+	if (this->workers.Length() != 0) {
+		this->work_mutex->BeginCritical();
+		this->exit = true;
+		this->work_mutex->EndCritical();
+		this->WakeWorkers();
+
+		for (Worker **w = this->workers.Begin(); w != this->workers.End(); w++) {
+			(*w)->thread->Join();
+			delete (*w)->thread;
+			delete (*w)->mutex;
+			delete *w;
+		}
+		this->workers.Clear();
+		this->exit = false;
+	}
+
+	for (uint i = 0; i < threads; i++) {
+		Worker *w = new Worker();
+		w->pool = this;
+		w->mutex = ThreadMutex::New();
+		w->wake = false;
+		if (!ThreadObject::New(&WorkerPool::ThreadProc, w, &w->thread, this->name)) {
+			delete w->mutex;
+			delete w;
+			break;
+		}
+		*this->workers.Append() = w;
+	}
+}
+
+/** Tell all threads of the pool to look for a new batch, or whether they have to stop. */
+void WorkerPool::WakeWorkers()
+{
+	for (Worker **w = this->workers.Begin(); w != this->workers.End(); w++) {
+		(*w)->mutex->BeginCritical();
+		(*w)->wake = true;
+		(*w)->mutex->SendSignal();
+		(*w)->mutex->EndCritical();
+	}
+}
+
+/**
+ * Take the next job of the current batch and run it.
+ * @return False if there was no job left.
+ */
+bool WorkerPool::RunJob()
+{
+	this->work_mutex->BeginCritical();
+	if (this->next >= this->jobs) {
+		this->work_mutex->EndCritical();
+		return false;
+	}
+	uint job = this->next++;
+	this->work_mutex->EndCritical();
+
+	this->proc(this->param, job);
+
+	this->done_mutex->BeginCritical();
+	if (++this->done == this->jobs) this->done_mutex->SendSignal();
+	this->done_mutex->EndCritical();
+	return true;
+}
+
+/**
+ * Run a batch of jobs and wait until all of them are done.
+ * @param proc  Function doing a single job.
+ * @param param Parameter for all jobs.
+ * @param jobs  Number of jobs.
+ */
+void WorkerPool::Run(WorkerJobProc proc, void *param, uint jobs)
+{
+	if (this->workers.Length() == 0 || jobs < 2) {
+		for (uint i = 0; i < jobs; i++) proc(param, i);
+		return;
+	}
+
+	this->done_mutex->BeginCritical();
+	this->done = 0;
+	this->done_mutex->EndCritical();
+
+	this->work_mutex->BeginCritical();
+	this->proc = proc;
+	this->param = param;
+	this->jobs = jobs;
+	this->next = 0;
+	this->work_mutex->EndCritical();
+	this->WakeWorkers();
+
+	/* Help with the jobs instead of only waiting for them. */
+	while (this->RunJob()) {}
+
+	this->done_mutex->BeginCritical();
+	while (this->done != jobs) this->done_mutex->WaitForSignal();
+	this->done_mutex->EndCritical();
+
+	this->work_mutex->BeginCritical();
+	this->jobs = 0;
+	this->next = 0;
+	this->work_mutex->EndCritical();
+}
+
+/**
+ * Main loop of the threads of a pool: wait for a batch and help with its jobs.
+ * @param worker The #Worker of the thread.
+ */
+/* static */ void WorkerPool::ThreadProc(void *worker)
+{
+	Worker *w = (Worker *)worker;
+	WorkerPool *self = w->pool;
+
+	for (;;) {
+		w->mutex->BeginCritical();
+		while (!w->wake) w->mutex->WaitForSignal();
+		w->wake = false;
+		w->mutex->EndCritical();
+
+		self->work_mutex->BeginCritical();
+		bool exit = self->exit;
+		self->work_mutex->EndCritical();
+
+		if (exit) return;
+		while (self->RunJob()) {}
+	}
+}
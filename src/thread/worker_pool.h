@@ -0,0 +1,79 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_pool.h Threads for running many small, independent jobs in parallel. */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include "thread.h"
+#include "../core/smallvec_type.hpp"
+
+/**
+ * Function doing one job of a batch.
+ * @param param The parameter given for the whole batch.
+ * @param job   The number of the job within the batch.
+ */
+typedef void (*WorkerJobProc)(void *param, uint job);
+
+/**
+ * A number of threads that run the jobs of a batch together with the thread
+ * that started the batch. Jobs must not depend on each other, as they run in
+ * any order. When no threads could be started, all jobs simply run on the
+ * thread that started the batch.
+ */
+class WorkerPool {
+public:
+	WorkerPool(const char *name);
+	~WorkerPool();
+
+	void SetThreads(uint threads);
+
+	/**
+	 * Get the number of threads helping with the jobs.
+	 * @return The number of running threads, not counting the thread starting the batches.
+	 */
+	uint GetThreads() const
+	{
+		return this->workers.Length();
+	}
+
+	void Run(WorkerJobProc proc, void *param, uint jobs);
+
+private:
+	/**
+	 * A thread of the pool. Every thread waits on a mutex of its own, as on
+	 * some platforms a signal wakes at most one of the threads waiting for it,
+	 * and signals sent before any thread waits may merge into one.
+	 */
+	struct Worker {
+		WorkerPool *pool;     ///< The pool the thread belongs to.
+		ThreadObject *thread; ///< The thread itself.
+		ThreadMutex *mutex;   ///< Mutex for #wake; the thread waits on it for a batch.
+		bool wake;            ///< Whether a batch was started, or the thread has to stop, since the thread last looked.
+	};
+
+	const char *name;                 ///< Name of the threads.
+	SmallVector<Worker *, 8> workers; ///< The threads of the pool.
+	ThreadMutex *work_mutex;          ///< Mutex for the batch.
+	ThreadMutex *done_mutex;          ///< Mutex for #done; the thread that started the batch waits on it.
+
+	WorkerJobProc proc; ///< Function doing the jobs of the current batch.
+	void *param;        ///< Parameter of the current batch.
+	uint jobs;          ///< Number of jobs in the current batch.
+	uint next;          ///< Next job that is not taken by any thread.
+	uint done;          ///< Number of finished jobs.
+	bool exit;          ///< Whether the threads should stop.
+
+	void WakeWorkers();
+	bool RunJob();
+	static void ThreadProc(void *worker);
+};
+
+#endif /* WORKER_POOL_H */
@@ -109,6 +109,50 @@ static inline bool IsInnerTile(TileIndex tile)
 	return x < MapMaxX() && y < MapMaxY() && ((x > 0 && y > 0) || !_settings_game.construction.freeform_edges);
 }
 
+/**
+ * Check whether the tile loop of a tile is known to do nothing.
+ * @param tile The tile to check.
+ * @pre tile < MapSize()
+ * @return True iff the tile loop of the tile can be skipped.
+ */
+static inline bool IsTileLoopIdle(TileIndex tile)
+{
+	assert(tile < MapSize());
+	return HasBit(_tile_loop_idle[tile / 8], tile % 8);
+}
+
+/**
+ * Mark that the tile loop of a tile does nothing until the type of the tile
+ * or of one of its neighbours changes. The tile loop must not draw random
+ * numbers for the tile either, as skipping it may not change the game state.
+ * @param tile The tile.
+ * @pre tile < MapSize()
+ */
+static inline void SetTileLoopIdle(TileIndex tile)
+{
+	assert(tile < MapSize());
+	SetBit(_tile_loop_idle[tile / 8], tile % 8);
+}
+
+/**
+ * Mark that the tile loop of a tile and its neighbours has to run again.
+ * @param tile The tile.
+ * @pre tile < MapSize()
+ */
+static inline void ClearTileLoopIdleAround(TileIndex tile)
+{
+	assert(tile < MapSize());
+	/* Multiple threads may change tiles near each other; the caller clears the bitmap when they are done. */
+	if (_tile_loop_idle_deferred) return;
+	for (int dy = -1; dy <= 1; dy++) {
+		for (int dx = -1; dx <= 1; dx++) {
+			/* Neighbours across the edge of the map wrap around; marking those active does no harm. */
+			TileIndex t = tile + TileDiffXY(dx, dy);
+			if (t < MapSize()) ClrBit(_tile_loop_idle[t / 8], t % 8);
+		}
+	}
+}
+
 /**
  * Set the type of a tile
  *
@@ -129,6 +173,7 @@ static inline void SetTileType(TileIndex tile, TileType type)
 	 * the upper edges of the map are also VOID tiles. */
 	assert(IsInnerTile(tile) == (type != MP_VOID));
 	SB(_m[tile].type, 4, 4, type);
+	ClearTileLoopIdleAround(tile);
 }
 
 /**
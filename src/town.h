@@ -28,6 +28,15 @@ struct BuildingCounts {
 
 typedef TileMatrix<uint32, 4> AcceptanceMatrix;
 
+/** Cargo acceptance and production of the houses of a town within one #AcceptanceMatrix square. */
+struct TownCargoSquare {
+	uint16 accepted[NUM_CARGO]; ///< Summed acceptance of the houses in the square, in 1/8 units.
+	uint32 produced;            ///< Bitmap of cargoes produced by houses in the square.
+	bool callback;              ///< Whether a house in the square decides its acceptance or production by callback.
+};
+
+typedef TileMatrix<TownCargoSquare, AcceptanceMatrix::GRID> TownCargoMatrix;
+
 static const uint CUSTOM_TOWN_NUMBER_DIFFICULTY  = 4; ///< value for custom town number in difficulty settings
 static const uint CUSTOM_TOWN_MAX_NUMBER = 5000;  ///< this is the maximum number of towns a user can specify in customisation
 
@@ -88,6 +97,7 @@ struct Town : TownPool::PoolItem<&_town_pool> {
 	uint32 cargo_produced;           ///< Bitmap of all cargoes produced by houses in this town.
 	AcceptanceMatrix cargo_accepted; ///< Bitmap of cargoes accepted by houses for each 4*4 map square of the town.
 	uint32 cargo_accepted_total;     ///< NOSAVE: Bitmap of all cargoes accepted by houses in this town.
+	TownCargoMatrix cargo_squares;   ///< NOSAVE: Acceptance and production of the houses for each 4*4 map square of the town.
 
 	uint16 time_until_rebuild;     ///< time until we rebuild a house
 
@@ -176,6 +186,7 @@ Town *CalcClosestTownFromTile(TileIndex tile, uint threshold = UINT_MAX);
 
 #define FOR_ALL_TOWNS_FROM(var, start) FOR_ALL_ITEMS_FROM(Town, town_index, var, start)
 #define FOR_ALL_TOWNS(var) FOR_ALL_TOWNS_FROM(var, 0)
+#define FOR_ALL_TOWNS_FROM_STEP(var, start, step) FOR_ALL_ITEMS_FROM_STEP(Town, town_index, var, start, step)
 
 void ResetHouses();
 
@@ -41,11 +41,14 @@
 #include "townname_func.h"
 #include "core/random_func.hpp"
 #include "core/backup_type.hpp"
+#include "core/smallvec_type.hpp"
 #include "depot_base.h"
 #include "object_map.h"
 #include "object_base.h"
 #include "ai/ai.hpp"
 #include "game/game.hpp"
+#include "spatial_index.h"
+#include "benchmark.h"
 
 #include "table/strings.h"
 #include "table/town_land.h"
@@ -66,6 +69,8 @@ Town::~Town()
 
 	if (CleaningPool()) return;
 
+	_town_spatial_index.Remove(this->index, TileArea(this->xy, 1, 1));
+
 	/* Delete town authority window
 	 * and remove from list of sorted towns */
 	DeleteWindowById(WC_TOWN_VIEW, this->index);
@@ -695,6 +700,9 @@ static void ChangeTileOwner_Town(TileIndex tile, Owner old_owner, Owner new_owne
 	/* not used */
 }
 
+/** Callbacks that make the acceptance or production of a house variable. */
+static const uint16 HOUSE_CARGO_CALLBACK_MASK = 1 << CBM_HOUSE_CARGO_ACCEPTANCE | 1 << CBM_HOUSE_ACCEPT_CARGO | 1 << CBM_HOUSE_PRODUCE_CARGO;
+
 /** Update the total cargo acceptance of the whole town.
  * @param t The town to update.
  */
@@ -703,44 +711,136 @@ void UpdateTownCargoTotal(Town *t)
 	t->cargo_accepted_total = 0;
 
 	const TileArea &area = t->cargo_accepted.GetArea();
-	TILE_AREA_LOOP(tile, area) {
-		if (TileX(tile) % AcceptanceMatrix::GRID == 0 && TileY(tile) % AcceptanceMatrix::GRID == 0) {
-			t->cargo_accepted_total |= t->cargo_accepted[tile];
-		}
+	uint squares = area.w / AcceptanceMatrix::GRID * area.h / AcceptanceMatrix::GRID;
+	for (uint i = 0; i < squares; i++) {
+		t->cargo_accepted_total |= t->cargo_accepted.data[i];
+	}
+}
+
+/**
+ * Update the bitmap of all cargoes produced by the houses of a town.
+ * @param t The town to update.
+ */
+static void UpdateTownCargoProduced(Town *t)
+{
+	t->cargo_produced = 0;
+
+	const TileArea &area = t->cargo_squares.GetArea();
+	uint squares = area.w / TownCargoMatrix::GRID * area.h / TownCargoMatrix::GRID;
+	for (uint i = 0; i < squares; i++) {
+		t->cargo_produced |= t->cargo_squares.data[i].produced;
 	}
 }
 
 /**
- * Update accepted town cargoes around a specific tile.
+ * Recount the acceptance and production of the houses of a town in a single square.
  * @param t The town to update.
- * @param start Update the values around this tile.
- * @param update_total Set to true if the total cargo acceptance should be updated.
+ * @param square A tile in the square to recount.
  */
-static void UpdateTownCargoes(Town *t, TileIndex start, bool update_total = true)
+static void UpdateTownCargoSquare(Town *t, TileIndex square)
 {
 	CargoArray accepted, produced;
 	uint32 dummy;
+	bool has_houses = false;
+	bool callback = false;
 
-	/* Gather acceptance for all houses in an area around the start tile.
-	 * The area is composed of the square the tile is in, extended one square in all
-	 * directions as the coverage area of a single station is bigger than just one square. */
-	TileArea area = AcceptanceMatrix::GetAreaForTile(start, 1);
+	TileArea area = AcceptanceMatrix::GetAreaForTile(square);
 	TILE_AREA_LOOP(tile, area) {
 		if (!IsTileType(tile, MP_HOUSE) || GetTownIndex(tile) != t->index) continue;
 
 		AddAcceptedCargo_Town(tile, accepted, &dummy);
 		AddProducedCargo_Town(tile, produced);
+		has_houses = true;
+		if ((HouseSpec::Get(GetHouseType(tile))->callback_mask & HOUSE_CARGO_CALLBACK_MASK) != 0) callback = true;
+	}
+
+	/* Don't extend the matrix for squares without any houses. */
+	if (!has_houses && !t->cargo_squares.GetArea().Contains(square)) return;
+
+	TownCargoSquare &sq = t->cargo_squares[square];
+	sq.produced = 0;
+	for (uint cid = 0; cid < NUM_CARGO; cid++) {
+		sq.accepted[cid] = accepted[cid];
+		if (produced[cid] > 0) SetBit(sq.produced, cid);
+	}
+	sq.callback = callback;
+}
+
+/**
+ * Update the accepted town cargoes of a square from the recounted squares around it.
+ * The area is composed of the square itself, extended one square in all
+ * directions as the coverage area of a single station is bigger than just one square.
+ * @param t The town to update.
+ * @param square A tile in the square to update.
+ */
+static void UpdateTownCargoAcceptance(Town *t, TileIndex square)
+{
+	CargoArray accepted;
+
+	const TileArea &counted = t->cargo_squares.GetArea();
+	TileArea area = AcceptanceMatrix::GetAreaForTile(square, 1);
+	for (uint y = 0; y < area.h; y += AcceptanceMatrix::GRID) {
+		for (uint x = 0; x < area.w; x += AcceptanceMatrix::GRID) {
+			TileIndex tile = TILE_ADDXY(area.tile, x, y);
+			if (!counted.Contains(tile)) continue;
+
+			const TownCargoSquare &sq = t->cargo_squares[tile];
+			for (uint cid = 0; cid < NUM_CARGO; cid++) accepted[cid] += sq.accepted[cid];
+		}
 	}
 
-	/* Create bitmap of produced and accepted cargoes. */
+	/* Create bitmap of accepted cargoes. */
 	uint32 acc = 0;
 	for (uint cid = 0; cid < NUM_CARGO; cid++) {
 		if (accepted[cid] >= 8) SetBit(acc, cid);
-		if (produced[cid] > 0) SetBit(t->cargo_produced, cid);
 	}
-	t->cargo_accepted[start] = acc;
+	t->cargo_accepted[square] = acc;
+}
+
+/**
+ * Update the accepted town cargoes of all squares around some recounted squares.
+ * @param t The town to update.
+ * @param changed Area of the recounted squares.
+ */
+static void UpdateTownCargoAcceptanceAround(Town *t, const TileArea &changed)
+{
+	TileArea first = AcceptanceMatrix::GetAreaForTile(changed.tile, 1);
+	TileArea last = AcceptanceMatrix::GetAreaForTile(TILE_ADDXY(changed.tile, changed.w - 1, changed.h - 1), 1);
+	TileArea area(first.tile, TILE_ADDXY(last.tile, last.w - 1, last.h - 1));
+
+	const TileArea &known = t->cargo_accepted.GetArea();
+	for (uint y = 0; y < area.h; y += AcceptanceMatrix::GRID) {
+		for (uint x = 0; x < area.w; x += AcceptanceMatrix::GRID) {
+			TileIndex tile = TILE_ADDXY(area.tile, x, y);
+			if (known.Contains(tile)) UpdateTownCargoAcceptance(t, tile);
+		}
+	}
+}
+
+/**
+ * Update town cargoes after a house has been built or removed.
+ * Only the squares covered by the house are recounted, the acceptance
+ * of the squares around them is derived from the stored counts.
+ * @param t The town to update.
+ * @param house Area of the house.
+ */
+static void UpdateTownCargoes(Town *t, const TileArea &house)
+{
+	TileArea first = AcceptanceMatrix::GetAreaForTile(house.tile);
+	TileArea last = AcceptanceMatrix::GetAreaForTile(TILE_ADDXY(house.tile, house.w - 1, house.h - 1));
+	TileArea changed(first.tile, TILE_ADDXY(last.tile, last.w - 1, last.h - 1));
 
-	if (update_total) UpdateTownCargoTotal(t);
+	for (uint y = 0; y < changed.h; y += AcceptanceMatrix::GRID) {
+		for (uint x = 0; x < changed.w; x += AcceptanceMatrix::GRID) {
+			TileIndex tile = TILE_ADDXY(changed.tile, x, y);
+			UpdateTownCargoSquare(t, tile);
+			t->cargo_accepted.Add(tile);
+		}
+	}
+
+	UpdateTownCargoAcceptanceAround(t, changed);
+	UpdateTownCargoProduced(t);
+	UpdateTownCargoTotal(t);
 }
 
 /** Update cargo acceptance for the complete town.
@@ -748,19 +848,53 @@ static void UpdateTownCargoes(Town *t, TileIndex start, bool update_total = true
  */
 void UpdateTownCargoes(Town *t)
 {
-	t->cargo_produced = 0;
-
 	const TileArea &area = t->cargo_accepted.GetArea();
+	if (area.tile == INVALID_TILE) {
+		t->cargo_produced = 0;
+		t->cargo_accepted_total = 0;
+		return;
+	}
+
+	/* Recount every square that can contribute to the acceptance of the town. */
+	TileArea first = AcceptanceMatrix::GetAreaForTile(area.tile, 1);
+	TileArea last = AcceptanceMatrix::GetAreaForTile(TILE_ADDXY(area.tile, area.w - 1, area.h - 1), 1);
+	TileArea counted(first.tile, TILE_ADDXY(last.tile, last.w - 1, last.h - 1));
+	for (uint y = 0; y < counted.h; y += AcceptanceMatrix::GRID) {
+		for (uint x = 0; x < counted.w; x += AcceptanceMatrix::GRID) {
+			UpdateTownCargoSquare(t, TILE_ADDXY(counted.tile, x, y));
+		}
+	}
+
+	UpdateTownCargoAcceptanceAround(t, area);
+	UpdateTownCargoProduced(t);
+	UpdateTownCargoTotal(t);
+}
+
+/**
+ * Monthly update of town cargoes. The acceptance and production of
+ * houses can only change without the house itself changing when it is
+ * decided by a callback, so only squares with such houses are recounted.
+ * @param t The town to update.
+ */
+static void UpdateTownCargoesMonthly(Town *t)
+{
+	const TileArea &area = t->cargo_squares.GetArea();
 	if (area.tile == INVALID_TILE) return;
 
-	/* Update acceptance for each grid square. */
-	TILE_AREA_LOOP(tile, area) {
-		if (TileX(tile) % AcceptanceMatrix::GRID == 0 && TileY(tile) % AcceptanceMatrix::GRID == 0) {
-			UpdateTownCargoes(t, tile, false);
+	bool changed = false;
+	for (uint y = 0; y < area.h; y += TownCargoMatrix::GRID) {
+		for (uint x = 0; x < area.w; x += TownCargoMatrix::GRID) {
+			TileIndex tile = TILE_ADDXY(area.tile, x, y);
+			if (!t->cargo_squares[tile].callback) continue;
+
+			UpdateTownCargoSquare(t, tile);
+			UpdateTownCargoAcceptanceAround(t, AcceptanceMatrix::GetAreaForTile(tile));
+			changed = true;
 		}
 	}
+	if (!changed) return;
 
-	/* Update the total acceptance. */
+	UpdateTownCargoProduced(t);
 	UpdateTownCargoTotal(t);
 }
 
@@ -796,12 +930,10 @@ void OnTick_Town()
 {
 	if (_game_mode == GM_EDITOR) return;
 
+	/* Run town tick at regular intervals, but not all at once. */
 	Town *t;
-	FOR_ALL_TOWNS(t) {
-		/* Run town tick at regular intervals, but not all at once. */
-		if ((_tick_counter + t->index) % TOWN_GROWTH_TICKS == 0) {
-			TownTickHandler(t);
-		}
+	FOR_ALL_TOWNS_FROM_STEP(t, GetTickPhaseIndex(TOWN_GROWTH_TICKS), TOWN_GROWTH_TICKS) {
+		TownTickHandler(t);
 	}
 }
 
@@ -1560,6 +1692,7 @@ void UpdateTownMaxPass(Town *t)
 static void DoCreateTown(Town *t, TileIndex tile, uint32 townnameparts, TownSize size, bool city, TownLayout layout, bool manual)
 {
 	t->xy = tile;
+	_town_spatial_index.Add(t->index, TileArea(tile, 1, 1));
 	t->cache.num_houses = 0;
 	t->time_until_rebuild = 10;
 	UpdateTownRadius(t);
@@ -1948,6 +2081,8 @@ static const byte _num_initial_towns[4] = {5, 11, 23, 46};  // very low, low, no
  */
 bool GenerateTowns(TownLayout layout)
 {
+	BenchmarkTimer timer(BE_GENWORLD_TOWNS);
+
 	uint current_number = 0;
 	uint difficulty = (_game_mode != GM_EDITOR) ? _settings_game.difficulty.number_towns : 0;
 	uint total = (difficulty == (uint)CUSTOM_TOWN_NUMBER_DIFFICULTY) ? _settings_game.game_creation.custom_town_number : ScaleByMapSize(_num_initial_towns[difficulty] + (Random() & 7));
@@ -2239,6 +2374,59 @@ static bool CheckTownBuild2x2House(TileIndex *tile, Town *t, int maxz, bool nosl
 }
 
 
+/** Houses that are available for each climate and town zone, cached for #BuildTownHouse. */
+struct TownHouseCandidates {
+	bool valid;                                              ///< Whether the lists may be used at all.
+	Year year;                                               ///< Year the lists were made for.
+	bool historical;                                         ///< Whether historical houses are in the lists.
+	SmallVector<HouseID, 32> houses[NUM_LANDSCAPE + 1][HZB_END]; ///< Houses per landscape (0 is above the snow line) and town zone.
+};
+
+static TownHouseCandidates _town_house_candidates;
+
+/**
+ * Get the houses that may be built in a town zone. Only the checks that
+ * do not depend on the town or the tile are done for these houses.
+ * @param rad Town zone of the tile.
+ * @param land Landscape of the tile, -1 for above the snow line.
+ * @return Candidate houses in order of their ID.
+ */
+static const SmallVector<HouseID, 32> &GetTownHouseCandidates(HouseZonesBits rad, int land)
+{
+	TownHouseCandidates &cache = _town_house_candidates;
+	bool historical = !_loaded_newgrf_features.has_newhouses || _generating_world || _game_mode == GM_EDITOR;
+
+	if (!cache.valid || cache.year != _cur_year || cache.historical != historical) {
+		for (int l = 0; l <= NUM_LANDSCAPE; l++) {
+			for (uint z = HZB_BEGIN; z < HZB_END; z++) {
+				/* bits 0-4 are used
+				 * bits 11-15 are used
+				 * bits 5-10 are not used. */
+				uint bitmask = (1 << z) + (1 << (l - 1 + 12));
+				SmallVector<HouseID, 32> &houses = cache.houses[l][z];
+				houses.Clear();
+
+				for (uint i = 0; i < NUM_HOUSES; i++) {
+					const HouseSpec *hs = HouseSpec::Get(i);
+
+					/* Verify that the candidate house spec matches the zone and climate */
+					if ((~hs->building_availability & bitmask) != 0 || !hs->enabled || hs->grf_prop.override != INVALID_HOUSE_ID) continue;
+					if (!historical && (hs->extra_flags & BUILDING_IS_HISTORICAL) != 0) continue;
+					if (_cur_year < hs->min_year || _cur_year > hs->max_year) continue;
+
+					*houses.Append() = (HouseID)i;
+				}
+			}
+		}
+
+		cache.valid = true;
+		cache.year = _cur_year;
+		cache.historical = historical;
+	}
+
+	return cache.houses[land + 1][rad];
+}
+
 /**
  * Tries to build a house at this tile
  * @param t town the house will belong to
@@ -2264,23 +2452,17 @@ static bool BuildTownHouse(Town *t, TileIndex tile)
 	int land = _settings_game.game_creation.landscape;
 	if (land == LT_ARCTIC && maxz > HighestSnowLine()) land = -1;
 
-	uint bitmask = (1 << rad) + (1 << (land + 12));
-
-	/* bits 0-4 are used
-	 * bits 11-15 are used
-	 * bits 5-10 are not used. */
 	HouseID houses[NUM_HOUSES];
 	uint num = 0;
 	uint probs[NUM_HOUSES];
 	uint probability_max = 0;
 
 	/* Generate a list of all possible houses that can be built. */
-	for (uint i = 0; i < NUM_HOUSES; i++) {
+	const SmallVector<HouseID, 32> &candidates = GetTownHouseCandidates(rad, land);
+	for (const HouseID *it = candidates.Begin(); it != candidates.End(); it++) {
+		HouseID i = *it;
 		const HouseSpec *hs = HouseSpec::Get(i);
 
-		/* Verify that the candidate house spec matches the current tile status */
-		if ((~hs->building_availability & bitmask) != 0 || !hs->enabled || hs->grf_prop.override != INVALID_HOUSE_ID) continue;
-
 		/* Don't let these counters overflow. Global counters are 32bit, there will never be that many houses. */
 		if (hs->class_id != HOUSE_NO_CLASS) {
 			/* id_count is always <= class_count, so it doesn't need to be checked */
@@ -2294,7 +2476,7 @@ static bool BuildTownHouse(Town *t, TileIndex tile)
 		uint cur_prob = (_loaded_newgrf_features.has_newhouses ? hs->probability : 1);
 		probability_max += cur_prob;
 		probs[num] = cur_prob;
-		houses[num++] = (HouseID)i;
+		houses[num++] = i;
 	}
 
 	TileIndex baseTile = tile;
@@ -2324,13 +2506,6 @@ static bool BuildTownHouse(Town *t, TileIndex tile)
 
 		const HouseSpec *hs = HouseSpec::Get(house);
 
-		if (_loaded_newgrf_features.has_newhouses && !_generating_world &&
-				_game_mode != GM_EDITOR && (hs->extra_flags & BUILDING_IS_HISTORICAL) != 0) {
-			continue;
-		}
-
-		if (_cur_year < hs->min_year || _cur_year > hs->max_year) continue;
-
 		/* Special houses that there can be only one of. */
 		uint oneof = 0;
 
@@ -2387,7 +2562,7 @@ static bool BuildTownHouse(Town *t, TileIndex tile)
 
 		MakeTownHouse(tile, t, construction_counter, construction_stage, house, random_bits);
 		UpdateTownRadius(t);
-		UpdateTownCargoes(t, tile);
+		UpdateTownCargoes(t, TileArea(tile, (hs->building_flags & BUILDING_2_TILES_X) ? 2 : 1, (hs->building_flags & BUILDING_2_TILES_Y) ? 2 : 1));
 
 		return true;
 	}
@@ -2473,7 +2648,7 @@ void ClearTownHouse(Town *t, TileIndex tile)
 	UpdateTownRadius(t);
 
 	/* Update cargo acceptance. */
-	UpdateTownCargoes(t, tile);
+	UpdateTownCargoes(t, TileArea(tile, (eflags & BUILDING_2_TILES_X) ? 2 : 1, (eflags & BUILDING_2_TILES_Y) ? 2 : 1));
 }
 
 /**
@@ -3219,19 +3394,8 @@ CommandCost CheckIfAuthorityAllowsNewStation(TileIndex tile, DoCommandFlag flags
  */
 Town *CalcClosestTownFromTile(TileIndex tile, uint threshold)
 {
-	Town *t;
-	uint best = threshold;
-	Town *best_town = NULL;
-
-	FOR_ALL_TOWNS(t) {
-		uint dist = DistanceManhattan(tile, t->xy);
-		if (dist < best) {
-			best = dist;
-			best_town = t;
-		}
-	}
-
-	return best_town;
+	TownID best_town = _town_spatial_index.FindNearest(tile, threshold);
+	return best_town == SpatialIndex::INVALID_ITEM ? NULL : Town::Get(best_town);
 }
 
 /**
@@ -3403,7 +3567,7 @@ void TownsMonthlyLoop()
 		UpdateTownRating(t);
 		UpdateTownGrowRate(t);
 		UpdateTownUnwanted(t);
-		UpdateTownCargoes(t);
+		UpdateTownCargoesMonthly(t);
 	}
 
 	UpdateTownCargoBitmap();
@@ -3474,4 +3638,6 @@ void ResetHouses()
 
 	/* Reset any overrides that have been set. */
 	_house_mngr.ResetOverride();
+
+	_town_house_candidates.valid = false;
 }
@@ -35,6 +35,7 @@
 #include "order_backup.h"
 #include "zoom_func.h"
 #include "newgrf_debug.h"
+#include "benchmark.h"
 
 #include "table/strings.h"
 #include "table/train_cmd.h"
@@ -255,6 +256,7 @@ void Train::ConsistChanged(ConsistChangeFlags allowed_changes)
 	this->tcache.cached_max_curve_speed = this->GetCurveSpeedLimit();
 
 	/* recalculate cached weights and power too (we do this *after* the rest, so it is known which wagons are powered and need extra weight added) */
+	this->gcache.cached_fixed_properties = false;
 	this->CargoChanged();
 
 	if (this->IsFrontEngine()) {
@@ -2260,6 +2262,7 @@ static void ClearPathReservation(const Train *v, TileIndex tile, Trackdir track_
 void FreeTrainTrackReservation(const Train *v, TileIndex origin, Trackdir orig_td)
 {
 	assert(v->IsFrontEngine());
+	BenchmarkTimer timer(BE_PBS);
 
 	TileIndex tile = origin != INVALID_TILE ? origin : v->tile;
 	Trackdir  td = orig_td != INVALID_TRACKDIR ? orig_td : v->GetVehicleTrackdir();
@@ -2697,6 +2700,7 @@ static Track ChooseTrainTrack(Train *v, TileIndex tile, DiagDirection enterdir,
 bool TryPathReserve(Train *v, bool mark_as_stuck, bool first_tile_okay)
 {
 	assert(v->IsFrontEngine());
+	BenchmarkTimer timer(BE_PBS);
 
 	/* We have to handle depots specially as the track follower won't look
 	 * at the depot tile itself but starts from the next tile. If we are still
@@ -3113,6 +3117,7 @@ static Vehicle *CheckTrainAtSignal(Vehicle *v, void *data)
  */
 bool TrainController(Train *v, Vehicle *nomove, bool reverse)
 {
+	BenchmarkTimer timer(BE_TRAIN_CONTROLLER);
 	Train *first = v->First();
 	Train *prev;
 	bool direction_changed = false; // has direction of any part changed?
@@ -3303,7 +3308,14 @@ bool TrainController(Train *v, Vehicle *nomove, bool reverse)
 					v->tile = gp.new_tile;
 
 					if (GetTileRailType(gp.new_tile) != GetTileRailType(gp.old_tile)) {
-						v->First()->ConsistChanged(CCF_TRACK);
+						Train *first = v->First();
+						if (first->gcache.cached_fixed_properties) {
+							/* Only the power and track speed of this part can have changed. */
+							first->PartPowerChanged(v);
+							first->UpdateAcceleration();
+						} else {
+							first->ConsistChanged(CCF_TRACK);
+						}
 					}
 
 					v->track = chosen_track;
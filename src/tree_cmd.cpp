@@ -24,6 +24,7 @@
 #include "company_base.h"
 #include "core/random_func.hpp"
 #include "newgrf_generic.h"
+#include "benchmark.h"
 
 #include "table/strings.h"
 #include "table/tree_land.h"
@@ -299,6 +300,8 @@ void PlaceTreesRandomly()
  */
 void GenerateTrees()
 {
+	BenchmarkTimer timer(BE_GENWORLD_TREES);
+
 	uint i, total;
 
 	if (_settings_game.game_creation.tree_placer == TP_NONE) return;
@@ -598,6 +598,15 @@ static void UpdateVehicleTileHash(Vehicle *v, bool remove)
 		new_hash = &_vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
 	}
 
+	/* The signal blocks count the trains per tile, so they know when they cannot be occupied. */
+	if (v->type == VEH_TRAIN && (old_hash == NULL ? new_hash != NULL : new_hash == NULL || v->hash_tile_counted != v->tile)) {
+		if (old_hash != NULL) RemoveTrainFromSignalBlocks(v->hash_tile_counted);
+		if (new_hash != NULL) {
+			v->hash_tile_counted = v->tile;
+			AddTrainToSignalBlocks(v->tile);
+		}
+	}
+
 	if (old_hash == new_hash) return;
 
 	/* Remove from the old position in the hash table */
@@ -652,6 +661,7 @@ void ResetVehicleHash()
 	FOR_ALL_VEHICLES(v) { v->hash_tile_current = NULL; }
 	memset(_vehicle_viewport_hash, 0, sizeof(_vehicle_viewport_hash));
 	memset(_vehicle_tile_hash, 0, sizeof(_vehicle_tile_hash));
+	ResetSignalBlocks();
 }
 
 void ResetVehicleColourMap()
@@ -920,6 +930,8 @@ void CallVehicleTicks()
 {
 	_vehicles_to_autoreplace.Clear();
 
+	StartNewGRFTickCallbackCache();
+
 	RunVehicleDayProc();
 
 	Station *st;
@@ -995,6 +1007,8 @@ void CallVehicleTicks()
 		}
 	}
 
+	StopNewGRFCallbackCache();
+
 	Backup<CompanyByte> cur_company(_current_company, FILE_LINE);
 	for (AutoreplaceMap::iterator it = _vehicles_to_autoreplace.Begin(); it != _vehicles_to_autoreplace.End(); it++) {
 		v = it->first;
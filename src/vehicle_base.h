@@ -250,6 +250,7 @@ public:
 	Vehicle *hash_tile_next;            ///< NOSAVE: Next vehicle in the tile location hash.
 	Vehicle **hash_tile_prev;           ///< NOSAVE: Previous vehicle in the tile location hash.
 	Vehicle **hash_tile_current;        ///< NOSAVE: Cache of the current hash chain.
+	TileIndex hash_tile_counted;        ///< NOSAVE: Tile at which a train in the tile location hash is counted for the signal blocks.
 
 	SpriteID colourmap;                 ///< NOSAVE: cached colour mapping
 
@@ -84,6 +84,13 @@
 #include "linkgraph/linkgraph_gui.h"
 #include "viewport_sprite_sorter.h"
 #include "bridge_map.h"
+#include "core/sort_func.hpp"
+#include "newgrf_debug.h"
+#include "spritecache.h"
+#include "settings_type.h"
+#include "thread/worker_pool.h"
+#include "progress.h"
+#include "openttd.h"
 
 #include <map>
 
@@ -167,6 +174,8 @@ struct ViewportDrawer {
 	FoundationPart foundation_part;                  ///< Currently active foundation for ground sprite drawing.
 	int *last_foundation_child[FOUNDATION_PART_END]; ///< Tail of ChildSprite list of the foundations. (index into child_screen_sprites_to_draw)
 	Point foundation_offset[FOUNDATION_PART_END];    ///< Pixel offset for ground sprites on the foundations.
+
+	bool prefetch;                                   ///< Only collect the sprites to prefetch them; their extents are unknown, so nothing is clipped.
 };
 
 static void MarkViewportDirty(const ViewPort *vp, int left, int top, int right, int bottom);
@@ -648,13 +657,15 @@ void OffsetGroundSprite(int x, int y)
 static void AddCombinedSprite(SpriteID image, PaletteID pal, int x, int y, int z, const SubSprite *sub)
 {
 	Point pt = RemapCoords(x, y, z);
-	const Sprite *spr = GetSprite(image & SPRITE_MASK, ST_NORMAL);
+	if (!_vd.prefetch) {
+		const Sprite *spr = GetSprite(image & SPRITE_MASK, ST_NORMAL);
 
-	if (pt.x + spr->x_offs >= _vd.dpi.left + _vd.dpi.width ||
-			pt.x + spr->x_offs + spr->width <= _vd.dpi.left ||
-			pt.y + spr->y_offs >= _vd.dpi.top + _vd.dpi.height ||
-			pt.y + spr->y_offs + spr->height <= _vd.dpi.top)
-		return;
+		if (pt.x + spr->x_offs >= _vd.dpi.left + _vd.dpi.width ||
+				pt.x + spr->x_offs + spr->width <= _vd.dpi.left ||
+				pt.y + spr->y_offs >= _vd.dpi.top + _vd.dpi.height ||
+				pt.y + spr->y_offs + spr->height <= _vd.dpi.top)
+			return;
+	}
 
 	const ParentSpriteToDraw *pstd = _vd.parent_sprites_to_draw.End() - 1;
 	AddChildSpriteScreen(image, pal, pt.x - pstd->left, pt.y - pstd->top, false, sub, false);
@@ -713,6 +724,12 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
 		right           = RemapCoords(x + bb_offset_x, y + h          , z + bb_offset_z).x + 1;
 		top  = tmp_top  = RemapCoords(x + bb_offset_x, y + bb_offset_y, z + dz         ).y;
 		bottom          = RemapCoords(x + w          , y + h          , z + bb_offset_z).y + 1;
+	} else if (_vd.prefetch) {
+		/* Getting the extents would load the sprite, so pretend it covers the whole area. */
+		left = tmp_left = _vd.dpi.left;
+		right           = _vd.dpi.left + _vd.dpi.width;
+		top  = tmp_top  = _vd.dpi.top;
+		bottom          = _vd.dpi.top + _vd.dpi.height;
 	} else {
 		const Sprite *spr = GetSprite(image & SPRITE_MASK, ST_NORMAL);
 		left = tmp_left = (pt.x += spr->x_offs);
@@ -1375,6 +1392,38 @@ static bool ViewportSortParentSpritesChecker()
 	return true;
 }
 
+/**
+ * Decide whether a parent sprite has to be moved in front of another one
+ * while sorting, i.e. whether it is drawn behind it.
+ * @param ps The sprite that is being sorted.
+ * @param ps2 The sprite that is compared with it and that comes after it.
+ * @return True if \a ps2 has to be drawn before \a ps.
+ */
+static inline bool ViewportParentSpriteIsBehind(const ParentSpriteToDraw *ps, const ParentSpriteToDraw *ps2)
+{
+	/* Decide which comparator to use, based on whether the bounding
+	 * boxes overlap
+	 */
+	if (ps->xmax >= ps2->xmin && ps->xmin <= ps2->xmax && // overlap in X?
+			ps->ymax >= ps2->ymin && ps->ymin <= ps2->ymax && // overlap in Y?
+			ps->zmax >= ps2->zmin && ps->zmin <= ps2->zmax) { // overlap in Z?
+		/* Use X+Y+Z as the sorting order, so sprites closer to the bottom of
+		 * the screen and with higher Z elevation, are drawn in front.
+		 * Here X,Y,Z are the coordinates of the "center of mass" of the sprite,
+		 * i.e. X=(left+right)/2, etc.
+		 * However, since we only care about order, don't actually divide / 2
+		 */
+		return ps->xmin + ps->xmax + ps->ymin + ps->ymax + ps->zmin + ps->zmax >
+				ps2->xmin + ps2->xmax + ps2->ymin + ps2->ymax + ps2->zmin + ps2->zmax;
+	}
+
+	/* We only change the order, if it is definite.
+	 * I.e. every single order of X, Y, Z says ps2 is behind ps or they overlap.
+	 * That is: If one partial order says ps behind ps2, do not change the order.
+	 */
+	return ps->xmax >= ps2->xmin && ps->ymax >= ps2->ymin && ps->zmax >= ps2->zmin;
+}
+
 /** Sort parent sprites pointer array */
 static void ViewportSortParentSprites(ParentSpriteToSortVector *psdv)
 {
@@ -1394,34 +1443,7 @@ static void ViewportSortParentSprites(ParentSpriteToSortVector *psdv)
 			ParentSpriteToDraw *ps2 = *psd2;
 
 			if (ps2->comparison_done) continue;
-
-			/* Decide which comparator to use, based on whether the bounding
-			 * boxes overlap
-			 */
-			if (ps->xmax >= ps2->xmin && ps->xmin <= ps2->xmax && // overlap in X?
-					ps->ymax >= ps2->ymin && ps->ymin <= ps2->ymax && // overlap in Y?
-					ps->zmax >= ps2->zmin && ps->zmin <= ps2->zmax) { // overlap in Z?
-				/* Use X+Y+Z as the sorting order, so sprites closer to the bottom of
-				 * the screen and with higher Z elevation, are drawn in front.
-				 * Here X,Y,Z are the coordinates of the "center of mass" of the sprite,
-				 * i.e. X=(left+right)/2, etc.
-				 * However, since we only care about order, don't actually divide / 2
-				 */
-				if (ps->xmin + ps->xmax + ps->ymin + ps->ymax + ps->zmin + ps->zmax <=
-						ps2->xmin + ps2->xmax + ps2->ymin + ps2->ymax + ps2->zmin + ps2->zmax) {
-					continue;
-				}
-			} else {
-				/* We only change the order, if it is definite.
-				 * I.e. every single order of X, Y, Z says ps2 is behind ps or they overlap.
-				 * That is: If one partial order says ps behind ps2, do not change the order.
-				 */
-				if (ps->xmax < ps2->xmin ||
-						ps->ymax < ps2->ymin ||
-						ps->zmax < ps2->zmin) {
-					continue;
-				}
-			}
+			if (!ViewportParentSpriteIsBehind(ps, ps2)) continue;
 
 			/* Move ps2 in front of ps */
 			ParentSpriteToDraw *temp = ps2;
@@ -1433,6 +1455,213 @@ static void ViewportSortParentSprites(ParentSpriteToSortVector *psdv)
 	}
 }
 
+/** The spatial sorter is always available too. */
+static bool ViewportSortParentSpritesSpatialChecker()
+{
+	return true;
+}
+
+/**
+ * Sorter of parent sprites that gives exactly the same order as
+ * #ViewportSortParentSprites, without comparing every pair of sprites.
+ *
+ * That sorter takes the first sprite that has not been handled, and moves
+ * every unhandled sprite that is behind it to the front, one after another.
+ * A sprite can only be behind another one when none of its minimal
+ * coordinates is larger than the maximal coordinate of the other sprite.
+ * The unhandled sprites are therefore kept in a segment tree over their
+ * minimal X coordinate that knows the smallest minimal Y coordinate in every
+ * subtree, so only the sprites that are behind in X and Y are looked at.
+ * The order in which they are moved is kept with a key per sprite; the
+ * moved sprites get ever smaller keys.
+ */
+class ParentSpriteSpatialSorter {
+	/** A sprite with its minimal X coordinate, to order the sprites by X. */
+	struct XEntry {
+		int32 xmin; ///< Minimal world X coordinate of the sprite.
+		uint index; ///< Index of the sprite in the array being sorted.
+	};
+
+	/** A sprite that will be moved, with its position in the sorted order. */
+	struct Candidate {
+		int key;    ///< Position of the sprite among the unhandled sprites.
+		uint index; ///< Index of the sprite in the array being sorted.
+	};
+
+	SmallVector<XEntry, 64> by_x;          ///< The sprites ordered by their minimal X coordinate.
+	SmallVector<int32, 128> tree;          ///< Smallest minimal Y coordinate of the unhandled sprites per node; node 1 is the root.
+	SmallVector<uint, 64> leaf;            ///< Leaf in #tree per sprite.
+	SmallVector<int, 64> key;              ///< Position per sprite among the unhandled sprites.
+	SmallVector<uint, 64> next;            ///< Next sprite in the current order; the last entry is the list head.
+	SmallVector<uint, 64> prev;            ///< Previous sprite in the current order; the last entry is the list head.
+	SmallVector<Candidate, 16> candidates; ///< Sprites that are behind the sprite being handled.
+	SmallVector<ParentSpriteToDraw *, 64> result; ///< The sprites in their final order.
+	uint leaves;                           ///< Number of leaves of #tree.
+
+	/** Sort the sprites by their minimal X coordinate. */
+	static int CDECL XEntrySorter(const XEntry *a, const XEntry *b)
+	{
+		return (a->xmin > b->xmin) - (a->xmin < b->xmin);
+	}
+
+	/** Sort the candidates by their position in the current order. */
+	static int CDECL CandidateSorter(const Candidate *a, const Candidate *b)
+	{
+		return a->key - b->key;
+	}
+
+	/**
+	 * Remove a sprite from the tree of unhandled sprites.
+	 * @param index The sprite to remove.
+	 */
+	void RemoveFromTree(uint index)
+	{
+		uint node = this->leaf[index];
+		this->tree[node] = INT32_MAX;
+		for (node /= 2; node > 0; node /= 2) {
+			this->tree[node] = min(this->tree[2 * node], this->tree[2 * node + 1]);
+		}
+	}
+
+	/**
+	 * Find all unhandled sprites among the first sprites ordered by X that
+	 * do not start after the given Y coordinate.
+	 * @param node The node of the tree to search.
+	 * @param first The first entry of #by_x covered by \a node.
+	 * @param count The number of entries covered by \a node.
+	 * @param end The number of entries of #by_x to search.
+	 * @param ymax The maximal minimal Y coordinate of the sprites to find.
+	 */
+	void FindBehind(uint node, uint first, uint count, uint end, int32 ymax)
+	{
+		if (first >= end || this->tree[node] > ymax) return;
+		if (count == 1) {
+			Candidate *c = this->candidates.Append();
+			c->index = this->by_x[first].index;
+			c->key = this->key[c->index];
+			return;
+		}
+		this->FindBehind(2 * node, first, count / 2, end, ymax);
+		this->FindBehind(2 * node + 1, first + count / 2, count / 2, end, ymax);
+	}
+
+	/**
+	 * Move a sprite in the current order.
+	 * @param index The sprite to move.
+	 * @param before The sprite to put it in front of.
+	 */
+	void MoveBefore(uint index, uint before)
+	{
+		uint *next = this->next.Begin();
+		uint *prev = this->prev.Begin();
+
+		next[prev[index]] = next[index];
+		prev[next[index]] = prev[index];
+
+		next[index] = before;
+		prev[index] = prev[before];
+		next[prev[before]] = index;
+		prev[before] = index;
+	}
+
+public:
+	/**
+	 * Sort the parent sprites.
+	 * @param psdv The sprites to sort.
+	 */
+	void Sort(ParentSpriteToSortVector *psdv)
+	{
+		const uint n = psdv->Length();
+		if (n == 0) return;
+		ParentSpriteToDraw **psd = psdv->Begin();
+
+		this->by_x.Clear();
+		for (uint i = 0; i < n; i++) {
+			XEntry *e = this->by_x.Append();
+			e->xmin = psd[i]->xmin;
+			e->index = i;
+		}
+		QSortT(this->by_x.Begin(), n, &XEntrySorter);
+
+		for (this->leaves = 1; this->leaves < n; this->leaves *= 2) {}
+		this->tree.Clear();
+		this->tree.Append(2 * this->leaves);
+		for (uint i = 0; i < 2 * this->leaves; i++) this->tree[i] = INT32_MAX;
+
+		this->leaf.Clear();
+		this->leaf.Append(n);
+		for (uint i = 0; i < n; i++) {
+			uint index = this->by_x[i].index;
+			this->leaf[index] = this->leaves + i;
+			this->tree[this->leaves + i] = psd[index]->comparison_done ? INT32_MAX : psd[index]->ymin;
+		}
+		for (uint node = this->leaves - 1; node > 0; node--) {
+			this->tree[node] = min(this->tree[2 * node], this->tree[2 * node + 1]);
+		}
+
+		/* The sprites in their current order, as list that ends and starts at entry n. */
+		this->key.Clear();
+		this->key.Append(n);
+		this->next.Clear();
+		this->next.Append(n + 1);
+		this->prev.Clear();
+		this->prev.Append(n + 1);
+		for (uint i = 0; i <= n; i++) {
+			if (i < n) this->key[i] = i;
+			this->next[i] = (i + 1) % (n + 1);
+			this->prev[(i + 1) % (n + 1)] = i;
+		}
+		int front_key = 0;
+
+		this->result.Clear();
+		uint cur = this->next[n];
+		while (cur != n) {
+			ParentSpriteToDraw *ps = psd[cur];
+
+			if (ps->comparison_done) {
+				*this->result.Append() = ps;
+				cur = this->next[cur];
+				continue;
+			}
+
+			ps->comparison_done = true;
+			this->RemoveFromTree(cur);
+
+			/* Find the sprites that are behind in X and Y, and keep those that are really behind. */
+			uint end = 0;
+			for (uint count = this->leaves; count > 0; count /= 2) {
+				if (end + count <= n && this->by_x[end + count - 1].xmin <= ps->xmax) end += count;
+			}
+			this->candidates.Clear();
+			this->FindBehind(1, 0, this->leaves, end, ps->ymax);
+
+			uint kept = 0;
+			for (uint i = 0; i < this->candidates.Length(); i++) {
+				if (ViewportParentSpriteIsBehind(ps, psd[this->candidates[i].index])) this->candidates[kept++] = this->candidates[i];
+			}
+			if (kept == 0) continue;
+
+			/* Move them to the front in their current order, so the last one ends up first. */
+			QSortT(this->candidates.Begin(), kept, &CandidateSorter);
+			for (uint i = 0; i < kept; i++) {
+				uint index = this->candidates[i].index;
+				this->MoveBefore(index, cur);
+				this->key[index] = --front_key;
+				cur = index;
+			}
+		}
+
+		MemCpyT(psd, this->result.Begin(), n);
+	}
+};
+
+/** Sort parent sprites pointer array, using a spatial index to only compare sprites that can be behind each other. */
+static void ViewportSortParentSpritesSpatial(ParentSpriteToSortVector *psdv)
+{
+	static ParentSpriteSpatialSorter sorter;
+	sorter.Sort(psdv);
+}
+
 static void ViewportDrawParentSprites(const ParentSpriteToSortVector *psd, const ChildScreenSpriteToDrawVector *csstdv)
 {
 	const ParentSpriteToDraw * const *psd_end = psd->End();
@@ -1492,10 +1721,15 @@ static void ViewportDrawDirtyBlocks()
 	} while (--bottom > 0);
 }
 
-static void ViewportDrawStrings(ZoomLevel zoom, const StringSpriteToDrawVector *sstdv)
+/**
+ * Draw the strings of a part of a viewport.
+ * @param zoom  Zoom level of the viewport.
+ * @param begin First string to draw.
+ * @param end   End of the strings to draw.
+ */
+static void ViewportDrawStrings(ZoomLevel zoom, const StringSpriteToDraw *begin, const StringSpriteToDraw *end)
 {
-	const StringSpriteToDraw *ssend = sstdv->End();
-	for (const StringSpriteToDraw *ss = sstdv->Begin(); ss != ssend; ++ss) {
+	for (const StringSpriteToDraw *ss = begin; ss != end; ++ss) {
 		TextColour colour = TC_BLACK;
 		bool small = HasBit(ss->width, 15);
 		int w = GB(ss->width, 0, 15);
@@ -1529,6 +1763,139 @@ static void ViewportDrawStrings(ZoomLevel zoom, const StringSpriteToDrawVector *
 	}
 }
 
+/**
+ * Draw the link graph overlay and the strings of a part of a viewport, on top of its sprites.
+ * @param vp    The viewport.
+ * @param dpi   Where the sprites of the part of the viewport were drawn.
+ * @param x     Left coordinate of the part on the screen.
+ * @param y     Top coordinate of the part on the screen.
+ * @param begin First string to draw.
+ * @param end   End of the strings to draw.
+ */
+static void ViewportDrawOverlayAndStrings(const ViewPort *vp, const DrawPixelInfo *dpi, int x, int y, const StringSpriteToDraw *begin, const StringSpriteToDraw *end)
+{
+	DrawPixelInfo *old_dpi = _cur_dpi;
+
+	DrawPixelInfo dp = *dpi;
+	ZoomLevel zoom = dpi->zoom;
+	dp.zoom = ZOOM_LVL_NORMAL;
+	dp.width = UnScaleByZoom(dp.width, zoom);
+	dp.height = UnScaleByZoom(dp.height, zoom);
+	_cur_dpi = &dp;
+
+	if (vp->overlay != NULL && vp->overlay->GetCargoMask() != 0 && vp->overlay->GetCompanyMask() != 0) {
+		/* translate to window coordinates */
+		dp.left = x;
+		dp.top = y;
+		vp->overlay->Draw(&dp);
+	}
+
+	if (begin != end) {
+		/* translate to world coordinates */
+		dp.left = UnScaleByZoom(dpi->left, zoom);
+		dp.top = UnScaleByZoom(dpi->top, zoom);
+		ViewportDrawStrings(zoom, begin, end);
+	}
+
+	_cur_dpi = old_dpi;
+}
+
+/** A sprite of a part of a viewport, to be drawn after all parts have been collected. */
+struct DeferredViewportSprite {
+	SpriteID image;          ///< The sprite.
+	PaletteID pal;           ///< Its palette.
+	const SubSprite *sub;    ///< Only draw a rectangular part of the sprite.
+	int x;                   ///< Left coordinate in the viewport, scaled by zoom.
+	int y;                   ///< Top coordinate in the viewport, scaled by zoom.
+	ResolvedSprite resolved; ///< The sprite as looked up in the sprite cache.
+};
+
+/** A part of a viewport whose sprites are drawn after all parts have been collected. */
+struct DeferredViewportTile {
+	DrawPixelInfo dpi; ///< Where to draw the sprites of the part.
+	int x;             ///< Left coordinate of the part on the screen.
+	int y;             ///< Top coordinate of the part on the screen.
+	uint first_sprite; ///< Index of the first sprite of the part.
+	uint end_sprite;   ///< Index after the last sprite of the part.
+	uint first_string; ///< Index of the first string of the part.
+	uint end_string;   ///< Index after the last string of the part.
+};
+
+/**
+ * The parts of a viewport that are collected and sorted one by one, but
+ * whose sprites are blitted by multiple threads at once. The parts do not
+ * overlap on the screen, so the threads never write to the same pixels.
+ */
+struct DeferredViewportDrawer {
+	bool active;                                         ///< Whether #ViewportDoDraw should defer drawing.
+	SmallVector<DeferredViewportTile, 16> tiles;         ///< The collected parts.
+	SmallVector<DeferredViewportSprite, 256> sprites;    ///< The sprites of all parts, in drawing order.
+	SmallVector<StringSpriteToDraw, 16> strings;         ///< The strings of all parts.
+};
+
+static DeferredViewportDrawer _vd_deferred;
+static WorkerPool _viewport_workers("ottd:viewport"); ///< Threads helping with blitting the viewports.
+
+/**
+ * Add a sprite to the deferred sprites of the current part of the viewport.
+ * @param image The sprite.
+ * @param pal   Its palette.
+ * @param x     Left coordinate in the viewport, scaled by zoom.
+ * @param y     Top coordinate in the viewport, scaled by zoom.
+ * @param sub   Only draw a rectangular part of the sprite.
+ */
+static void ViewportDeferSprite(SpriteID image, PaletteID pal, int x, int y, const SubSprite *sub)
+{
+	DeferredViewportSprite *ds = _vd_deferred.sprites.Append();
+	ds->image = image;
+	ds->pal = pal;
+	ds->sub = sub;
+	ds->x = x;
+	ds->y = y;
+}
+
+/**
+ * Store the sorted sprites and the strings of the part of the viewport
+ * that was just collected, in the order they have to be drawn.
+ * @param x Left coordinate of the part on the screen.
+ * @param y Top coordinate of the part on the screen.
+ */
+static void ViewportDeferTile(int x, int y)
+{
+	DeferredViewportTile *t = _vd_deferred.tiles.Append();
+	t->dpi = _vd.dpi;
+	t->x = x;
+	t->y = y;
+	t->first_sprite = _vd_deferred.sprites.Length();
+	t->first_string = _vd_deferred.strings.Length();
+
+	const TileSpriteToDraw *tsend = _vd.tile_sprites_to_draw.End();
+	for (const TileSpriteToDraw *ts = _vd.tile_sprites_to_draw.Begin(); ts != tsend; ++ts) {
+		ViewportDeferSprite(ts->image, ts->pal, ts->x, ts->y, ts->sub);
+	}
+
+	const ParentSpriteToDraw * const *psd_end = _vd.parent_sprites_to_sort.End();
+	for (const ParentSpriteToDraw * const *it = _vd.parent_sprites_to_sort.Begin(); it != psd_end; it++) {
+		const ParentSpriteToDraw *ps = *it;
+		if (ps->image != SPR_EMPTY_BOUNDING_BOX) ViewportDeferSprite(ps->image, ps->pal, ps->x, ps->y, ps->sub);
+
+		int child_idx = ps->first_child;
+		while (child_idx >= 0) {
+			const ChildScreenSpriteToDraw *cs = _vd.child_screen_sprites_to_draw.Get(child_idx);
+			child_idx = cs->next;
+			ViewportDeferSprite(cs->image, cs->pal, ps->left + cs->x, ps->top + cs->y, cs->sub);
+		}
+	}
+
+	const StringSpriteToDraw *ssend = _vd.string_sprites_to_draw.End();
+	for (const StringSpriteToDraw *ss = _vd.string_sprites_to_draw.Begin(); ss != ssend; ++ss) {
+		*_vd_deferred.strings.Append() = *ss;
+	}
+
+	t->end_sprite = _vd_deferred.sprites.Length();
+	t->end_string = _vd_deferred.strings.Length();
+}
+
 void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom)
 {
 	DrawPixelInfo *old_dpi = _cur_dpi;
@@ -1560,38 +1927,23 @@ void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom
 
 	DrawTextEffects(&_vd.dpi);
 
-	if (_vd.tile_sprites_to_draw.Length() != 0) ViewportDrawTileSprites(&_vd.tile_sprites_to_draw);
-
 	ParentSpriteToDraw *psd_end = _vd.parent_sprites_to_draw.End();
 	for (ParentSpriteToDraw *it = _vd.parent_sprites_to_draw.Begin(); it != psd_end; it++) {
 		*_vd.parent_sprites_to_sort.Append() = it;
 	}
 
 	_vp_sprite_sorter(&_vd.parent_sprites_to_sort);
-	ViewportDrawParentSprites(&_vd.parent_sprites_to_sort, &_vd.child_screen_sprites_to_draw);
-
-	if (_draw_bounding_boxes) ViewportDrawBoundingBoxes(&_vd.parent_sprites_to_sort);
-	if (_draw_dirty_blocks) ViewportDrawDirtyBlocks();
 
-	DrawPixelInfo dp = _vd.dpi;
-	ZoomLevel zoom = _vd.dpi.zoom;
-	dp.zoom = ZOOM_LVL_NORMAL;
-	dp.width = UnScaleByZoom(dp.width, zoom);
-	dp.height = UnScaleByZoom(dp.height, zoom);
-	_cur_dpi = &dp;
+	if (_vd_deferred.active) {
+		ViewportDeferTile(x, y);
+	} else {
+		if (_vd.tile_sprites_to_draw.Length() != 0) ViewportDrawTileSprites(&_vd.tile_sprites_to_draw);
+		ViewportDrawParentSprites(&_vd.parent_sprites_to_sort, &_vd.child_screen_sprites_to_draw);
 
-	if (vp->overlay != NULL && vp->overlay->GetCargoMask() != 0 && vp->overlay->GetCompanyMask() != 0) {
-		/* translate to window coordinates */
-		dp.left = x;
-		dp.top = y;
-		vp->overlay->Draw(&dp);
-	}
+		if (_draw_bounding_boxes) ViewportDrawBoundingBoxes(&_vd.parent_sprites_to_sort);
+		if (_draw_dirty_blocks) ViewportDrawDirtyBlocks();
 
-	if (_vd.string_sprites_to_draw.Length() != 0) {
-		/* translate to world coordinates */
-		dp.left = UnScaleByZoom(_vd.dpi.left, zoom);
-		dp.top = UnScaleByZoom(_vd.dpi.top, zoom);
-		ViewportDrawStrings(zoom, &_vd.string_sprites_to_draw);
+		ViewportDrawOverlayAndStrings(vp, &_vd.dpi, x, y, _vd.string_sprites_to_draw.Begin(), _vd.string_sprites_to_draw.End());
 	}
 
 	_cur_dpi = old_dpi;
@@ -1603,21 +1955,101 @@ void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom
 	_vd.child_screen_sprites_to_draw.Clear();
 }
 
+/**
+ * Blit the sprites of one deferred part of the viewport.
+ * @param param Unused.
+ * @param job   The index of the part.
+ */
+static void ViewportDrawDeferredTileJob(void *param, uint job)
+{
+	const DeferredViewportTile *t = _vd_deferred.tiles.Get(job);
+	const DeferredViewportSprite *end = _vd_deferred.sprites.Get(t->end_sprite);
+	for (const DeferredViewportSprite *ds = _vd_deferred.sprites.Get(t->first_sprite); ds != end; ds++) {
+		DrawResolvedSpriteViewport(&t->dpi, &ds->resolved, ds->x, ds->y, ds->sub);
+	}
+}
+
+/**
+ * Start collecting the parts of a viewport that #ViewportDoDraw draws, so
+ * their sprites can be blitted by multiple threads at once. The debugging
+ * aids draw directly on the screen and the sprite picker collects the
+ * sprites while drawing, so those always draw on a single thread.
+ * @return Whether drawing is deferred; when there are no threads to blit
+ *         with, #ViewportDoDraw keeps drawing directly.
+ */
+bool ViewportStartDeferredDraw()
+{
+	_viewport_workers.SetThreads(_settings_client.gui.viewport_threads);
+	if (_viewport_workers.GetThreads() == 0 || _draw_bounding_boxes || _draw_dirty_blocks || _newgrf_debug_sprite_picker.mode == SPM_REDRAW) return false;
+
+	_vd_deferred.active = true;
+	return true;
+}
+
+/**
+ * Draw all parts of a viewport collected since #ViewportStartDeferredDraw.
+ * The sprites are looked up in the sprite cache first, so the worker
+ * threads do not need to touch it. When looking them up moves sprites that
+ * were looked up earlier, the sprites do not all fit in the cache at once
+ * and are drawn one by one instead. The overlay and the strings are drawn
+ * afterwards, on the main thread.
+ * @param vp The viewport.
+ */
+void ViewportFinishDeferredDraw(const ViewPort *vp)
+{
+	if (!_vd_deferred.active) return;
+	_vd_deferred.active = false;
+
+	bool resolved = false;
+	for (int attempt = 0; attempt < 2 && !resolved; attempt++) {
+		uint generation = GetSpriteCacheGeneration();
+		const DeferredViewportSprite *end = _vd_deferred.sprites.End();
+		for (DeferredViewportSprite *ds = _vd_deferred.sprites.Begin(); ds != end; ds++) {
+			ResolveSpriteViewport(ds->image, ds->pal, &ds->resolved);
+		}
+		resolved = generation == GetSpriteCacheGeneration();
+	}
+
+	if (resolved) {
+		_viewport_workers.Run(&ViewportDrawDeferredTileJob, NULL, _vd_deferred.tiles.Length());
+	} else {
+		DrawPixelInfo *old_dpi = _cur_dpi;
+		for (DeferredViewportTile *t = _vd_deferred.tiles.Begin(); t != _vd_deferred.tiles.End(); t++) {
+			_cur_dpi = &t->dpi;
+			const DeferredViewportSprite *end = _vd_deferred.sprites.Get(t->end_sprite);
+			for (const DeferredViewportSprite *ds = _vd_deferred.sprites.Get(t->first_sprite); ds != end; ds++) {
+				DrawSpriteViewport(ds->image, ds->pal, ds->x, ds->y, ds->sub);
+			}
+		}
+		_cur_dpi = old_dpi;
+	}
+
+	for (const DeferredViewportTile *t = _vd_deferred.tiles.Begin(); t != _vd_deferred.tiles.End(); t++) {
+		ViewportDrawOverlayAndStrings(vp, &t->dpi, t->x, t->y, _vd_deferred.strings.Get(t->first_string), _vd_deferred.strings.Get(t->end_string));
+	}
+
+	_vd_deferred.tiles.Clear();
+	_vd_deferred.sprites.Clear();
+	_vd_deferred.strings.Clear();
+}
+
 /**
  * Make sure we don't draw a too big area at a time.
  * If we do, the sprite memory will overflow.
+ * @param max_screen_area Also split parts that cover more pixels on the screen than this.
  */
-static void ViewportDrawChk(const ViewPort *vp, int left, int top, int right, int bottom)
+static void ViewportDrawChk(const ViewPort *vp, int left, int top, int right, int bottom, int max_screen_area)
 {
-	if (ScaleByZoom(bottom - top, vp->zoom) * ScaleByZoom(right - left, vp->zoom) > 180000 * ZOOM_LVL_BASE * ZOOM_LVL_BASE) {
+	if (ScaleByZoom(bottom - top, vp->zoom) * ScaleByZoom(right - left, vp->zoom) > 180000 * ZOOM_LVL_BASE * ZOOM_LVL_BASE ||
+			(bottom - top) * (right - left) > max_screen_area) {
 		if ((bottom - top) > (right - left)) {
 			int t = (top + bottom) >> 1;
-			ViewportDrawChk(vp, left, top, right, t);
-			ViewportDrawChk(vp, left, t, right, bottom);
+			ViewportDrawChk(vp, left, top, right, t, max_screen_area);
+			ViewportDrawChk(vp, left, t, right, bottom, max_screen_area);
 		} else {
 			int t = (left + right) >> 1;
-			ViewportDrawChk(vp, left, top, t, bottom);
-			ViewportDrawChk(vp, t, top, right, bottom);
+			ViewportDrawChk(vp, left, top, t, bottom, max_screen_area);
+			ViewportDrawChk(vp, t, top, right, bottom, max_screen_area);
 		}
 	} else {
 		ViewportDoDraw(vp,
@@ -1629,6 +2061,9 @@ static void ViewportDrawChk(const ViewPort *vp, int left, int top, int right, in
 	}
 }
 
+/** Smallest part of the screen that is blitted by a single thread, in pixels. */
+static const int MIN_VIEWPORT_THREAD_AREA = 128 * 128;
+
 static inline void ViewportDraw(const ViewPort *vp, int left, int top, int right, int bottom)
 {
 	if (right <= vp->left || bottom <= vp->top) return;
@@ -1643,7 +2078,171 @@ static inline void ViewportDraw(const ViewPort *vp, int left, int top, int right
 	if (top < vp->top) top = vp->top;
 	if (bottom > vp->top + vp->height) bottom = vp->top + vp->height;
 
-	ViewportDrawChk(vp, left, top, right, bottom);
+	int area = (bottom - top) * (right - left);
+	if (area < 2 * MIN_VIEWPORT_THREAD_AREA || !ViewportStartDeferredDraw()) {
+		ViewportDrawChk(vp, left, top, right, bottom, INT_MAX);
+		return;
+	}
+
+	/* Split into a few parts per thread, so threads that finish early can help with the rest. */
+	int max_screen_area = max(area / (int)(4 * (_viewport_workers.GetThreads() + 1)), MIN_VIEWPORT_THREAD_AREA);
+	ViewportDrawChk(vp, left, top, right, bottom, max_screen_area);
+	ViewportFinishDeferredDraw(vp);
+}
+
+/** Sprites around the main viewport that are loaded before scrolling shows them. */
+struct ViewportPrefetcher {
+	int left;                           ///< Virtual left of the main viewport when collecting started.
+	int top;                            ///< Virtual top of the main viewport when collecting started.
+	int width;                          ///< Virtual width of the main viewport when collecting started.
+	int height;                         ///< Virtual height of the main viewport when collecting started.
+	ZoomLevel zoom;                     ///< Zoom level of the main viewport when collecting started.
+	uint part;                          ///< Next part of the border around the viewport to collect the sprites of.
+	SmallVector<SpriteID, 256> sprites; ///< Sprites of the last collected part.
+	uint next;                          ///< First sprite of #sprites that is not prefetched yet.
+};
+
+/** Number of parts the border around the viewport is collected in; two for every side. */
+static const uint PREFETCH_PARTS = 8;
+
+static ViewportPrefetcher _vp_prefetcher;
+
+/** Sort sprite numbers in ascending order. */
+static int CDECL SpriteIDSorter(const SpriteID *a, const SpriteID *b)
+{
+	return (*a > *b) - (*a < *b);
+}
+
+/**
+ * Collect the sprites #ViewportDoDraw would draw in an area, without loading any of them.
+ * @param vp      The viewport.
+ * @param left    Virtual left of the area.
+ * @param top     Virtual top of the area.
+ * @param right   Virtual right of the area.
+ * @param bottom  Virtual bottom of the area.
+ * @param sprites Vector to add each of the sprites to once.
+ */
+static void ViewportCollectSprites(const ViewPort *vp, int left, int top, int right, int bottom, SmallVector<SpriteID, 256> *sprites)
+{
+	DrawPixelInfo *old_dpi = _cur_dpi;
+	_cur_dpi = &_vd.dpi;
+
+	_vd.dpi.zoom = vp->zoom;
+	int mask = ScaleByZoom(-1, vp->zoom);
+
+	_vd.combine_sprites = SPRITE_COMBINE_NONE;
+
+	_vd.dpi.width = (right - left) & mask;
+	_vd.dpi.height = (bottom - top) & mask;
+	_vd.dpi.left = left & mask;
+	_vd.dpi.top = top & mask;
+	_vd.dpi.pitch = 0;
+	_vd.dpi.dst_ptr = NULL;
+	_vd.last_child = NULL;
+
+	_vd.prefetch = true;
+	ViewportAddLandscape();
+	ViewportAddVehicles(&_vd.dpi);
+	_vd.prefetch = false;
+
+	_cur_dpi = old_dpi;
+
+	for (const TileSpriteToDraw *ts = _vd.tile_sprites_to_draw.Begin(); ts != _vd.tile_sprites_to_draw.End(); ts++) {
+		*sprites->Append() = ts->image & SPRITE_MASK;
+	}
+	for (const ParentSpriteToDraw *ps = _vd.parent_sprites_to_draw.Begin(); ps != _vd.parent_sprites_to_draw.End(); ps++) {
+		if (ps->image != SPR_EMPTY_BOUNDING_BOX) *sprites->Append() = ps->image & SPRITE_MASK;
+	}
+	for (const ChildScreenSpriteToDraw *cs = _vd.child_screen_sprites_to_draw.Begin(); cs != _vd.child_screen_sprites_to_draw.End(); cs++) {
+		*sprites->Append() = cs->image & SPRITE_MASK;
+	}
+
+	_vd.string_sprites_to_draw.Clear();
+	_vd.tile_sprites_to_draw.Clear();
+	_vd.parent_sprites_to_draw.Clear();
+	_vd.child_screen_sprites_to_draw.Clear();
+
+	/* Most sprites are drawn many times; keep only one of each. */
+	uint n = sprites->Length();
+	if (n == 0) return;
+	SpriteID *ids = sprites->Begin();
+	QSortT(ids, n, &SpriteIDSorter);
+	uint unique = 1;
+	for (uint i = 1; i < n; i++) {
+		if (ids[i] != ids[unique - 1]) ids[unique++] = ids[i];
+	}
+	sprites->Resize(unique);
+}
+
+/**
+ * Load the sprites around the main viewport into the sprite cache, a bit
+ * at a time, so they do not need to be loaded while scrolling there. The
+ * border of a quarter of the viewport on every side is collected in parts,
+ * and the sprites of a part are prefetched in batches; a single part or
+ * batch is done per call. Prefetching uses the threads for drawing
+ * viewports and is disabled when there are none.
+ */
+void PrefetchViewportSprites()
+{
+	if (_settings_client.gui.viewport_threads == 0 || HasModalProgress() || _switch_mode != SM_NONE) return;
+
+	const Window *w = FindWindowById(WC_MAIN_WINDOW, 0);
+	if (w == NULL || w->viewport == NULL) return;
+	const ViewPort *vp = w->viewport;
+
+	ViewportPrefetcher *p = &_vp_prefetcher;
+	if (vp->zoom != p->zoom || vp->virtual_width != p->width || vp->virtual_height != p->height ||
+			abs(vp->virtual_left - p->left) > p->width / 8 || abs(vp->virtual_top - p->top) > p->height / 8) {
+		/* Moved too far from where we were collecting; start again around the new position. */
+		p->left = vp->virtual_left;
+		p->top = vp->virtual_top;
+		p->width = vp->virtual_width;
+		p->height = vp->virtual_height;
+		p->zoom = vp->zoom;
+		p->part = 0;
+		p->sprites.Clear();
+		p->next = 0;
+	}
+
+	if (p->next < p->sprites.Length()) {
+		p->next += PrefetchSprites(p->sprites.Get(p->next), p->sprites.Length() - p->next, _settings_client.gui.viewport_threads);
+		return;
+	}
+
+	if (p->part == PREFETCH_PARTS) return;
+
+	int margin_x = p->width / 4;
+	int margin_y = p->height / 4;
+	int left, top, right, bottom;
+	uint side = p->part / 2;
+	if (side < 2) {
+		/* Above or below the viewport, including the corners. */
+		left = p->left - margin_x;
+		right = p->left + p->width + margin_x;
+		top = side == 0 ? p->top - margin_y : p->top + p->height;
+		bottom = top + margin_y;
+		if (p->part % 2 == 0) {
+			right = (left + right) / 2;
+		} else {
+			left = (left + right) / 2;
+		}
+	} else {
+		/* Left or right of the viewport. */
+		left = side == 2 ? p->left - margin_x : p->left + p->width;
+		right = left + margin_x;
+		top = p->top;
+		bottom = p->top + p->height;
+		if (p->part % 2 == 0) {
+			bottom = (top + bottom) / 2;
+		} else {
+			top = (top + bottom) / 2;
+		}
+	}
+	p->part++;
+
+	p->sprites.Clear();
+	p->next = 0;
+	ViewportCollectSprites(vp, left, top, right, bottom, &p->sprites);
 }
 
 /**
@@ -3233,6 +3832,7 @@ struct ViewportSSCSS {
 
 /** List of sorters ordered from best to worst. */
 static ViewportSSCSS _vp_sprite_sorters[] = {
+	{ &ViewportSortParentSpritesSpatialChecker, &ViewportSortParentSpritesSpatial },
 #ifdef WITH_SSE
 	{ &ViewportSortParentSpritesSSE41Checker, &ViewportSortParentSpritesSSE41 },
 #endif
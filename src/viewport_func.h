@@ -65,6 +65,9 @@ void SetTileSelectSize(int w, int h);
 void SetTileSelectBigSize(int ox, int oy, int sx, int sy);
 
 void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom);
+bool ViewportStartDeferredDraw();
+void ViewportFinishDeferredDraw(const ViewPort *vp);
+void PrefetchViewportSprites();
 
 bool ScrollWindowToTile(TileIndex tile, Window *w, bool instant = false);
 bool ScrollWindowTo(int x, int y, int z, Window *w, bool instant = false);
@@ -51,6 +51,7 @@ static void GetTileDesc_Void(TileIndex tile, TileDesc *td)
 static void TileLoop_Void(TileIndex tile)
 {
 	/* not used */
+	SetTileLoopIdle(tile);
 }
 
 static void ChangeTileOwner_Void(TileIndex tile, Owner old_owner, Owner new_owner)
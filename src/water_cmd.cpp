@@ -39,6 +39,7 @@
 #include "company_base.h"
 #include "company_gui.h"
 #include "newgrf_generic.h"
+#include "genworld.h"
 
 #include "table/strings.h"
 
@@ -1154,6 +1155,9 @@ void TileLoop_Water(TileIndex tile)
 {
 	if (IsTileType(tile, MP_WATER)) AmbientSoundEffect(tile);
 
+	/* Water that is not coast does nothing, as long as all its neighbours are water too. */
+	bool idle = IsTileType(tile, MP_WATER) && !IsCoast(tile);
+
 	switch (GetFloodingBehaviour(tile)) {
 		case FLOOD_ACTIVE:
 			for (Direction dir = DIR_BEGIN; dir < DIR_END; dir++) {
@@ -1161,6 +1165,7 @@ void TileLoop_Water(TileIndex tile)
 				if (!IsValidTile(dest)) continue;
 				/* do not try to flood water tiles - increases performance a lot */
 				if (IsTileType(dest, MP_WATER)) continue;
+				idle = false;
 
 				/* TREE_GROUND_SHORE is the sign of a previous flood. */
 				if (IsTileType(dest, MP_TREES) && GetTreeGround(dest) == TREE_GROUND_SHORE) continue;
@@ -1173,6 +1178,7 @@ void TileLoop_Water(TileIndex tile)
 
 				DoFloodTile(dest);
 			}
+			if (idle) SetTileLoopIdle(tile);
 			break;
 
 		case FLOOD_DRYUP: {
@@ -1189,15 +1195,25 @@ void TileLoop_Water(TileIndex tile)
 			break;
 		}
 
-		default: return;
+		default:
+			/* Canals and rivers do not flood. */
+			if (idle) SetTileLoopIdle(tile);
+			return;
 	}
 }
 
-void ConvertGroundTilesIntoWaterTiles()
+/**
+ * Turn the clear tiles of a region at sea level into sea or shore. This only
+ * changes the tiles of the region, and only reads the heights of other tiles.
+ * @param param   Unused.
+ * @param y_begin The first row of the region.
+ * @param y_end   The row after the last row of the region.
+ */
+static void ConvertGroundTilesIntoWaterTilesRegion(void *param, uint y_begin, uint y_end)
 {
 	int z;
 
-	for (TileIndex tile = 0; tile < MapSize(); ++tile) {
+	for (TileIndex tile = TileXY(0, y_begin); tile < TileXY(0, y_end); ++tile) {
 		Slope slope = GetTileSlope(tile, &z);
 		if (IsTileType(tile, MP_CLEAR) && z == 0) {
 			/* Make both water for tiles at level 0
@@ -1231,6 +1247,11 @@ void ConvertGroundTilesIntoWaterTiles()
 	}
 }
 
+void ConvertGroundTilesIntoWaterTiles()
+{
+	GenerateWorldRegions(&ConvertGroundTilesIntoWaterTilesRegion, NULL, 0, MapSizeY());
+}
+
 static TrackStatus GetTileTrackStatus_Water(TileIndex tile, TransportType mode, uint sub_mode, DiagDirection side)
 {
 	static const byte coast_tracks[] = {0, 32, 4, 0, 16, 0, 0, 0, 8, 0, 0, 0, 0, 0, 0, 0};
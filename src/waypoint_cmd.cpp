@@ -270,6 +270,7 @@ CommandCost CmdBuildRailWaypoint(TileIndex start_tile, DoCommandFlag flags, uint
 
 			DeallocateSpecFromStation(wp, old_specindex);
 			YapfNotifyTrackLayoutChange(tile, AxisToTrack(axis));
+			InvalidateSignalBlocks(tile);
 		}
 		DirtyCompanyInfrastructureWindows(wp->owner);
 	}
@@ -3061,6 +3061,9 @@ void UpdateWindows()
 	NetworkDrawChatMessage();
 	/* Redraw mouse cursor in case it was hidden */
 	DrawMouseCursor();
+
+	/* Load a few of the sprites that are likely to be drawn soon. */
+	PrefetchViewportSprites();
 }
 
 /**